@@ -21,21 +21,72 @@
 #define ESP_ATMOD_H_
 
 #include <ESP8266WiFi.h>
+#include <CertStoreBearSSL.h>
+#include <bearssl/bearssl.h>
 
-//#define ETHERNET_CLASS LwipIntfDevPatch<Wiznet5500>
+#include "sendQueue.h"
+#include "asnDecode.h"
+#include "serialTx.h"
+
+//#define ETHERNET_CLASS LwipIntfDevPatch<Wiznet5500Int>
 #define ETHERNET_CS 5
 
 #ifdef ETHERNET_CLASS
 #include "LwipIntfDevPatch.h"
-#include <utility/w5500.h>
+#include "Wiznet5500Int.h"
 extern ETHERNET_CLASS Ethernet;
 #endif
 
+/*
+ * Constants
+ */
+
+const uint16_t INPUT_BUFFER_LEN = 200;
+
+const uint32_t PASSTHROUGH_PACKET_INTERVAL = 20; // Idle time [ms] closing a packet in the passthrough mode
+const uint32_t CIPSTART_DNS_TIMEOUT = 5000;		 // DNS timeout [ms] for AT+CIPSTART
+
+const uint32_t CIPSEND_MAX_LENGTH = 65536; // Maximum data length of AT+CIPSEND
+const uint16_t CIPSEND_CHUNK_SIZE = 1460;  // AT+CIPSEND data are written to the client in pieces of TCP MSS
+const uint16_t UDP_MAX_LENGTH = 2048;	   // Maximum datagram length of AT+CIPSEND, the datagram is kept in sendBuffer
+const uint8_t UDP_DATAGRAMS_PER_LOOP = 4;  // Maximum datagrams of a UDP link delivered in one loop() pass
+const uint16_t RECV_COALESCE_MAX_BYTES = 8192; // Maximum byte threshold of AT+CIPRECVCOALESCE
+const uint16_t RECV_COALESCE_MAX_TIME = 1000;  // Maximum hold time [ms] of AT+CIPRECVCOALESCE
+
+const uint16_t TCP_KEEPALIVE_MAX_IDLE = 7200;	  // Maximum TCP keep-alive idle time [s]
+const uint8_t TCP_KEEPALIVE_DEFAULT_INTERVAL = 1; // TCP keep-alive probe interval [s] (as the standard AT firmware)
+const uint8_t TCP_KEEPALIVE_DEFAULT_COUNT = 3;	  // TCP keep-alive probes before the link closes
+const uint16_t TCP_WRITE_TIMEOUT_MAX = 60000;	  // Maximum write timeout [ms] of AT+CIPTCPOPT
+const uint16_t TCP_WRITE_TIMEOUT_DEFAULT = 5000;  // Write timeout [ms] of WiFiClient in the core
+
+const uint16_t UART_RX_BUFFER_DEFAULT = 256; // Default size of the UART receive buffer (Arduino core default)
+const uint16_t UART_RX_BUFFER_MIN = 256;	 // Minimum size of the UART receive buffer (AT+UARTBUF)
+const uint16_t UART_RX_BUFFER_MAX = 16384;	 // Maximum size of the UART receive buffer (AT+UARTBUF)
+const uint8_t UART_RTS_THRESHOLD = 110;		 // RX FIFO level (max. 127) deasserting RTS
+
+const uint8_t IPD_HEADER_MAX = 64; // Longest +IPD or +CIPRECVDATA header
+
+const uint8_t ETH_SPI_CLOCK_DEFAULT = 4; // Default SPI clock of the Ethernet chip [MHz] (former SPI_CLOCK_DIV4)
+const uint8_t ETH_SPI_CLOCK_MAX = 33;	 // Maximum SPI clock of AT+CIPETHCFG [MHz] (W5500 specification)
+const uint32_t ETH_INT_PINS = (1 << 0) | (1 << 2) | (1 << 4); // GPIOs allowed for the INT pin of AT+CIPETHCFG
+
+#define CERT_STORE_DATA_FILE "/certs.ar"	 // DER certificates archive of the flash certificate store
+#define CERT_STORE_INDEX_FILE "/certs.idx" // Subject hash index of the archive, created at startup
+
+const uint16_t SSL_IN_OVERHEAD = 325; // BearSSL record overhead added to the TLS receive buffer (ssl_engine.c)
+const uint16_t SSL_OUT_OVERHEAD = 85; // BearSSL record overhead added to the TLS send buffer
+const uint16_t SSL_MFLN_AUTO_SIZE = 512; // TLS receive buffer of AT+CIPSSLSIZE=0 (auto) if the server supports MFLN
+
+const uint8_t MAX_LINKS = 5;		  // Number of links (clients[]), the link IDs are 0 to MAX_LINKS - 1
+const uint8_t SERVER_NONE = 255; // client_t.serverId of a link not accepted by a server
+
+static_assert(MAX_LINKS >= 1 && MAX_LINKS <= 127, "MAX_LINKS out of range"); // gsLinkIdReading and gsLinkIdConnecting are int8_t
+
 /*
  * Types
  */
 
-enum clientTypes_t
+enum clientTypes_t : uint8_t
 {
 	TYPE_TCP = 0,
 	TYPE_UDP,
@@ -43,15 +94,69 @@ enum clientTypes_t
 	TYPE_NONE = 99
 };
 
+/*
+ * The members are ordered by size, the structure takes 28 bytes per link
+ */
 typedef struct
 {
 	WiFiClient *client;
-	clientTypes_t type;
-	uint16_t sendLength;
-	uint16_t lastAvailableBytes;
+	sendQueue_t *sendQueue; // AT+CIPSENDBUF segments, allocated on the first use
+	uint32_t sendLength;
 	uint32_t lastActivityMillis;
+	uint32_t recvHoldMillis; // Start of holding the received data (AT+CIPRECVCOALESCE)
+	uint16_t lastAvailableBytes; // Bytes announced with CIPRECVMODE=1 or held with AT+CIPRECVCOALESCE
+	uint16_t sslBufferSize; // Size of the TLS receive buffer, 0 = not a TLS link
+	clientTypes_t type;
+	uint8_t serverId; // Index of the server in servers[] which accepted the link, or SERVER_NONE
+	bool sslResumed;  // TLS session was resumed
+	bool sendMulti;	  // Target of the running AT+CIPSENDMULTI, cleared when the link closes
+	bool sendMultiTarget; // Given to the running AT+CIPSENDMULTI, kept when the link closes for its SEND FAIL
 } client_t;
 
+typedef struct
+{
+	uint8_t sha256[32]; // SHA-256 fingerprint of the DER certificate
+	uint16_t length;	// Length of the DER certificate
+	uint16_t cnOffset;	// Offset of the CN (its length byte) in the DER certificate, 0 = no CN
+} certIndex_t;
+
+typedef struct
+{
+	uint16_t keepAliveIdle;	   // TCP keep-alive idle time [s], 0 = off
+	uint16_t writeTimeout;	   // Write timeout [ms], 0 = the core default
+	uint8_t keepAliveInterval; // TCP keep-alive probe interval [s]
+	uint8_t keepAliveCount;	   // TCP keep-alive probes
+	bool noDelay;			   // Nagle algorithm off
+	bool sync;				   // write() waits until the data are acknowledged
+	uint16_t recvCoalesceBytes; // Byte threshold of merging the received data (AT+CIPRECVCOALESCE), 0 = off
+	uint16_t recvCoalesceTime;	// Maximum hold time [ms] of the received data (AT+CIPRECVCOALESCE)
+} linkOptions_t;
+
+typedef struct
+{
+	uint8_t maxConn;  // Maximum connections of the server, 0 = only AT+CIPSERVERMAXCONN applies
+	uint32_t timeout; // Idle timeout [ms] of the server connections, 0 = AT+CIPSTO applies
+} serverConfig_t;
+
+enum linkConnectState_t
+{
+	LINK_CONNECT_DNS = 0,  // waiting for the DNS response
+	LINK_CONNECT_RESOLVED, // the remote host is resolved, connecting
+	LINK_CONNECT_DNS_FAIL  // DNS failed
+};
+
+typedef struct
+{
+	WiFiClient *client;
+	clientTypes_t type;
+	char remoteAddr[INPUT_BUFFER_LEN];
+	uint16_t remotePort;
+	uint32_t remoteIP;
+	volatile linkConnectState_t state;
+	uint32_t startMillis;
+	int32_t keepAlive; // TCP keep-alive idle time [s] of AT+CIPSTART, -1 = not given
+} linkConnect_t;
+
 typedef struct
 {
 	uint32_t ip;
@@ -72,25 +177,30 @@ const uint8_t CWDHCP_ETH = 4;
  * Globals
  */
 
-extern client_t clients[5];
+extern client_t clients[MAX_LINKS];
 
 extern const uint8_t SERVERS_COUNT;
 extern WiFiServer servers[];
-
-const uint16_t INPUT_BUFFER_LEN = 200;
+extern serverConfig_t serversConfig[]; // command AT+CIPSERVERCFG
+extern linkOptions_t linkOptions[MAX_LINKS]; // commands AT+CIPTCPOPT and AT+CIPRECVCOALESCE, for the TCP and SSL links
 
 extern uint8_t inputBuffer[INPUT_BUFFER_LEN]; // Input buffer
+extern uint8_t sendBuffer[UDP_MAX_LENGTH];	  // AT+CIPSEND data, passthrough data and the binary mode frames
 extern uint16_t inputBufferCnt;				  // Number of bytes in inputBuffer
 extern uint8_t fingerprint[20];				  // SHA-1 certificate fingerprint for TLS connections
 extern bool fingerprintValid;
 extern BearSSL::X509List *CAcert;   // CA certificate for TLS validation
+extern certIndex_t *certIndex;		  // Index of the CAcert certificates, in the same order
 extern size_t maximumCertificates; // Maximum amount of certificates to load
+extern BearSSL::CertStore certStore; // CA certificates in flash, loaded on demand during the handshake
+extern int certStoreCount;			  // Number of certificates in certStore
 
-extern char *PemCertificate;		 // Buffer for loading a certificate
-extern uint16_t PemCertificatePos;	 // Position in buffer while loading
+extern pemDecoder_t pemDecoder;	 // Decoder of the certificate loaded by AT+CIPSSLCERT
 extern uint16_t PemCertificateCount; // Number of chars read
 
 extern uint16_t dataRead; // Number of bytes read from the input to a send buffer
+extern uint32_t dataSent; // Number of bytes of AT+CIPSEND data already written to the client
+extern bool sendFailed;	  // Writing AT+CIPSEND data to the client failed
 
 /*
  * Global settings
@@ -103,27 +213,37 @@ extern uint8_t gsCwDhcp;		// command AT+CWDHCP
 extern bool gsFlag_Connecting;	// Connecting in progress
 extern bool gsFlag_Busy;		// Command is busy other commands ignored
 extern int8_t gsLinkIdReading;	// Link id for which are the data read
+extern uint16_t gsSendMultiLength; // Data length of the running AT+CIPSENDMULTI, 0 = not reading
+extern bool gsFlag_SendBuf;		// The data read go to the send queue (AT+CIPSENDBUF)
+extern int8_t gsLinkIdConnecting; // Link id which is being connected by AT+CIPSTART
 extern bool gsCertLoading;		// AT+CIPSSLCERT in progress
 extern bool gsWasConnected;		// Connection flag for AT+CIPSTATUS
+extern uint32_t gsHeapLowWatermark; // The lowest free heap seen by loop(), for AT+SYSHEAP
 extern bool gsEthConnected;		// track eth state for +ETH_ messages
 extern uint8_t gsCipSslAuth;	// command AT+CIPSSLAUTH: 0 = none, 1 = fingerprint, 2 = certificate chain
 extern uint8_t gsCipRecvMode;	// command AT+CIPRECVMODE
+extern uint8_t gsCipMode;		// command AT+CIPMODE: 0 = normal, 1 = passthrough
+extern bool gsFlag_Passthrough;	// Passthrough sending in progress (AT+CIPSEND in AT+CIPMODE=1)
+extern bool gsFlag_Binary;		// Binary framing mode (AT+CIPBINMODE=1)
 extern ipConfig_t gsCipStaCfg;	// command AT+CIPSTA_CUR
 extern dnsConfig_t gsCipDnsCfg; // command AT+CIPDNS
 extern ipConfig_t gsCipApCfg;	// command AT+CIPAP_CUR
 extern ipConfig_t gsCipEthCfg;	// command AT+CIPETH
 extern uint8_t gsCipEthMAC[6];	// command AT+CIPETHMAC
-extern uint16_t gsCipSslSize;	// command AT+CIPSSLSIZE
+extern uint16_t gsCipSslSize;	// command AT+CIPSSLSIZE, 0 = auto
 extern bool gsSTNPEnabled;		// command AT+CIPSNTPCFG
 extern int8_t gsSTNPTimezone;	// command AT+CIPSNTPCFG
 extern String gsSNTPServer[3];	// command AT+CIPSNTPCFG
 extern uint8_t gsServersMaxConn;	// command AT+CIPSERVERMAXCONN
 extern uint32_t gsServerConnTimeout;	// command AT+CIPSSTO
+extern uint32_t gsDnsCacheTtl;	// command AT+CIPDNSCACHE
+extern uint32_t gsScanCacheAge;	// command AT+CWLAPCACHE, 0 = every AT+CWLAP scans
+extern uint8_t gsUartFlowControl;	// command AT+UART_CUR: bit 0 = RTS, bit 1 = CTS
 
 extern const char APP_VERSION[];
 extern const char MSG_OK[] PROGMEM;
 extern const char MSG_ERROR[] PROGMEM;
-extern const uint16_t MAX_PEM_CERT_LENGTH;
+extern const uint16_t MAX_DER_CERT_LENGTH;
 
 /*
  * Public functions
@@ -134,7 +254,14 @@ void setDhcpMode();
 void configureEthernet();
 void setDns();
 bool applyCipAp();
+void setUartFlowControl(uint8_t flow);
+void applyLinkOptions(uint8_t linkId);
+void resetLinkOptions(uint8_t linkId);
 int SendData(int clientIndex, int maxSize);
+void stopPassthrough();
+void deleteCertificate(size_t number);
+bool startLinkConnect(uint8_t linkId, clientTypes_t type, WiFiClient *cli, const char *remoteAddr, uint16_t remotePort,
+					  int32_t keepAlive);
 
 const char *nullIfEmpty(String &s);
 
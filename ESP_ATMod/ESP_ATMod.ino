@@ -50,10 +50,38 @@
  * 0.4.0a: AT+CIPSTATUS lists SoftAP TCP connections [J.A]
  * 0.4.0b: AT+CIPDOMAIN implementation [J.A]
  * 0.5.0: support Ethernet AT+CIPETH, AT+CIPETHMAC, AT+CEHOSTNAME and modified AT+CWDHCP [J.A]
+ * 0.5.1: AT+CIPMODE, UART-WiFi passthrough mode with AT+CIPSEND and "+++"
+ * 0.5.2: AT+CIPSTART resolves the host asynchronously, other links are served while connecting
+ * 0.5.3: DNS cache for AT+CIPSTART, AT+CIPDOMAIN and AT+CIPSSLMFLN, AT+CIPDNSCACHE
+ * 0.5.4: TLS session resumption cache AT+CIPSSLSESS, resumption status in AT+CIPSSLSTA
+ * 0.5.4a: +IPD and +CIPRECVDATA data are streamed through a fixed buffer, no heap allocation
+ * 0.5.5: UART hardware flow control (AT+UART), UART receive buffer size AT+UARTBUF
+ * 0.5.6: AT+CIPSENDBUF and AT+CIPBUFSTATUS, per link send queue written in the background
+ * 0.5.7: AT+CIPSEND up to 65536 bytes, the data are written to the client while being received
+ * 0.5.8: UDP links in AT+CIPSTART, remote host of a datagram in AT+CIPSEND
+ * 0.5.8a: Links are serviced with one pass over the listening servers, fewer available() calls
+ * 0.5.9: Server of a link kept at accept time, AT+CIPSERVERCFG, server port in AT+CIPSTATUS
+ * 0.5.10: Settings cached in RAM and written after a quiet period, AT+SYSSAVE, versioned flash layout
+ * 0.5.11: Flash certificate store certs.ar, the trust anchors are read during the handshake
+ * 0.5.12: AT+CIPSSLCERT decodes the PEM data while receiving, certificates up to 8 kB DER
+ * 0.5.13: Certificate index with SHA-256 fingerprints, AT+CIPSSLCERT?FP
+ * 0.5.14: AT+CIPSSLSIZE=0 sizes the TLS buffer of each link by the cached MFLN support of the server
+ * 0.5.15: AT+SYSHEAP - heap fragmentation, low watermark, memory of the links and of the next TLS connection
+ * 0.5.16: AT+SYSPERF - cycle count histograms of loop(), commands, +IPD, writes and connects, counters
+ * 0.5.17: AT+SYSPERF measurement time
+ * 0.5.18: The number of links is set with MAX_LINKS, multi-digit link IDs, smaller link structure
+ * 0.5.19: AT+CIPRECVCOALESCE - merging the received data into fewer +IPD, +IPD header written at once
+ * 0.5.20: AT+CIPTCPOPT - per link TCP options (Nagle, sync write, write timeout, keep-alive), CIPSTART keep-alive
+ * 0.5.21: AT+SYSCPUFREQ=0 - CPU frequency governor raising the clock for TLS and bulk transfers, time at each frequency
+ * 0.5.22: AT+CIPBINMODE - binary SLIP framing of the data and control of all links
+ * 0.5.23: AT+CIPSENDMULTI - sending one payload to several links
+ * 0.5.24: AT+CWFASTJOIN - fast rejoin to the cached BSSID and channel, join time in WIFI GOT IP
+ * 0.5.25: AT+CWLAP in the background with the SSID, MAC and channel filter, AT+CWLAPCACHE
+ * 0.5.26: AT+CIPETHCFG - Ethernet SPI clock and W5500 INT pin, +ETH_ messages from the netif status callback
+ * 0.5.27: Serial output through a ring buffer drained from loop(), debug output to UART1 (AT_DEBUG_UART1)
  *
  * TODO:
  * - Implement AP mode DHCP settings and AT+CWLIF
- * - Implement UDP
  * - TLS Security - persistent fingerprint and single certificate, AT+CIPSSLAUTH_DEF
  */
 
@@ -77,6 +105,15 @@ extern "C"
 #include "settings.h"
 #include "debug.h"
 #include "asnDecode.h"
+#include "dnsCache.h"
+#include "sslSessionCache.h"
+#include "mflnCache.h"
+#include "perf.h"
+#include "cpuFreq.h"
+#include "binaryMode.h"
+#include "fastJoin.h"
+#include "scanCache.h"
+#include "udpClient.h"
 
 #ifdef ETHERNET_CLASS
 ETHERNET_CLASS Ethernet(ETHERNET_CS);
@@ -86,7 +123,7 @@ ETHERNET_CLASS Ethernet(ETHERNET_CS);
  * Defines
  */
 
-const char APP_VERSION[] = "0.5.0";
+const char APP_VERSION[] = "0.5.27";
 
 /*
  * Constants
@@ -95,7 +132,7 @@ const char APP_VERSION[] = "0.5.0";
 const char MSG_OK[] PROGMEM = "\r\nOK\r\n";
 const char MSG_ERROR[] PROGMEM = "\r\nERROR\r\n";
 
-const uint16_t MAX_PEM_CERT_LENGTH = 4096; // Maximum size of a certificate loaded by AT+CIPSSLCERT
+const uint16_t MAX_DER_CERT_LENGTH = 8192; // Maximum DER size of a certificate loaded by AT+CIPSSLCERT
 
 /*
  * Global variables
@@ -108,28 +145,37 @@ WiFiEventHandler onConnectedHandler;
 WiFiEventHandler onGotIPHandler;
 WiFiEventHandler onDisconnectedHandler;
 
-client_t clients[5] = {{nullptr, TYPE_NONE, 0, 0, 0},
-					   {nullptr, TYPE_NONE, 0, 0, 0},
-					   {nullptr, TYPE_NONE, 0, 0, 0},
-					   {nullptr, TYPE_NONE, 0, 0, 0},
-					   {nullptr, TYPE_NONE, 0, 0, 0}};
+client_t clients[MAX_LINKS]; // The type and serverId are initialized in setup()
+linkOptions_t linkOptions[MAX_LINKS]; // Initialized in setup()
 
 WiFiServer servers[] = {WiFiServer(0), WiFiServer(0), WiFiServer(0), WiFiServer(0), WiFiServer(0)};
 const uint8_t SERVERS_COUNT = sizeof(servers) / sizeof(WiFiServer);
+serverConfig_t serversConfig[] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
 
-uint8_t sendBuffer[2048];
+uint8_t sendBuffer[UDP_MAX_LENGTH];
+uint8_t recvBuffer[256]; // Chunk buffer for streaming the received data to the serial buffer
 uint16_t dataRead = 0; // Number of bytes read from the input to a send buffer
+uint32_t dataSent = 0; // Number of bytes of AT+CIPSEND data already written to the client
+bool sendFailed = false; // Writing AT+CIPSEND data to the client failed
+
+uint32_t passthroughLastRx = 0;	  // Time of the last byte received in the passthrough mode
+bool passthroughEscape = false;	  // The current passthrough packet started after an idle time
+
+linkConnect_t linkConnecting;	 // Connection in progress (AT+CIPSTART)
+uint32_t linkConnectSequence = 0; // Identifies the DNS request of the connection in progress
 
 // TLS specific variables
 
 uint8_t fingerprint[20]; // SHA-1 certificate fingerprint for TLS connections
 bool fingerprintValid;
 BearSSL::X509List *CAcert; // CA certificates for TLS validation
+certIndex_t *certIndex = nullptr; // Index of the CAcert certificates
 size_t maximumCertificates;
+BearSSL::CertStore certStore;
+int certStoreCount = 0;
 
-char *PemCertificate = nullptr; // Buffer for loading a certificate
-uint16_t PemCertificatePos;		// Position in buffer while loading
-uint16_t PemCertificateCount;	// Number of chars read
+pemDecoder_t pemDecoder;	  // Decoder of the certificate loaded by AT+CIPSSLCERT
+uint16_t PemCertificateCount; // Number of chars read
 
 /*
  *  Global settings
@@ -141,28 +187,51 @@ uint8_t gsCwDhcp = CWDHCP_AP | CWDHCP_STA;	// command AT+CWDHCP
 bool gsFlag_Connecting = false;		// Connecting in progress
 bool gsFlag_Busy = false;			// Command is busy other commands will be ignored
 int8_t gsLinkIdReading = -1;		// Link id where the data is read
+uint16_t gsSendMultiLength = 0;		// Data length of the running AT+CIPSENDMULTI, 0 = not reading
+bool gsFlag_SendBuf = false;		// The data read go to the send queue (AT+CIPSENDBUF)
+int8_t gsLinkIdConnecting = -1;		// Link id which is being connected
 bool gsCertLoading = false;			// AT+CIPSSLCERT in progress
 bool gsWasConnected = false;		// Connection flag for AT+CIPSTATUS
+uint32_t gsHeapLowWatermark = UINT32_MAX; // The lowest free heap seen by loop(), for AT+SYSHEAP
 bool gsEthConnected = false;		// track eth state for +ETH_ messages
 IPAddress gsEthLastIP;				// for +ETH_GOT_IP message
+bool gsEthStatusChanged = true;		// Set by the netif status callback, the +ETH_ messages are checked
 uint8_t gsCipSslAuth = 0;			// command AT+CIPSSLAUTH: 0 = none, 1 = fingerprint, 2 = certificate chain
 uint8_t gsCipRecvMode = 0;			// command AT+CIPRECVMODE
+uint8_t gsCipMode = 0;				// command AT+CIPMODE
+bool gsFlag_Passthrough = false;	// Passthrough sending in progress
+bool gsFlag_Binary = false;			// Binary framing mode (AT+CIPBINMODE=1)
 ipConfig_t gsCipStaCfg = {0, 0, 0}; // command AT+CIPSTA
 dnsConfig_t gsCipDnsCfg = {0, 0};	// command AT+CIPDNS
 ipConfig_t gsCipApCfg = {0, 0, 0}; // command AT+CIPAP
 ipConfig_t gsCipEthCfg = {0, 0, 0};	// command AT+CIPETH
 uint8_t gsCipEthMAC[6] = {0, 0, 0, 0, 0, 0};	// command AT+CIPETHMAC
-uint16_t gsCipSslSize = 16384;		// command AT+CIPSSLSIZE
+uint16_t gsCipSslSize = 16384;		// command AT+CIPSSLSIZE, 0 = auto
 bool gsSTNPEnabled = true;			// command AT+CIPSNTPCFG
 int8_t gsSTNPTimezone = 0;			// command AT+CIPSNTPCFG
 String gsSNTPServer[3];				// command AT+CIPSNTPCFG
-uint8_t gsServersMaxConn = 5;			// command AT+CIPSERVERMAXCONN
+uint8_t gsServersMaxConn = MAX_LINKS;	// command AT+CIPSERVERMAXCONN
 uint32_t gsServerConnTimeout = 180000;	// command AT+CIPSSTO
+uint32_t gsDnsCacheTtl = 300;			// command AT+CIPDNSCACHE
+uint32_t gsScanCacheAge = 0;			// command AT+CWLAPCACHE, 0 = every AT+CWLAP scans
+uint8_t gsUartFlowControl = 0;			// command AT+UART_CUR: bit 0 = RTS, bit 1 = CTS
 
 /*
  * Local prototypes
  */
-static bool checkCertificateDuplicatesAndLoad(BearSSL::X509List &importCertList);
+static bool checkCertificateDuplicatesAndLoad(const uint8_t *der, size_t length);
+static void readPassthroughData();
+static void sendPassthroughPacket();
+static void processLinkConnecting();
+static bool connectLink(WiFiClient *cli);
+static bool recvCoalesceHold(uint8_t linkId, int avail);
+static void printLinkMessage(uint8_t linkId, const char *format, ...);
+static void printLinkClosed(uint8_t linkId);
+static void sendMultiData();
+static void dnsFoundCallback(const char *name, const ip_addr_t *ipaddr, void *arg);
+#ifdef ETHERNET_CLASS
+static void ethStatusCallback();
+#endif
 
 /*
  *  The setup function is called once at startup of the sketch
@@ -173,6 +242,15 @@ void setup()
 	// For core pre 3.x please comment the next line out otherwise the compilation will fail
 	enableWiFiAtBootTime();
 
+	// Links
+	for (uint8_t i = 0; i < MAX_LINKS; ++i)
+	{
+		clients[i].type = TYPE_NONE;
+		clients[i].serverId = SERVER_NONE;
+
+		resetLinkOptions(i);
+	}
+
 	// Default static net configuration
 	gsCipStaCfg = Settings::getNetConfig();
 
@@ -201,14 +279,31 @@ void setup()
 	// Default UART configuration
 	uint32_t baudrate = Settings::getUartBaudRate();
 	SerialConfig config = Settings::getUartConfig();
+	Serial.setRxBufferSize(Settings::getUartRxBufferSize());
 	Serial.begin(baudrate, config);
+	setUartFlowControl(Settings::getUartFlowControl());
+
+#if defined(AT_DEBUG) && defined(AT_DEBUG_UART1)
+	// Debug output on GPIO2, separate from the AT responses
+	Serial1.begin(115200);
+#endif
 
 #ifdef ETHERNET_CLASS
 	SPI.begin();
-	SPI.setClockDivider(SPI_CLOCK_DIV4);
+	SPI.setFrequency(Settings::getEthSpiClock() * 1000000L);
 	SPI.setBitOrder(MSBFIRST);
 	SPI.setDataMode(SPI_MODE0);
 
+	int8_t ethIntPin = Settings::getEthIntPin();
+
+#if defined(AT_DEBUG) && defined(AT_DEBUG_UART1)
+	// A saved GPIO2 would take the UART1 debug output
+	if (ethIntPin == 2)
+		ethIntPin = -1;
+#endif
+
+	Ethernet.setInterruptPin(ethIntPin);
+
 	gsCipEthCfg = Settings::getEthIpConfig();
 	configureEthernet();
 #endif
@@ -230,6 +325,9 @@ void setup()
 	WiFi.persistent(false);
 	WiFi.setAutoReconnect(true);
 
+	// Restart the boot autoconnect directed to the cached access point
+	fastJoinAutoConnect();
+
 	// Set the SNTP defaults
 	gsSNTPServer[0] = "pool.ntp.org";
 	gsSNTPServer[1] = "time.nist.gov";
@@ -244,6 +342,19 @@ void setup()
 	// Load certificates from LittleFS
 	if (LittleFS.begin())
 	{
+		// The certificate archive is only indexed, a certificate is read from flash when a server chains to it
+		if (LittleFS.exists(CERT_STORE_DATA_FILE))
+		{
+			certStoreCount = certStore.initCertStore(LittleFS, CERT_STORE_INDEX_FILE, CERT_STORE_DATA_FILE);
+
+			if (certStoreCount <= 0)
+			{
+				certStoreCount = 0;
+				SerialTx.printf_P(PSTR("\nFailed to index %s"), CERT_STORE_DATA_FILE);
+				SerialTx.printf_P(MSG_ERROR);
+			}
+		}
+
 		// Open dir folder
 		Dir dir = LittleFS.openDir("/");
 
@@ -253,13 +364,17 @@ void setup()
 			// Get filename
 			String filename = dir.fileName();
 
+			// Skip the certificate store files
+			if (filename.equals(CERT_STORE_DATA_FILE + 1) || filename.equals(CERT_STORE_INDEX_FILE + 1))
+				continue;
+
 			size_t originalCertCount = CAcert->getCount();
 
 			// Check if maximum certificates has not been reached yet
 			if (originalCertCount >= maximumCertificates)
 			{
-				Serial.printf_P(PSTR("\nCould not load %s. Reached the maximum of %d certificates"), filename.c_str(), maximumCertificates);
-				Serial.printf_P(MSG_ERROR);
+				SerialTx.printf_P(PSTR("\nCould not load %s. Reached the maximum of %d certificates"), filename.c_str(), maximumCertificates);
+				SerialTx.printf_P(MSG_ERROR);
 			}
 			else
 			{
@@ -273,54 +388,66 @@ void setup()
 
 						if (!file)
 						{
-							Serial.printf_P("\nFailed to open file for reading");
-							Serial.printf_P(MSG_ERROR);
+							SerialTx.printf_P("\nFailed to open file for reading");
+							SerialTx.printf_P(MSG_ERROR);
 							return;
 						}
 
-						// Read file content
-						String fileContent = "";
-						while (file.available())
+						// Read file content at once
+						size_t fileSize = file.size();
+						char *fileContent = new char[fileSize + 1];
+
+						if (fileContent == nullptr)
 						{
-							fileContent += (char)file.read();
+							file.close();
+
+							SerialTx.printf_P(PSTR("\nOut of memory loading %s"), filename.c_str());
+							SerialTx.printf_P(MSG_ERROR);
+							continue;
 						}
 
+						fileContent[file.read((uint8_t *)fileContent, fileSize)] = '\0';
+
 						file.close();
 
 						// Append certificate to seperate X509List
 						BearSSL::X509List importCertList;
-						importCertList.append(fileContent.c_str());
+						importCertList.append(fileContent);
+
+						delete[] fileContent;
 
 						if (importCertList.getCount() != 1)
 						{
-							Serial.printf_P(PSTR("\nFailed to add %s to the certificates list"), filename.c_str());
-							Serial.printf_P(MSG_ERROR);
+							SerialTx.printf_P(PSTR("\nFailed to add %s to the certificates list"), filename.c_str());
+							SerialTx.printf_P(MSG_ERROR);
 							return;
 						}
 
-						if (checkCertificateDuplicatesAndLoad(importCertList))
+						const br_x509_certificate *importedCert = &(importCertList.getX509Certs()[0]);
+
+						if (checkCertificateDuplicatesAndLoad(importedCert->data, importedCert->data_len))
 						{
-							Serial.println(F("\nTried to load already existing certificate"));
-							Serial.printf_P(MSG_ERROR);
+							SerialTx.println(F("\nTried to load already existing certificate"));
+							SerialTx.printf_P(MSG_ERROR);
 						}
 						else if (CAcert->getCount() == originalCertCount)
 						{
-							Serial.printf_P(PSTR("\nFailed to add %s to the certificates list"), filename.c_str());
-							Serial.printf_P(MSG_ERROR);
+							SerialTx.printf_P(PSTR("\nFailed to add %s to the certificates list"), filename.c_str());
+							SerialTx.printf_P(MSG_ERROR);
 						}
 					}
 					else
 					{
-						Serial.printf_P(PSTR("\n%s is empty"), filename.c_str());
-						Serial.printf_P(MSG_ERROR);
+						SerialTx.printf_P(PSTR("\n%s is empty"), filename.c_str());
+						SerialTx.printf_P(MSG_ERROR);
 					}
 				}
 				else
 				{
 					if (strcmp(filename.c_str(), ".gitkeep"))
 					{
-						Serial.printf_P(PSTR("\n%s is not a .pem file"), filename.c_str());
-						Serial.printf_P(MSG_ERROR);
+						SerialTx.printf_P(PSTR("\n%s is not a .pem file"), filename.c_str());
+						SerialTx.printf_P(MSG_ERROR);
 					}
 				}
 			}
@@ -328,11 +455,11 @@ void setup()
 	}
 	else
 	{
-		Serial.printf_P("\nInizializing FS failed.");
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P("\nInizializing FS failed.");
+		SerialTx.printf_P(MSG_ERROR);
 	}
 
-	Serial.println(F("\r\nready"));
+	SerialTx.println(F("\r\nready"));
 }
 
 /*
@@ -342,91 +469,149 @@ void loop()
 {
 	bool lineCompleted = false;
 
+	PERF_START(loopStart);
+
+#if defined(AT_PERF)
+	if (Serial.hasOverrun())
+		PERF_COUNT(PERF_UART_OVERRUN);
+#endif
+
+	// Note: sampled once per loop, the transient peaks inside a call (e.g. TLS handshake) are not seen
+	uint32_t freeHeap = ESP.getFreeHeap();
+	if (freeHeap < gsHeapLowWatermark)
+		gsHeapLowWatermark = freeHeap;
+
+	// Move the buffered output to the UART as far as its FIFO takes it
+	SerialTx.process();
+
 	// Check for data and closed connections - only when we can transmit data
 
-	if (Serial.availableForWrite())
+	if (SerialTx.availableForWrite())
 	{
 		uint8_t maxCli = 0; // Maximum client number
 		if (gsCipMux == 1)
-			maxCli = 4;
+			maxCli = MAX_LINKS - 1;
 
 		uint8_t freeLinkId = 255;
 		uint8_t serversConnCount = 0;
+		uint8_t serverConnCount[SERVERS_COUNT] = {0}; // Connections of each server
 
 		for (uint8_t i = 0; i <= maxCli; ++i)
 		{
 			WiFiClient *cli = clients[i].client;
+			int avail = 0;
 
 			if (cli != nullptr)
 			{
-				int avail = cli->available();
+				// Note: available() is expensive for TLS links (it runs the TLS engine), it is called
+				//       again only if the data were read
+				avail = cli->available();
 
-				if (avail > clients[i].lastAvailableBytes) // For RECVMODE it is every non zero avail
-				{
+				if (avail > clients[i].lastAvailableBytes)
 					clients[i].lastActivityMillis = millis();
 
-					if (gsCipRecvMode == 0)
+				if (gsCipRecvMode == 0 || gsCipMode == 1)
+				{
+					// Small segments are held until the byte threshold or the hold time is reached
+					if (avail > 0 && recvCoalesceHold(i, avail))
 					{
-						SendData(i, 0);
+						clients[i].lastAvailableBytes = avail;
 					}
-					else // CIPRECVMODE = 1
+					else if (avail > 0)
 					{
-						clients[i].lastAvailableBytes = avail;
+						clients[i].lastAvailableBytes = 0;
 
-						Serial.print(F("\r\n+IPD,"));
+						if (gsFlag_Binary)
+							binModeSendData(i);
+						else
+							SendData(i, 0);
 
-						if (gsCipMux == 1)
+						// Deliver the queued datagrams of a burst in one pass, each in its own +IPD
+						for (uint8_t n = 1; clients[i].type == TYPE_UDP && n < UDP_DATAGRAMS_PER_LOOP && cli->available() > 0; ++n)
 						{
-							Serial.print(i);
-							Serial.print(',');
+							if (gsFlag_Binary)
+								binModeSendData(i);
+							else
+								SendData(i, 0);
 						}
 
-						Serial.println(avail);
+						avail = cli->available();
 					}
 				}
-
-				if (cli->available() == 0 && !cli->connected())
+				else if (avail > clients[i].lastAvailableBytes) // CIPRECVMODE = 1, for every new data
 				{
+					clients[i].lastAvailableBytes = avail;
+
 					if (gsCipMux == 1)
-						Serial.printf_P(PSTR("%d,"), i);
+						SerialTx.printf_P(PSTR("\r\n+IPD,%d,%d\r\n"), i, avail);
+					else
+						SerialTx.printf_P(PSTR("\r\n+IPD,%d\r\n"), avail);
+				}
+
+				// Write the queued AT+CIPSENDBUF segments
+				if (clients[i].sendQueue != nullptr)
+				{
+					int32_t seq;
+
+#if defined(AT_PERF)
+					uint16_t queueFree = sendQueueFree(clients[i].sendQueue);
+#endif
+					if (clients[i].type == TYPE_SSL && sendQueueSegments(clients[i].sendQueue) > 0)
+						cpuFreqBoost();
+
+					PERF_START(writeStart);
+
+					while ((seq = sendQueueTransmit(clients[i].sendQueue, cli)) > 0)
+					{
+						clients[i].lastActivityMillis = millis();
+						printLinkMessage(i, PSTR("%d,SEND OK\r\n"), seq);
+					}
+
+					PERF_STOP(PERF_CLIENT_WRITE, writeStart);
+
+					// The link is closed after a write error, the following segments fail as well
+					while (seq < 0)
+					{
+						printLinkMessage(i, PSTR("%d,SEND FAIL\r\n"), -seq);
+
+						if (cli->connected())
+							cli->stop();
+
+						seq = sendQueueTransmit(clients[i].sendQueue, cli);
+					}
 
-					Serial.println(F("CLOSED"));
+					PERF_LINK_OUT(i, sendQueueFree(clients[i].sendQueue) - queueFree); // sent or dropped
+				}
+
+				if (avail == 0 && !cli->connected())
+				{
+					printLinkClosed(i);
 
 					DeleteClient(i);
 					cli = nullptr;
 				}
 			}
 
-			if (cli != nullptr)
+			if (cli != nullptr && clients[i].serverId != SERVER_NONE)
 			{
-				boolean isServer = false;
-				for (uint8_t j = 0; j < SERVERS_COUNT; ++j)
+				uint8_t serverId = clients[i].serverId;
+				uint32_t timeout = serversConfig[serverId].timeout;
+
+				if (timeout == 0)
+					timeout = gsServerConnTimeout;
+
+				if (timeout != 0 && avail == 0 && millis() - clients[i].lastActivityMillis > timeout)
 				{
-					if (servers[j].status() == CLOSED)
-						continue;
-					if (cli->localPort() == servers[j].port())
-					{
-						isServer = true;
-						break;
-					}
+					printLinkClosed(i);
+					DeleteClient(i);
 				}
-				if (isServer)
+				else
 				{
-					if (gsServerConnTimeout != 0 && cli->available() == 0
-							&& millis() - clients[i].lastActivityMillis > gsServerConnTimeout)
-					{
-						if (gsCipMux == 1)
-							Serial.printf_P(PSTR("%d,"), i);
-						Serial.println(F("CLOSED"));
-						DeleteClient(i);
-					}
-					else
-					{
-						serversConnCount++;
-					}
+					serversConnCount++;
+					serverConnCount[serverId]++;
 				}
 			}
-			else if (freeLinkId == 255)
+			else if (cli == nullptr && freeLinkId == 255 && i != gsLinkIdConnecting)
 			{
 				freeLinkId = i;
 			}
@@ -437,6 +622,8 @@ void loop()
 		{
 			if (freeLinkId == 255 || serversConnCount >= gsServersMaxConn)
 				break;
+			if (serversConfig[i].maxConn != 0 && serverConnCount[i] >= serversConfig[i].maxConn)
+				continue;
 			if (servers[i].status() == CLOSED)
 				continue;
 			// WiFiClient cli = servers[i].available();  // Use for older cores where the function accept() doesn't exist
@@ -447,14 +634,21 @@ void loop()
 			clients[freeLinkId].type = TYPE_TCP;
 			clients[freeLinkId].lastAvailableBytes = 0;
 			clients[freeLinkId].lastActivityMillis = millis();
-			Serial.printf_P(PSTR("%d,CONNECT\r\n"), freeLinkId);
+			clients[freeLinkId].serverId = i;
+			applyLinkOptions(freeLinkId);
+
+			if (gsFlag_Binary)
+				binModeSendFrame(freeLinkId, BIN_CONNECT, nullptr, 0);
+			else
+				SerialTx.printf_P(PSTR("%d,CONNECT\r\n"), freeLinkId);
 			gsWasConnected = true; // Flag for CIPSTATUS command
 
 			serversConnCount++;
+			serverConnCount[i]++;
 			freeLinkId = 255;
 			for (uint8_t j = 0; j <= maxCli; ++j)
 			{
-				if (clients[j].client == nullptr)
+				if (clients[j].client == nullptr && j != gsLinkIdConnecting)
 				{
 					freeLinkId = j;
 					break;
@@ -462,33 +656,42 @@ void loop()
 			}
 		}
 #ifdef ETHERNET_CLASS
-		if (gsEthConnected != netif_is_up(Ethernet.getNetIf()))
+		if (gsEthStatusChanged)
 		{
-			gsEthConnected = netif_is_up(Ethernet.getNetIf());
-			if (gsEthConnected)
-			{
-				Serial.println(F("+ETH_CONNECTED"));
-			}
-			else
+			gsEthStatusChanged = false;
+
+			if (gsEthConnected != netif_is_up(Ethernet.getNetIf()))
 			{
-				Serial.println(F("+ETH_DISCONNECTED"));
+				gsEthConnected = netif_is_up(Ethernet.getNetIf());
+				if (gsEthConnected)
+				{
+					SerialTx.print(F("+ETH_CONNECTED\r\n"));
+				}
+				else
+				{
+					SerialTx.print(F("+ETH_DISCONNECTED\r\n"));
+				}
 			}
-		}
-		if (Ethernet.localIP().isSet() && gsEthLastIP != Ethernet.localIP())
-		{
-			gsEthLastIP = Ethernet.localIP();
-			if (gsEthLastIP.isSet())
+			if (Ethernet.localIP().isSet() && gsEthLastIP != Ethernet.localIP())
 			{
-				Serial.print(F("+ETH_GOT_IP=\""));
-				Serial.print(gsEthLastIP);
-				Serial.println('"');
+				gsEthLastIP = Ethernet.localIP();
+				if (gsEthLastIP.isSet())
+					SerialTx.printf_P(PSTR("+ETH_GOT_IP=\"%s\"\r\n"), gsEthLastIP.toString().c_str());
 			}
 		}
 #endif
 	}
 
+	// In the passthrough mode, the serial port data go directly to the send buffer
+	if (gsFlag_Passthrough)
+		readPassthroughData();
+
+	// In the binary mode, the serial port carries only frames
+	if (gsFlag_Binary)
+		binModeInput();
+
 	// Read the serial port into the input or send buffer
-	int avail = Serial.available();
+	int avail = (gsFlag_Passthrough || gsFlag_Binary) ? 0 : Serial.available();
 	while (avail > 0)
 	{
 		// Check for EOF and errors
@@ -498,118 +701,132 @@ void loop()
 
 		c = Serial.read() & 0xff;
 
-		if (gsLinkIdReading >= 0)
+		if (gsSendMultiLength > 0)
+		{
+			// AT+CIPSENDMULTI: the data are written to all targets when complete
+			sendBuffer[dataRead++] = c;
+
+			if (dataRead >= gsSendMultiLength)
+				sendMultiData();
+		}
+		else if (gsLinkIdReading >= 0 && gsFlag_SendBuf)
 		{
-			sendBuffer[dataRead] = c;
+			sendQueue_t *queue = clients[gsLinkIdReading].sendQueue;
+
+			sendQueuePut(queue, c);
 
 			if (++dataRead >= clients[gsLinkIdReading].sendLength)
 			{
-				Serial.printf_P(PSTR("\r\nRecv %d bytes\r\n"), clients[gsLinkIdReading].sendLength);
+				SerialTx.printf_P(PSTR("\r\nRecv %d bytes\r\n"), clients[gsLinkIdReading].sendLength);
+
+				// The segment is sent from the queue later, the host doesn't wait
+				sendQueueCommit(queue);
+
+				// Stop data reading
+				gsLinkIdReading = -1;
+				gsFlag_SendBuf = false;
+				dataRead = 0;
+			}
+		}
+		else if (gsLinkIdReading >= 0)
+		{
+			client_t *link = &(clients[gsLinkIdReading]);
+
+			sendBuffer[dataRead++] = c;
+
+			bool lastByte = (dataSent + dataRead >= link->sendLength);
+
+			// Write the data to the client in segment sized pieces while the rest is still coming
+			// A UDP datagram is written at once
+			if ((dataRead >= CIPSEND_CHUNK_SIZE && link->type != TYPE_UDP) || lastByte)
+			{
+				if (link->type == TYPE_SSL)
+					cpuFreqBoost();
+
+				PERF_START(writeStart);
 
-				// Send the data to the client
-				size_t s = clients[gsLinkIdReading].client->write(sendBuffer, clients[gsLinkIdReading].sendLength);
+				if (!sendFailed && link->client->write(sendBuffer, dataRead) != dataRead)
+					sendFailed = true; // Read the rest of the data anyway
 
-				if (s == clients[gsLinkIdReading].sendLength)
+				PERF_STOP(PERF_CLIENT_WRITE, writeStart);
+				PERF_LINK_OUT(gsLinkIdReading, dataRead);
+
+				dataSent += dataRead;
+				dataRead = 0;
+			}
+
+			if (lastByte)
+			{
+				SerialTx.printf_P(PSTR("\r\nRecv %d bytes\r\n"), link->sendLength);
+
+				if (!sendFailed)
 				{
-					Serial.println(F("\r\nSEND OK"));
-					clients[gsLinkIdReading].lastActivityMillis = millis();
+					SerialTx.println(F("\r\nSEND OK"));
+					link->lastActivityMillis = millis();
 				}
 				else
 				{
-					Serial.println(F("\r\nSEND FAIL"));
-					if (clients[gsLinkIdReading].client->connected())
-						clients[gsLinkIdReading].client->stop();
+					SerialTx.println(F("\r\nSEND FAIL"));
+					if (link->client->connected())
+						link->client->stop();
 				}
 
 				// Stop data reading
 				gsLinkIdReading = -1;
 				dataRead = 0;
+				dataSent = 0;
+				sendFailed = false;
 			}
 		}
 		else if (gsCertLoading)
 		{
 			++PemCertificateCount;
 
+			// The PEM text is decoded as it comes, only the DER certificate is kept in memory
+			pemResult_t res = PEM_INVALID; // illegal character in certificate
+
 			if (isAlphaNumeric(c) || strchr("/+= -\\\r\n", c) != nullptr)
+				res = pemDecoderPut(&pemDecoder, c);
+			else if (c < ' ')
+				res = PEM_MORE;
+
+			if (res == PEM_DONE)
 			{
-				// Check newlines - the header and footer must be separated by at least one '\n' from the base64 certificate data
-				if (c == '\r')
-					c = '\n';
-				else if (c == 'n' && PemCertificatePos > 0 && PemCertificate[PemCertificatePos - 1] == '\\')
+				SerialTx.printf_P(PSTR("\r\nRead %d bytes\r\n"), PemCertificateCount);
+
+				gsCertLoading = false;
+
+				size_t originalCertCount = CAcert->getCount();
+
+				if (checkCertificateDuplicatesAndLoad(pemDecoder.der, pemDecoder.derLength))
 				{
-					// Create real backslash from separate characters '\' and 'n'
-					c = '\n';
-					--PemCertificatePos;
+					SerialTx.println(F("Tried to load already existing certificate"));
+					SerialTx.printf_P(MSG_ERROR);
 				}
-
-				// Ignore multiple newlines, save space in the buffer
-				if (c != '\n' || (PemCertificatePos > 0 && PemCertificate[PemCertificatePos - 1] != '\n'))
+				else if (CAcert->getCount() == (originalCertCount + 1))
 				{
-					PemCertificate[PemCertificatePos++] = c;
-
-					// Check the end
-					if (c == '-' && PemCertificatePos > 100)
-					{
-						if (!memcmp_P(PemCertificate + PemCertificatePos - 25, PSTR("-----END CERTIFICATE-----"), 25))
-						{
-							Serial.printf_P(PSTR("\r\nRead %d bytes\r\n"), PemCertificateCount);
-
-							// Process the certificate
-							PemCertificate[PemCertificatePos] = '\0';
-
-							size_t originalCertCount = CAcert->getCount();
-
-							// Append certificate to seperate X509List
-							BearSSL::X509List importCertList;
-							importCertList.append(PemCertificate);
-
-							if (importCertList.getCount() != 1)
-							{
-								Serial.println(F("Loading certificate failed"));
-								Serial.printf_P(MSG_ERROR);
-								return;
-							}
-
-							delete PemCertificate;
-							PemCertificate = nullptr;
-							PemCertificatePos = 0;
-
-							gsCertLoading = false;
-
-							if (checkCertificateDuplicatesAndLoad(importCertList))
-							{
-								Serial.println(F("Tried to load already existing certificate"));
-								Serial.printf_P(MSG_ERROR);
-							}
-							else if (CAcert->getCount() == (originalCertCount + 1))
-							{
-								Serial.printf_P(MSG_OK);
-							}
-							else
-							{
-								Serial.println(F("no certificate"));
-								Serial.printf_P(MSG_ERROR);
-							}
-						}
-					}
-					if (PemCertificatePos > MAX_PEM_CERT_LENGTH - 1)
-					{
-						gsCertLoading = false;
-						Serial.printf_P(MSG_ERROR); // Invalid data
-					}
+					SerialTx.printf_P(MSG_OK);
+				}
+				else
+				{
+					SerialTx.println(F("Loading certificate failed"));
+					SerialTx.printf_P(MSG_ERROR);
 				}
 			}
-			else if (c < ' ')
-			{
-			}
-			else // illegal character in certificate
+			else if (res != PEM_MORE)
 			{
 				gsCertLoading = false;
-				Serial.printf_P(MSG_ERROR); // Invalid data
+
+				if (res == PEM_OOM)
+					SerialTx.println(F("out of mem"));
+
+				SerialTx.printf_P(MSG_ERROR); // Invalid data
 			}
 
 			if (!gsCertLoading)
 			{
+				pemDecoderFree(&pemDecoder);
+
 				// Read everything left before continuing
 				while (Serial.available() > 0)
 				{
@@ -621,7 +838,7 @@ void loop()
 		else if (inputBufferCnt < INPUT_BUFFER_LEN)
 		{
 			if (gsEchoEnabled)
-				Serial.write(c);
+				SerialTx.write(c);
 
 			/*			if (inputBufferCnt == 0 && c != 'A')  // Wait for 'A' as the start of the command
 			{}
@@ -640,14 +857,18 @@ void loop()
 		else
 		{
 			inputBufferCnt = 0;
-			Serial.printf_P(MSG_ERROR); // Buffer overflow
+			SerialTx.printf_P(MSG_ERROR); // Buffer overflow
+			PERF_COUNT(PERF_INPUT_OVERFLOW);
 		}
 
 		yield();
 	}
 
+	// Is the directed join falling back to the full scan? Then the status is not final.
+	bool fastJoining = fastJoinProcess();
+
 	// Are we connecting now?
-	if (gsFlag_Connecting)
+	if (gsFlag_Connecting && !fastJoining)
 	{
 		station_status_t status = wifi_station_get_connect_status();
 
@@ -664,7 +885,7 @@ void loop()
 		switch (status)
 		{
 		case STATION_GOT_IP:
-			Serial.println(F("\r\nOK"));
+			SerialTx.println(F("\r\nOK"));
 			gsFlag_Connecting = false;
 			gsFlag_Busy = false;
 
@@ -682,19 +903,19 @@ void loop()
 			break;
 
 		case STATION_NO_AP_FOUND:
-			Serial.println(F("\r\n+CWJAP:3\r\nFAIL"));
+			SerialTx.println(F("\r\n+CWJAP:3\r\nFAIL"));
 			gsFlag_Connecting = false;
 			gsFlag_Busy = false;
 			break;
 
 		case STATION_CONNECT_FAIL:
-			Serial.println(F("\r\n+CWJAP:4\r\nFAIL"));
+			SerialTx.println(F("\r\n+CWJAP:4\r\nFAIL"));
 			gsFlag_Connecting = false;
 			gsFlag_Busy = false;
 			break;
 
 		case STATION_WRONG_PASSWORD:
-			Serial.println(F("\r\n+CWJAP:2\r\nFAIL"));
+			SerialTx.println(F("\r\n+CWJAP:2\r\nFAIL"));
 			gsFlag_Connecting = false;
 			gsFlag_Busy = false;
 			break;
@@ -710,13 +931,29 @@ void loop()
 			WiFi.setAutoReconnect(false);
 	}
 
+	// Is a link connecting now?
+	if (gsLinkIdConnecting >= 0)
+		processLinkConnecting();
+
+	// Print the AT+CWLAP result when the background scan finishes, not while receiving data
+	if (scanCacheIsRunning() && gsLinkIdReading < 0 && gsSendMultiLength == 0 && !gsFlag_Passthrough && !gsFlag_Binary)
+		processScanResult();
+
+	// Write the changed settings after a quiet period, not while receiving data
+	if (gsLinkIdReading < 0 && gsSendMultiLength == 0 && !gsFlag_Passthrough && !gsFlag_Binary)
+		Settings::process();
+
+	// Return to 80 MHz after the idle time of the AT+SYSCPUFREQ=0 governor
+	cpuFreqProcess();
+
 	// Check for a new command while connecting
 	if (gsFlag_Busy)
 	{
 		// Check for busy condition
 		if (inputBufferCnt != 0)
 		{
-			Serial.println(F("\r\nbusy p..."));
+			SerialTx.println(F("\r\nbusy p..."));
+			PERF_COUNT(PERF_BUSY);
 
 			// Discard the input buffer
 			inputBufferCnt = 0;
@@ -724,10 +961,14 @@ void loop()
 	}
 	else if (lineCompleted) // Check for a new command
 	{
+		PERF_START(commandStart);
+
 		processCommandBuffer();
 
+		PERF_STOP(PERF_COMMAND, commandStart);
+
 		// Discard the garbage that may have come during the processing of the command
-		while (Serial.available())
+		while (!gsFlag_Passthrough && !gsFlag_Binary && Serial.available())
 		{
 			int c = Serial.peek();
 			if (c < 0 || c == 'A') // we are waiting for empty serial or 'A' in AT command
@@ -742,6 +983,8 @@ void loop()
 			Serial.read();
 		}
 	}
+
+	PERF_STOP(PERF_LOOP, loopStart);
 }
 
 /*
@@ -750,7 +993,7 @@ void loop()
 void DeleteClient(uint8_t index)
 {
 	// Check the input
-	if (index > 4)
+	if (index >= MAX_LINKS)
 		return;
 
 	client_t *cli = &(clients[index]);
@@ -763,10 +1006,25 @@ void DeleteClient(uint8_t index)
 	}
 
 	if (index == gsLinkIdReading)
+	{
 		gsLinkIdReading = -1;
+		gsFlag_SendBuf = false;
+	}
+
+	delete cli->sendQueue;
+	cli->sendQueue = nullptr;
+
+	if (index == 0)
+		stopPassthrough();
 
 	cli->sendLength = 0;
 	cli->type = TYPE_NONE;
+	cli->sslResumed = false;
+	cli->serverId = SERVER_NONE;
+	cli->sendMulti = false;
+	cli->sslBufferSize = 0;
+
+	resetLinkOptions(index);
 }
 
 /*
@@ -830,11 +1088,23 @@ void configureEthernet()
 			if (mac == nullptr) {
 				Ethernet.macAddress(gsCipEthMAC);
 			}
+			Ethernet.onStatusChange(ethStatusCallback);
 		}
+		gsEthStatusChanged = true;
 	}
 #endif
 }
 
+#ifdef ETHERNET_CLASS
+/*
+ * Called by lwIP when the Ethernet netif goes up or down or changes the address, the messages are printed in loop()
+ */
+static void ethStatusCallback()
+{
+	gsEthStatusChanged = true;
+}
+#endif
+
 /*
  * Set DNS servers
  */
@@ -872,6 +1142,41 @@ bool applyCipAp()
   return WiFi.softAPConfig(gsCipApCfg.ip, gsCipApCfg.gw, gsCipApCfg.mask);
 }
 
+/*
+ * Sets the UART hardware flow control: bit 0 = RTS (GPIO15), bit 1 = CTS (GPIO13)
+ * Must be called after every Serial.begin(), it resets the UART configuration registers
+ */
+void setUartFlowControl(uint8_t flow)
+{
+	// RTS: the UART deasserts RTS when the RX FIFO reaches the threshold
+	if (flow & 1)
+	{
+		PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTDO_U, FUNC_U0RTS);
+		USC1(0) = (USC1(0) & ~(0x7F << UCRXHFT)) | (UART_RTS_THRESHOLD << UCRXHFT) | (1 << UCRXHFE);
+	}
+	else
+	{
+		USC1(0) &= ~(1 << UCRXHFE);
+		if (gsUartFlowControl & 1)
+			PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTDO_U, FUNC_GPIO15);
+	}
+
+	// CTS: the UART stops transmitting while CTS is deasserted
+	if (flow & 2)
+	{
+		PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTCK_U, FUNC_U0CTS);
+		USC0(0) |= (1 << UCTXHFE);
+	}
+	else
+	{
+		USC0(0) &= ~(1 << UCTXHFE);
+		if (gsUartFlowControl & 2)
+			PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTCK_U, FUNC_GPIO13);
+	}
+
+	gsUartFlowControl = flow;
+}
+
 /*
  * Send data in a +IPD message (for AT+CIPRECVMODE=0) or +CIPRECVDATA (for AT+CIPRECVMODE=1)
  * Returns number of bytes sent or 0 (error)
@@ -881,7 +1186,7 @@ int SendData(int clientIndex, int maxSize)
 	const char *respText[2] = {"+IPD", "+CIPRECVDATA"};
 
 	WiFiClient *cli = clients[clientIndex].client;
-	int bytes;
+	int bytes = 0;
 
 	if (cli == nullptr)
 		return 0;
@@ -894,12 +1199,31 @@ int SendData(int clientIndex, int maxSize)
 	if (maxSize > 0 && maxSize < avail)
 		avail = maxSize;
 
-	uint8_t *buf = new uint8_t[avail];
+	// From loop() only what fits in the serial buffer, the rest waits in the client for the next pass
+	int room = SerialTx.availableForWrite() - IPD_HEADER_MAX;
 
-	if (buf != nullptr)
+	if (maxSize == 0 && avail > room)
 	{
-		Serial.println();
-		Serial.print(respText[gsCipRecvMode]);
+		// A datagram is delivered whole, unless it does not fit even in the empty buffer
+		if (room <= 0 || (clients[clientIndex].type == TYPE_UDP && avail <= SERIAL_TX_BUFFER_SIZE - IPD_HEADER_MAX))
+			return 0;
+
+		if (clients[clientIndex].type != TYPE_UDP)
+			avail = room;
+	}
+
+	// Decrypting TLS records and streaming large deliveries
+	if (clients[clientIndex].type == TYPE_SSL || avail >= CPU_FREQ_BOOST_MIN_BYTES)
+		cpuFreqBoost();
+
+	PERF_START(sendStart);
+
+	// No framing in the passthrough mode, the data go to the serial port as they are
+	if (gsCipMode == 0)
+	{
+		// The header is formatted at once and written with one call
+		char header[IPD_HEADER_MAX]; // \r\n+CIPRECVDATA,<link ID>,<length>,<remote IP>,<remote port>:
+		int len = snprintf_P(header, sizeof(header), PSTR("\r\n%s"), respText[gsCipRecvMode]);
 
 		/* FIXME: Weird behaviour of the original firmware when CIPRECVMODE=1:
 		 * It responds +CIPRECVDATA,<size> regardless of CIPMUX setting. It doesn't
@@ -907,67 +1231,518 @@ int SendData(int clientIndex, int maxSize)
 		 */
 		if (gsCipMux == 1 && gsCipRecvMode == 0)
 		{
-			Serial.printf_P(PSTR(",%d"), clientIndex);
+			len += snprintf_P(header + len, sizeof(header) - len, PSTR(",%d"), clientIndex);
 		}
 
-		Serial.printf_P(PSTR(",%d"), avail);
+		len += snprintf_P(header + len, sizeof(header) - len, PSTR(",%d"), avail);
 
 		if (gsCipdInfo == 1 && gsCipRecvMode == 0) // No CIPDINFO for CIPRECVDATA
 		{
-			IPAddress ip = cli->remoteIP();
+			IPAddress remoteIP = cli->remoteIP();
+			uint16_t remotePort = cli->remotePort();
+
+			// The sender of the datagram
+			if (clients[clientIndex].type == TYPE_UDP)
+			{
+				remoteIP = static_cast<UdpClient *>(cli)->packetRemoteIP();
+				remotePort = static_cast<UdpClient *>(cli)->packetRemotePort();
+			}
+
+			len += snprintf_P(header + len, sizeof(header) - len, PSTR(",%d.%d.%d.%d,%d"),
+							  remoteIP[0], remoteIP[1], remoteIP[2], remoteIP[3], remotePort);
+		}
+
+		header[len++] = ':';
+
+		SerialTx.write((const uint8_t *)header, len);
+	}
+
+	// Stream the data from the client to the serial buffer through the fixed receive buffer
+	while (bytes < avail)
+	{
+		int rxBytes = avail - bytes;
+		if (rxBytes > (int)sizeof(recvBuffer))
+			rxBytes = sizeof(recvBuffer);
+
+		rxBytes = cli->readBytes(recvBuffer, rxBytes);
+
+		if (rxBytes <= 0)
+			break;
+
+		SerialTx.write(recvBuffer, rxBytes);
+
+		bytes += rxBytes;
+	}
+
+	if (bytes < avail)
+		SerialTx.printf_P(MSG_ERROR);
+
+	PERF_STOP(PERF_SENDDATA, sendStart);
+	PERF_LINK_IN(clientIndex, bytes);
+
+	return bytes;
+}
+
+/*
+ * Applies the socket options of AT+CIPTCPOPT to a connected TCP or SSL link
+ */
+void applyLinkOptions(uint8_t linkId)
+{
+	WiFiClient *cli = clients[linkId].client;
+	const linkOptions_t *opt = &linkOptions[linkId];
+
+	if (cli == nullptr || clients[linkId].type == TYPE_UDP)
+		return;
+
+	cli->setNoDelay(opt->noDelay);
+	cli->setSync(opt->sync);
+	cli->setTimeout(opt->writeTimeout != 0 ? opt->writeTimeout : TCP_WRITE_TIMEOUT_DEFAULT);
+
+	if (opt->keepAliveIdle != 0)
+		cli->keepAlive(opt->keepAliveIdle, opt->keepAliveInterval, opt->keepAliveCount);
+	else
+		cli->disableKeepAlive();
+}
+
+/*
+ * Sets the default socket options of a link, the options of AT+CIPTCPOPT and AT+CIPSTART end with the link
+ */
+void resetLinkOptions(uint8_t linkId)
+{
+	linkOptions[linkId] = {0, 0, TCP_KEEPALIVE_DEFAULT_INTERVAL, TCP_KEEPALIVE_DEFAULT_COUNT, false, true, 0, 0};
+}
+
+/*
+ * Prints a message of the link in one write, with AT+CIPMUX=1 prefixed with <link ID>,
+ */
+static void printLinkMessage(uint8_t linkId, const char *format, ...)
+{
+	char line[32];
+	int len = 0;
+	va_list args;
+
+	if (gsCipMux == 1)
+		len = snprintf_P(line, sizeof(line), PSTR("%d,"), linkId);
+
+	va_start(args, format);
+	vsnprintf_P(line + len, sizeof(line) - len, format, args);
+	va_end(args);
+
+	SerialTx.print(line);
+}
+
+/*
+ * Reports the closed link: <link ID>,CLOSED or the BIN_CLOSE frame in the binary mode
+ */
+static void printLinkClosed(uint8_t linkId)
+{
+	if (gsFlag_Binary)
+	{
+		binModeSendFrame(linkId, BIN_CLOSE, nullptr, 0);
+		return;
+	}
+
+	printLinkMessage(linkId, PSTR("CLOSED\r\n"));
+}
+
+/*
+ * Writes the AT+CIPSENDMULTI data from sendBuffer to each target link, reports the result of each link
+ */
+static void sendMultiData()
+{
+	SerialTx.printf_P(PSTR("\r\nRecv %d bytes\r\n"), gsSendMultiLength);
+
+	for (uint8_t i = 0; i < MAX_LINKS; ++i)
+	{
+		client_t *link = &clients[i];
 
-			Serial.printf_P(PSTR(",%s,%d"), ip.toString().c_str(), cli->remotePort());
+		if (!link->sendMultiTarget)
+			continue;
+
+		link->sendMultiTarget = false;
+
+		// The target was closed while the data were read
+		if (!link->sendMulti)
+		{
+			SerialTx.printf_P(PSTR("%d,SEND FAIL\r\n"), i);
+			continue;
 		}
 
-		Serial.print(':');
+		link->sendMulti = false;
 
-		bytes = cli->readBytes(buf, avail);
-		int bytesToSend = bytes;
-		uint8_t *bufPtr = buf;
+		if (link->type == TYPE_SSL)
+			cpuFreqBoost();
 
-		while (bytesToSend > 0)
+		PERF_START(writeStart);
+
+		bool sent = link->client->connected() && link->client->write(sendBuffer, gsSendMultiLength) == gsSendMultiLength;
+
+		PERF_STOP(PERF_CLIENT_WRITE, writeStart);
+		PERF_LINK_OUT(i, gsSendMultiLength);
+
+		if (sent)
+		{
+			link->lastActivityMillis = millis();
+			SerialTx.printf_P(PSTR("%d,SEND OK\r\n"), i);
+		}
+		else
 		{
-			// Send data in chunks of 100 bytes to avoid wdt reset
-			int txBytes = bytesToSend;
-			if (bytesToSend > 100)
-				txBytes = 100;
+			SerialTx.printf_P(PSTR("%d,SEND FAIL\r\n"), i);
+			if (link->client->connected())
+				link->client->stop();
+		}
+	}
+
+	gsSendMultiLength = 0;
+	dataRead = 0;
+}
+
+/*
+ * Checks if the received data of a link are held to be delivered with the next data in one +IPD
+ * (AT+CIPRECVCOALESCE). The datagrams and the passthrough data are never held.
+ */
+static bool recvCoalesceHold(uint8_t linkId, int avail)
+{
+	client_t *link = &clients[linkId];
+	const linkOptions_t *opt = &linkOptions[linkId];
+
+	if (opt->recvCoalesceBytes == 0 || gsCipMode == 1 || link->type == TYPE_UDP)
+		return false;
+
+	if (avail >= opt->recvCoalesceBytes || !link->client->connected())
+		return false;
+
+	// The first data start the hold time
+	if (link->lastAvailableBytes == 0)
+	{
+		link->recvHoldMillis = millis();
+		return opt->recvCoalesceTime > 0;
+	}
 
-			// Wait for tx empty
-			esp8266::polledTimeout::oneShot waitForTxReadyTimeout(500);
+	return millis() - link->recvHoldMillis < opt->recvCoalesceTime;
+}
+
+/*
+ * Starts connecting a link (AT+CIPSTART). The remote host is resolved asynchronously
+ * and the connection is finished in loop(). Until then, the other commands are busy.
+ * Returns false if DNS cannot be started.
+ */
+bool startLinkConnect(uint8_t linkId, clientTypes_t type, WiFiClient *cli, const char *remoteAddr, uint16_t remotePort,
+					  int32_t keepAlive)
+{
+	linkConnecting.client = cli;
+	linkConnecting.type = type;
+	strlcpy(linkConnecting.remoteAddr, remoteAddr, sizeof(linkConnecting.remoteAddr));
+	linkConnecting.remotePort = remotePort;
+	linkConnecting.remoteIP = 0;
+	linkConnecting.state = LINK_CONNECT_DNS;
+	linkConnecting.startMillis = millis();
+	linkConnecting.keepAlive = keepAlive;
+
+	// Late answers of previous requests are recognized by the sequence number
+	++linkConnectSequence;
+
+	if (dnsCacheLookup(linkConnecting.remoteAddr, linkConnecting.remoteIP))
+	{
+		linkConnecting.state = LINK_CONNECT_RESOLVED;
+
+		gsLinkIdConnecting = linkId;
+		gsFlag_Busy = true;
+
+		return true;
+	}
+
+	ip_addr_t addr;
+	err_t err = dns_gethostbyname(linkConnecting.remoteAddr, &addr, dnsFoundCallback, (void *)(uintptr_t)linkConnectSequence);
+
+	if (err == ERR_OK) // Cached or an ip address
+	{
+		linkConnecting.remoteIP = ip_addr_get_ip4_u32(&addr);
+		linkConnecting.state = LINK_CONNECT_RESOLVED;
+	}
+	else if (err != ERR_INPROGRESS)
+	{
+		return false;
+	}
+
+	gsLinkIdConnecting = linkId;
+	gsFlag_Busy = true;
+
+	return true;
+}
+
+/*
+ * DNS callback for the connection in progress
+ */
+static void dnsFoundCallback(const char *name, const ip_addr_t *ipaddr, void *arg)
+{
+	(void)name;
+
+	if ((uintptr_t)arg != linkConnectSequence || gsLinkIdConnecting < 0 || linkConnecting.state != LINK_CONNECT_DNS)
+		return;
+
+	if (ipaddr != nullptr)
+	{
+		linkConnecting.remoteIP = ip_addr_get_ip4_u32(ipaddr);
+		linkConnecting.state = LINK_CONNECT_RESOLVED;
+	}
+	else
+	{
+		linkConnecting.state = LINK_CONNECT_DNS_FAIL;
+	}
+}
+
+/*
+ * Connects the client of the connection in progress
+ */
+static bool connectLink(WiFiClient *cli)
+{
+	// Connect using remote host name, not ip address (necessary for TLS). The name is resolved from the DNS cache.
+	if (linkConnecting.type == TYPE_SSL)
+		return cli->connect(linkConnecting.remoteAddr, linkConnecting.remotePort);
+
+	return cli->connect(IPAddress(linkConnecting.remoteIP), linkConnecting.remotePort);
+}
+
+/*
+ * Continues the connection in progress
+ */
+static void processLinkConnecting()
+{
+	linkConnectState_t state = linkConnecting.state;
+
+	if (state == LINK_CONNECT_DNS)
+	{
+		if (millis() - linkConnecting.startMillis < CIPSTART_DNS_TIMEOUT)
+			return; // Still waiting
+
+		state = LINK_CONNECT_DNS_FAIL;
+	}
 
-			while (!Serial.availableForWrite() && !waitForTxReadyTimeout)
+	WiFiClient *cli = linkConnecting.client;
+	bool connected = false;
+	bool sslResumed = false;
+
+	// Offer the cached TLS session for an abbreviated handshake
+	BearSSL::Session *session = nullptr;
+	br_ssl_session_parameters cachedSession;
+
+	uint16_t sslBufferSize = gsCipSslSize;
+	bool mflnSmall = false; // Auto buffer size: connecting with the small buffer
+	bool mflnTest = false;	// Auto buffer size: the MFLN support of the server is not known yet
+
+	if (state == LINK_CONNECT_RESOLVED && linkConnecting.type == TYPE_SSL)
+	{
+		// Auto buffer size: the small buffer if the server supports MFLN. An unknown server is tried
+		// with the small buffer, the handshake shows the support without a separate probe.
+		if (gsCipSslSize == 0)
+		{
+			if (!mflnCacheLookup(linkConnecting.remoteAddr, linkConnecting.remotePort, SSL_MFLN_AUTO_SIZE, mflnSmall))
 			{
+				mflnSmall = true;
+				mflnTest = true;
 			}
 
-			// In case of a timeout stop the transmission with an error
-			if (waitForTxReadyTimeout)
-				break;
+			if (mflnSmall)
+			{
+				sslBufferSize = SSL_MFLN_AUTO_SIZE;
+				static_cast<BearSSL::WiFiClientSecure *>(cli)->setBufferSizes(sslBufferSize, 512);
+			}
+			else
+			{
+				sslBufferSize = 16384;
+			}
+		}
+
+		session = sslSessionCacheGet(linkConnecting.remoteAddr, linkConnecting.remotePort);
+
+		if (session != nullptr)
+		{
+			cachedSession = *(session->getSession());
+			static_cast<BearSSL::WiFiClientSecure *>(cli)->setSession(session);
+		}
+	}
+
+	// The TLS handshake is much faster at 160 MHz
+	if (state != LINK_CONNECT_DNS_FAIL && linkConnecting.type == TYPE_SSL)
+		cpuFreqBoost();
+
+	PERF_START(connectStart);
 
-			Serial.write(bufPtr, txBytes);
+	if (state == LINK_CONNECT_DNS_FAIL)
+	{
+		SerialTx.println(F("DNS Fail"));
+	}
+	else
+	{
+		connected = connectLink(cli);
 
-			bufPtr += txBytes;
-			bytesToSend -= txBytes;
+		// Without MFLN the server does not confirm the extension or the handshake fails with a record
+		// larger than the small buffer. Other failures (e.g. the host is down) are not retried.
+		if (mflnTest)
+		{
+			BearSSL::WiFiClientSecure *sslCli = static_cast<BearSSL::WiFiClientSecure *>(cli);
+			bool noMfln = connected ? !sslCli->getMFLNStatus() : sslCli->getLastSSLError() == BR_ERR_TOO_LARGE;
+
+			if (connected || noMfln)
+				mflnCacheAdd(linkConnecting.remoteAddr, linkConnecting.remotePort, SSL_MFLN_AUTO_SIZE, !noMfln);
 
-			yield();
+			if (noMfln)
+			{
+				AT_DEBUG_PRINT("--- no MFLN, reconnecting with the full buffer\r\n");
+
+				cli->stop();
+				sslBufferSize = 16384;
+				static_cast<BearSSL::WiFiClientSecure *>(cli)->setBufferSizes(sslBufferSize, 512);
+				connected = connectLink(cli);
+			}
 		}
 
-		delete buf;
+		if (!connected)
+			SerialTx.println("connect fail");
+	}
+
+	// The server accepted the offered session if the session id did not change
+	if (connected && session != nullptr)
+	{
+		br_ssl_session_parameters *newSession = session->getSession();
+
+		sslResumed = cachedSession.session_id_len > 0 && newSession->session_id_len == cachedSession.session_id_len &&
+					 !memcmp(newSession->session_id, cachedSession.session_id, cachedSession.session_id_len);
+	}
+
+	if (state != LINK_CONNECT_DNS_FAIL)
+		PERF_STOP(PERF_CONNECT, connectStart);
+
+	if (session != nullptr)
+	{
+		// The handshake has stored the session in the cache, the client must not keep the pointer
+		// as AT+CIPSSLSESS may reallocate the cache
+		static_cast<BearSSL::WiFiClientSecure *>(cli)->setSession(nullptr);
+
+		if (!connected)
+			sslSessionCacheRemove(linkConnecting.remoteAddr, linkConnecting.remotePort);
+	}
+
+	// Test again next time, the server may have changed. A missing MFLN found by this connect is kept.
+	if (gsCipSslSize == 0 && state == LINK_CONNECT_RESOLVED && linkConnecting.type == TYPE_SSL && !connected && !mflnTest)
+		mflnCacheRemove(linkConnecting.remoteAddr, linkConnecting.remotePort, SSL_MFLN_AUTO_SIZE);
+
+	if (state == LINK_CONNECT_RESOLVED)
+	{
+		// Keep the working address, forget the one which may be outdated
+		if (connected)
+			dnsCacheAdd(linkConnecting.remoteAddr, linkConnecting.remoteIP);
+		else
+			dnsCacheRemove(linkConnecting.remoteAddr);
+	}
+
+	if (connected)
+	{
+		if (gsCipMux == 0)
+			SerialTx.print(F("CONNECT\r\n\r\nOK\r\n"));
+		else
+			SerialTx.printf_P(PSTR("%d,CONNECT\r\n\r\nOK\r\n"), gsLinkIdConnecting);
+
+		clients[gsLinkIdConnecting].client = cli;
+		clients[gsLinkIdConnecting].type = linkConnecting.type;
+		clients[gsLinkIdConnecting].lastAvailableBytes = 0;
+		clients[gsLinkIdConnecting].lastActivityMillis = millis();
+		clients[gsLinkIdConnecting].sslResumed = sslResumed;
+		clients[gsLinkIdConnecting].sslBufferSize = (linkConnecting.type == TYPE_SSL ? sslBufferSize : 0);
+
+		if (linkConnecting.keepAlive >= 0)
+			linkOptions[gsLinkIdConnecting].keepAliveIdle = linkConnecting.keepAlive;
+
+		applyLinkOptions(gsLinkIdConnecting);
 
-		if (bytes < avail)
-			Serial.printf_P(MSG_ERROR);
+		gsWasConnected = true; // Flag for CIPSTATUS command
 	}
 	else
 	{
-		// Out of memory
-		if (gsCipMux == 0 || gsCipRecvMode == 1)
-			Serial.printf_P(PSTR("\r\n%s,out of mem"), respText[gsCipRecvMode]);
+		delete cli;
+
+		SerialTx.printf_P(MSG_ERROR);
+		SerialTx.println(F("CLOSED"));
+	}
+
+	linkConnecting.client = nullptr;
+	gsLinkIdConnecting = -1;
+	gsFlag_Busy = false;
+}
+
+/*
+ * Leaves the passthrough mode, unsent data are discarded
+ */
+void stopPassthrough()
+{
+	if (!gsFlag_Passthrough)
+		return;
+
+	gsFlag_Passthrough = false;
+	dataRead = 0;
+
+	AT_DEBUG_PRINT("--- passthrough off\r\n");
+}
+
+/*
+ * Reads the serial port into the send buffer in the passthrough mode
+ * A packet is sent when the buffer is full or after an idle time of PASSTHROUGH_PACKET_INTERVAL ms.
+ * A packet consisting of "+++" only ends the passthrough mode.
+ */
+static void readPassthroughData()
+{
+	size_t avail = Serial.available();
+
+	if (avail > 0)
+	{
+		// The escape sequence must come after an idle time
+		if (dataRead == 0)
+			passthroughEscape = (millis() - passthroughLastRx >= PASSTHROUGH_PACKET_INTERVAL);
+
+		if (avail > sizeof(sendBuffer) - dataRead)
+			avail = sizeof(sendBuffer) - dataRead;
+
+		dataRead += Serial.readBytes(sendBuffer + dataRead, avail);
+		passthroughLastRx = millis();
+
+		if (dataRead >= sizeof(sendBuffer))
+			sendPassthroughPacket();
+	}
+	else if (dataRead > 0 && millis() - passthroughLastRx >= PASSTHROUGH_PACKET_INTERVAL)
+	{
+		if (passthroughEscape && dataRead == 3 && !memcmp_P(sendBuffer, PSTR("+++"), 3))
+			stopPassthrough();
 		else
-			Serial.printf_P(PSTR("\r\n%s,%d,out of mem"), respText[gsCipRecvMode], clientIndex);
+			sendPassthroughPacket();
+	}
+}
 
-		return 0;
+/*
+ * Sends the passthrough data collected in the send buffer
+ */
+static void sendPassthroughPacket()
+{
+	WiFiClient *cli = clients[0].client;
+
+	if (cli == nullptr)
+	{
+		stopPassthrough();
+		return;
 	}
 
-	return bytes;
+	if (clients[0].type == TYPE_SSL)
+		cpuFreqBoost();
+
+	PERF_START(writeStart);
+
+	if (cli->write(sendBuffer, dataRead) == dataRead)
+		clients[0].lastActivityMillis = millis();
+
+	PERF_STOP(PERF_CLIENT_WRITE, writeStart);
+	PERF_LINK_OUT(0, dataRead);
+
+	dataRead = 0;
 }
 
 /*
@@ -983,23 +1758,68 @@ const char *nullIfEmpty(String &s)
 }
 
 /*
- * Checks if the newly added certificate is a duplicate
+ * Checks if the newly added certificate is a duplicate, if not, loads it
+ * The certificates are compared by the length and SHA-256 fingerprint kept in certIndex
  */
-bool checkCertificateDuplicatesAndLoad(BearSSL::X509List &importCertList)
+bool checkCertificateDuplicatesAndLoad(const uint8_t *der, size_t length)
 {
-	const br_x509_certificate *importedCert = &(importCertList.getX509Certs()[0]);
+	uint8_t sha256[br_sha256_SIZE];
+	br_sha256_context ctx;
 
-	for (size_t i = 0; i < CAcert->getCount(); i++)
+	br_sha256_init(&ctx);
+	br_sha256_update(&ctx, der, length);
+	br_sha256_out(&ctx, sha256);
+
+	size_t count = CAcert->getCount();
+
+	for (size_t i = 0; i < count; i++)
 	{
-		const br_x509_certificate *cert = &(CAcert->getX509Certs()[i]);
-		if (!memcmp(importedCert->data, cert->data, importedCert->data_len))
+		if (certIndex[i].length == length && !memcmp(certIndex[i].sha256, sha256, sizeof(sha256)))
 		{
 			return true;
 		}
 	}
 
 	// Certificate is not a duplicate
-	CAcert->append(importedCert->data, importedCert->data_len);
+	certIndex_t *newIndex = (certIndex_t *)realloc(certIndex, (count + 1) * sizeof(certIndex_t));
+
+	if (newIndex == nullptr)
+		return false; // not loaded, OOM
+
+	certIndex = newIndex;
+
+	if (CAcert->append(der, length) && CAcert->getCount() == count + 1)
+	{
+		const br_x509_certificate *cert = &(CAcert->getX509Certs()[count]);
+		uint8_t *cn = getCnFromDer(cert->data, cert->data_len);
+
+		memcpy(certIndex[count].sha256, sha256, sizeof(sha256));
+		certIndex[count].length = length;
+		certIndex[count].cnOffset = (cn != nullptr ? cn - cert->data : 0);
+	}
 
 	return false;
 }
+
+/*
+ * Deletes the certificate with a zero based index
+ */
+void deleteCertificate(size_t number)
+{
+	BearSSL::X509List *certList = new BearSSL::X509List();
+
+	for (size_t i = 0; i < CAcert->getCount(); i++)
+	{
+		if (i != number)
+		{
+			const br_x509_certificate *cert = &(CAcert->getX509Certs()[i]);
+			certList->append(cert->data, cert->data_len);
+		}
+	}
+
+	// The rest of the index moves down, the CN offsets stay valid in the copied certificates
+	memmove(&(certIndex[number]), &(certIndex[number + 1]), (CAcert->getCount() - number - 1) * sizeof(certIndex_t));
+
+	delete CAcert;
+	CAcert = certList;
+}
@@ -1,40 +1,70 @@
-#ifndef _LWIPINTFDEVPACTH_H
-#define _LWIPINTFDEVPATCH_H
-
-/*
- * This patch is required for esp8266 Arduino version 3.1.2 end older.
- * When a version following 3.1.2 is released, the patch can be removed.
- */
-
-
-#include <LwipIntfDev.h>
-
-template<class RawDev>
-class LwipIntfDevPatch: public LwipIntfDev<RawDev> {
-public:
-
-	LwipIntfDevPatch(int8_t cs = SS, SPIClass &spi = SPI, int8_t intr = -1) :
-			LwipIntfDev<RawDev>(cs, spi, intr)
-	{
-
-	}
-
-	void end()
-	{
-		if (LwipIntfDev<RawDev>::_started)
-		{
-			netif_remove(&(LwipIntfDev<RawDev>::_netif));
-			LwipIntfDev<RawDev>::_started = false;
-			RawDev::end();
-		}
-	}
-
-    uint8_t* macAddress(uint8_t* mac)
-    {
-        memcpy(mac, LwipIntfDev<RawDev>::_netif.hwaddr, 6);
-        return mac;
-    }
-};
-
-
+#ifndef _LWIPINTFDEVPACTH_H
+#define _LWIPINTFDEVPATCH_H
+
+/*
+ * This patch is required for esp8266 Arduino version 3.1.2 end older.
+ * When a version following 3.1.2 is released, the patch can be removed.
+ */
+
+
+#include <LwipIntfDev.h>
+
+template<class RawDev>
+class LwipIntfDevPatch: public LwipIntfDev<RawDev> {
+public:
+
+	LwipIntfDevPatch(int8_t cs = SS, SPIClass &spi = SPI, int8_t intr = -1) :
+			LwipIntfDev<RawDev>(cs, spi, intr)
+	{
+
+	}
+
+	void end()
+	{
+		if (LwipIntfDev<RawDev>::_started)
+		{
+			netif_remove(&(LwipIntfDev<RawDev>::_netif));
+			LwipIntfDev<RawDev>::_started = false;
+			RawDev::end();
+		}
+	}
+
+    uint8_t* macAddress(uint8_t* mac)
+    {
+        memcpy(mac, LwipIntfDev<RawDev>::_netif.hwaddr, 6);
+        return mac;
+    }
+
+	/*
+	 * Chains the callback to the netif status callback of the core (up, down, address change).
+	 * Call after each begin(), the netif is initialized again.
+	 */
+	void onStatusChange(void (*callback)())
+	{
+		netif *nif = &(LwipIntfDev<RawDev>::_netif);
+
+		if (nif->status_callback != statusCallback)
+		{
+			_coreStatusCallback = nif->status_callback;
+			netif_set_status_callback(nif, statusCallback);
+		}
+		_statusCallback = callback;
+	}
+
+private:
+	static void statusCallback(netif *nif)
+	{
+		LwipIntfDevPatch *self = static_cast<LwipIntfDevPatch *>((LwipIntfDev<RawDev> *)nif->state);
+
+		if (self->_coreStatusCallback != nullptr)
+			self->_coreStatusCallback(nif);
+		if (self->_statusCallback != nullptr)
+			self->_statusCallback();
+	}
+
+	netif_status_callback_fn _coreStatusCallback = nullptr;
+	void (*_statusCallback)() = nullptr;
+};
+
+
 #endif
\ No newline at end of file
@@ -23,6 +23,8 @@
 #include "ESP8266WiFi.h"
 
 #include "WifiEvents.h"
+#include "fastJoin.h"
+#include "serialTx.h"
 
 /*
  * Feedback when connected to AP
@@ -30,16 +32,17 @@
 void onStationConnected(const WiFiEventStationModeConnected &evt)
 {
 	(void)evt;
-	Serial.println(F("WIFI CONNECTED"));
+	fastJoinConnected();
+	SerialTx.print(F("WIFI CONNECTED\r\n"));
 }
 
 /*
- * Feedback when got IP address
+ * Feedback when got IP address, with the time of the join [ms]
  */
 void onStationGotIP(const WiFiEventStationModeGotIP &evt)
 {
-	(void)evt;
-	Serial.println(F("WIFI GOT IP"));
+	uint32_t joinTime = fastJoinGotIP(evt.ip, evt.mask, evt.gw);
+	SerialTx.printf_P(PSTR("WIFI GOT IP (%u ms)\r\n"), joinTime);
 }
 
 /*
@@ -48,5 +51,6 @@ void onStationGotIP(const WiFiEventStationModeGotIP &evt)
  */
 void onStationDisconnected(const WiFiEventStationModeDisconnected &evt)
 {
-	Serial.printf_P(PSTR("WIFI DISCONNECT (%d)\r\n"), evt.reason);
+	fastJoinDisconnected();
+	SerialTx.printf_P(PSTR("WIFI DISCONNECT (%d)\r\n"), evt.reason);
 }
@@ -0,0 +1,133 @@
+/*
+ * Wiznet5500Int.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIZNET5500INT_H_
+#define WIZNET5500INT_H_
+
+#include "Arduino.h"
+#include <SPI.h>
+#include <utility/w5500.h>
+
+/*
+ * Note: LwipIntfDev polls the chip for a received frame on every pass of the scheduler. The core
+ *       does not implement the interrupt of the W5500, so this driver uses the INT pin to skip
+ *       the SPI transfers of the poll: the chip asserts INT (low) when the socket 0 (MACRAW)
+ *       receives a frame. Another poll reaches the chip while a frame is pending and every
+ *       ETH_INT_SAFETY_POLL ms in case of a lost interrupt (e.g. the chip was reset).
+ */
+
+/*
+ * Defines
+ */
+
+#define ETH_INT_SAFETY_POLL 50 // Maximum time [ms] between two polls reaching the chip
+
+#define W5500_SIMR 0x0018		  // Common register: socket interrupt mask
+#define W5500_SN_IR 0x0002		  // Socket register: interrupt
+#define W5500_SN_IMR 0x002C		  // Socket register: interrupt mask
+#define W5500_SN_IR_RECV 0x04	  // Socket interrupt: data received
+#define W5500_CTRL_COMMON_WRITE 0x04 // Control phase: common register block, write, variable length
+#define W5500_CTRL_SOCK0_WRITE 0x0C	 // Control phase: socket 0 register block, write, variable length
+
+/*
+ * Class Wiznet5500Int
+ */
+
+class Wiznet5500Int : public Wiznet5500
+{
+public:
+	Wiznet5500Int(int8_t cs = SS, SPIClass &spi = SPI, int8_t intr = -1) : Wiznet5500(cs, spi, -1), _csPin(cs), _spiBus(spi)
+	{
+		setInterruptPin(intr);
+	}
+
+	/*
+	 * Sets the GPIO connected to the INT pin of the chip, -1 = polling only
+	 */
+	void setInterruptPin(int8_t intr)
+	{
+		_intPin = intr;
+		_intArmed = false;
+
+		if (_intPin >= 0)
+			pinMode(_intPin, INPUT_PULLUP);
+	}
+
+	int8_t getInterruptPin() const { return _intPin; }
+
+	void end()
+	{
+		_intArmed = false;
+		Wiznet5500::end();
+	}
+
+	/*
+	 * Called by LwipIntfDev::handlePackets(), returns 0 without the SPI transfer when nothing was received
+	 */
+	uint16_t readFrameSize()
+	{
+		if (_intPin >= 0)
+		{
+			if (!_intArmed)
+			{
+				// The chip reset clears the mask, only the received data assert INT
+				writeRegister(W5500_CTRL_SOCK0_WRITE, W5500_SN_IMR, W5500_SN_IR_RECV);
+				writeRegister(W5500_CTRL_COMMON_WRITE, W5500_SIMR, 0x01);
+				_intArmed = true;
+			}
+			else if (!_framePending && digitalRead(_intPin) == HIGH && millis() - _lastPollMillis < ETH_INT_SAFETY_POLL)
+			{
+				return 0;
+			}
+
+			// Cleared before reading, a frame received from now on asserts INT again
+			writeRegister(W5500_CTRL_SOCK0_WRITE, W5500_SN_IR, W5500_SN_IR_RECV);
+			_lastPollMillis = millis();
+		}
+
+		uint16_t size = Wiznet5500::readFrameSize();
+
+		// More frames may wait in the buffer without a new interrupt
+		_framePending = (size != 0);
+
+		return size;
+	}
+
+private:
+	void writeRegister(uint8_t control, uint16_t address, uint8_t value)
+	{
+		digitalWrite(_csPin, LOW);
+		_spiBus.transfer(address >> 8);
+		_spiBus.transfer(address & 0xFF);
+		_spiBus.transfer(control);
+		_spiBus.transfer(value);
+		digitalWrite(_csPin, HIGH);
+	}
+
+	int8_t _csPin;
+	SPIClass &_spiBus;
+	int8_t _intPin = -1;
+	bool _intArmed = false;
+	bool _framePending = false;
+	uint32_t _lastPollMillis = 0;
+};
+
+#endif /* WIZNET5500INT_H_ */
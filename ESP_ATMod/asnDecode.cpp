@@ -106,6 +106,17 @@ typedef struct
  */
 
 static asnHeader_t readHeader(uint8_t *der, uint16_t &pos, uint16_t length);
+static pemResult_t pemPutByte(pemDecoder_t *dec, uint8_t b);
+static int8_t base64Value(char c);
+
+/*
+ * Local variables
+ */
+
+static const char PEM_BEGIN[] PROGMEM = "-----BEGIN CERTIFICATE-----";
+static const char PEM_END[] PROGMEM = "-----END CERTIFICATE-----";
+
+static uint16_t pemMaxDerLength; // Limit of the DER buffer
 
 /*
  * Public functions
@@ -239,10 +250,191 @@ uint8_t *getCnFromDer(uint8_t *der, uint16_t length)
 	return nullptr;
 }
 
+/*
+ * Initializes the PEM decoder, the certificates longer than maxDerLength are refused
+ */
+void pemDecoderInit(pemDecoder_t *dec, uint16_t maxDerLength)
+{
+	memset(dec, 0, sizeof(pemDecoder_t));
+	dec->state = PEM_STATE_BEGIN;
+
+	pemMaxDerLength = maxDerLength;
+}
+
+/*
+ * Processes one character of the PEM certificate
+ * The newlines may be real or escaped (the characters '\' and 'n'), CR and spaces are ignored
+ */
+pemResult_t pemDecoderPut(pemDecoder_t *dec, char c)
+{
+	// Newlines
+	if (dec->backslash)
+	{
+		dec->backslash = false;
+
+		if (c != 'n')
+			return PEM_INVALID;
+
+		c = '\n';
+	}
+	else if (c == '\\')
+	{
+		dec->backslash = true;
+		return PEM_MORE;
+	}
+
+	bool whiteSpace = (c == '\n' || c == '\r' || c == ' ');
+
+	switch (dec->state)
+	{
+	case PEM_STATE_BEGIN:
+		if (whiteSpace && dec->markerPos == 0)
+			break;
+
+		if (c != (char)pgm_read_byte(PEM_BEGIN + dec->markerPos))
+			return PEM_INVALID;
+
+		if (++dec->markerPos == sizeof(PEM_BEGIN) - 1)
+			dec->state = PEM_STATE_BODY;
+		break;
+
+	case PEM_STATE_BODY:
+		if (whiteSpace || c == '=')
+			break;
+
+		if (c == '-')
+		{
+			dec->state = PEM_STATE_END;
+			dec->markerPos = 1;
+			break;
+		}
+
+		{
+			int8_t value = base64Value(c);
+
+			if (value < 0)
+				return PEM_INVALID;
+
+			dec->bits = (dec->bits << 6) | value;
+			dec->bitCount += 6;
+
+			if (dec->bitCount >= 8)
+			{
+				dec->bitCount -= 8;
+
+				pemResult_t res = pemPutByte(dec, (uint8_t)(dec->bits >> dec->bitCount));
+				if (res != PEM_MORE)
+					return res;
+			}
+		}
+		break;
+
+	case PEM_STATE_END:
+		if (c != (char)pgm_read_byte(PEM_END + dec->markerPos))
+			return PEM_INVALID;
+
+		if (++dec->markerPos == sizeof(PEM_END) - 1)
+		{
+			dec->state = PEM_STATE_DONE;
+
+			// The whole DER must be decoded
+			if (dec->derLength == 0 || dec->derPos != dec->derLength)
+				return PEM_INVALID;
+
+			return PEM_DONE;
+		}
+		break;
+
+	case PEM_STATE_DONE:
+		return PEM_DONE;
+	}
+
+	return PEM_MORE;
+}
+
+/*
+ * Frees the DER buffer
+ */
+void pemDecoderFree(pemDecoder_t *dec)
+{
+	delete[] dec->der;
+	dec->der = nullptr;
+	dec->derLength = 0;
+	dec->derPos = 0;
+}
+
 /*
  * Static functions
  */
 
+/*
+ * Writes a decoded byte to the DER buffer. The buffer is allocated when the length of the
+ * outer SEQUENCE is known (tag and 1 to 3 length bytes).
+ */
+static pemResult_t pemPutByte(pemDecoder_t *dec, uint8_t b)
+{
+	if (dec->der != nullptr)
+	{
+		if (dec->derPos >= dec->derLength)
+			return PEM_INVALID; // data after the certificate
+
+		dec->der[dec->derPos++] = b;
+		return PEM_MORE;
+	}
+
+	dec->head[dec->derPos++] = b;
+
+	if (dec->derPos < 2)
+		return PEM_MORE;
+
+	if (dec->head[0] != (ASN_SEQUENCE | ASN_CONSTRUCTED))
+		return PEM_INVALID;
+
+	uint32_t length;
+
+	if (dec->head[1] < 0x80)
+		length = dec->head[1] + 2;
+	else if (dec->head[1] == 0x81 && dec->derPos == 3)
+		length = dec->head[2] + 3;
+	else if (dec->head[1] == 0x82 && dec->derPos == 4)
+		length = ((dec->head[2] << 8) | dec->head[3]) + 4;
+	else if (dec->head[1] == 0x81 || dec->head[1] == 0x82)
+		return PEM_MORE; // the length is not complete
+	else
+		return PEM_INVALID;
+
+	if (length < dec->derPos || length > pemMaxDerLength)
+		return PEM_INVALID;
+
+	dec->der = new uint8_t[length];
+	if (dec->der == nullptr)
+		return PEM_OOM;
+
+	memcpy(dec->der, dec->head, dec->derPos);
+	dec->derLength = length;
+
+	return PEM_MORE;
+}
+
+/*
+ * Returns the value of a base64 character or -1
+ */
+static int8_t base64Value(char c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return c - 'A';
+	if (c >= 'a' && c <= 'z')
+		return c - 'a' + 26;
+	if (c >= '0' && c <= '9')
+		return c - '0' + 52;
+	if (c == '+')
+		return 62;
+	if (c == '/')
+		return 63;
+
+	return -1;
+}
+
 /*
  * Read ASN header record
  */
@@ -24,10 +24,51 @@
 
 #include "Arduino.h"
 
+/*
+ * Types
+ */
+
+enum pemState_t
+{
+	PEM_STATE_BEGIN = 0, // waiting for -----BEGIN CERTIFICATE-----
+	PEM_STATE_BODY,		 // decoding base64 data
+	PEM_STATE_END,		 // reading -----END CERTIFICATE-----
+	PEM_STATE_DONE
+};
+
+enum pemResult_t
+{
+	PEM_MORE = 0, // more characters expected
+	PEM_DONE,	  // the certificate is in the DER buffer
+	PEM_INVALID,  // invalid PEM or DER data
+	PEM_OOM		  // the DER buffer could not be allocated
+};
+
+/*
+ * State of the incremental PEM decoder. The DER buffer is allocated as soon as the ASN.1 header
+ * of the certificate gives its length, so no PEM text is kept in memory.
+ */
+typedef struct
+{
+	pemState_t state;
+	uint8_t markerPos; // Position in the BEGIN / END marker
+	bool backslash;	   // The previous character was '\' (an escaped "\n" newline)
+	uint32_t bits;	   // Decoded bits not yet written to the buffer
+	uint8_t bitCount;  // Number of bits in the 'bits'
+	uint8_t head[4];   // The first DER bytes until the length is known
+	uint8_t *der;	   // DER buffer
+	uint16_t derLength; // DER length, 0 = not known yet
+	uint16_t derPos;	// Number of DER bytes decoded
+} pemDecoder_t;
+
 /*
  * Public functions
  */
 
 uint8_t *getCnFromDer(uint8_t *der, uint16_t length);
 
+void pemDecoderInit(pemDecoder_t *dec, uint16_t maxDerLength);
+pemResult_t pemDecoderPut(pemDecoder_t *dec, char c);
+void pemDecoderFree(pemDecoder_t *dec);
+
 #endif /* ASNDECODE_H_ */
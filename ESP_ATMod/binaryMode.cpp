@@ -0,0 +1,311 @@
+/*
+ * binaryMode.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "ESP_ATMod.h"
+#include "binaryMode.h"
+#include "cpuFreq.h"
+#include "perf.h"
+#include "debug.h"
+
+/*
+ * Note: in the binary mode (AT+CIPBINMODE=1) the serial port carries only SLIP frames
+ *       <link ID>,<type>,<length>,<payload>,<CRC16>. The data of all links go both ways
+ *       without prompts and +IPD headers. The frames of the host are decoded into sendBuffer,
+ *       the frames of the module are encoded on the fly. The payload of a BIN_DATA frame of
+ *       the module is read into the free end of sendBuffer. Bytes outside a valid frame
+ *       (e.g. the WIFI ... messages) form an invalid frame, the other side ignores it.
+ *       The host cannot open links in the binary mode, it leaves the mode for AT+CIPSTART.
+ */
+
+/*
+ * Variables
+ */
+
+static uint16_t frameLen = 0;	 // Decoded bytes of the current frame in sendBuffer
+static bool frameEscape = false; // The previous byte was BIN_ESC
+static bool frameOverflow = false; // The frame is too long, it is dropped at BIN_END
+
+static_assert(BIN_HEADER_LEN + BIN_MAX_PAYLOAD + BIN_CRC_LEN <= UDP_MAX_LENGTH, "sendBuffer too small");
+
+/*
+ * Static functions
+ */
+
+static void processFrame();
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length);
+static void writeEncoded(const uint8_t *data, size_t length);
+
+/*
+ * Public functions
+ */
+
+/*
+ * Resets the frame decoder, called when the binary mode starts
+ */
+void binModeStart()
+{
+	frameLen = 0;
+	frameEscape = false;
+	frameOverflow = false;
+}
+
+/*
+ * Reads and decodes the frames of the host, called from loop()
+ */
+void binModeInput()
+{
+	int avail = Serial.available();
+
+	while (avail-- > 0 && gsFlag_Binary)
+	{
+		int c = Serial.read();
+
+		if (c < 0)
+			break;
+
+		if (c == BIN_END)
+		{
+			if (frameLen > 0 && frameOverflow)
+				binModeSendFrame(sendBuffer[0], BIN_ERROR, nullptr, 0);
+			else if (frameLen > 0)
+				processFrame();
+
+			binModeStart();
+			continue;
+		}
+
+		if (frameEscape)
+		{
+			frameEscape = false;
+
+			if (c == BIN_ESC_END)
+				c = BIN_END;
+			else if (c == BIN_ESC_ESC)
+				c = BIN_ESC;
+			else
+				frameOverflow = true; // Invalid escape, drop the frame
+		}
+		else if (c == BIN_ESC)
+		{
+			frameEscape = true;
+			continue;
+		}
+
+		if (frameLen < BIN_HEADER_LEN + BIN_MAX_PAYLOAD + BIN_CRC_LEN)
+			sendBuffer[frameLen++] = c;
+		else
+			frameOverflow = true;
+	}
+}
+
+/*
+ * Sends the data available on the link in a BIN_DATA frame
+ * A datagram goes in one frame (a longer one than BIN_MAX_PAYLOAD is dropped), the data of a TCP
+ * or SSL link in frames of at most BIN_MAX_PAYLOAD
+ */
+void binModeSendData(uint8_t linkId)
+{
+	WiFiClient *cli = clients[linkId].client;
+
+	if (cli == nullptr)
+		return;
+
+	int avail = cli->available();
+
+	if (avail <= 0)
+		return;
+
+	bool datagram = (clients[linkId].type == TYPE_UDP);
+
+	// The payload is read before the header, so the length field holds the bytes actually read.
+	// The end of sendBuffer after the frame of the host being decoded is free for it.
+	uint8_t *payload = sendBuffer + frameLen;
+	int room = _min(UDP_MAX_LENGTH - frameLen, BIN_MAX_PAYLOAD);
+
+	if (datagram && avail > BIN_MAX_PAYLOAD)
+	{
+		AT_DEBUG_PRINTF("--- datagram dropped: %d\r\n", avail);
+
+		// Only this datagram, available() goes on to the next one
+		while (avail > 0)
+		{
+			int rxBytes = cli->read(payload, _min(avail, room));
+
+			if (rxBytes <= 0)
+				break;
+
+			avail -= rxBytes;
+		}
+
+		return;
+	}
+
+	if (avail > room)
+	{
+		if (datagram)
+			return; // Waits for the end of the frame of the host
+
+		avail = room;
+	}
+
+	if (clients[linkId].type == TYPE_SSL || avail >= CPU_FREQ_BOOST_MIN_BYTES)
+		cpuFreqBoost();
+
+	int bytes = cli->read(payload, avail);
+
+	if (bytes <= 0)
+		return;
+
+	binModeSendFrame(linkId, BIN_DATA, payload, bytes);
+
+	PERF_LINK_IN(linkId, bytes);
+}
+
+/*
+ * Sends a frame to the host
+ */
+void binModeSendFrame(uint8_t linkId, uint8_t type, const uint8_t *payload, uint16_t length)
+{
+	uint8_t header[BIN_HEADER_LEN] = {linkId, type, (uint8_t)length, (uint8_t)(length >> 8)};
+	uint16_t crc = crc16(crc16(0xFFFF, header, sizeof(header)), payload, length);
+	uint8_t crcBytes[BIN_CRC_LEN] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+
+	SerialTx.write(BIN_END);
+	writeEncoded(header, sizeof(header));
+	writeEncoded(payload, length);
+	writeEncoded(crcBytes, sizeof(crcBytes));
+	SerialTx.write(BIN_END);
+}
+
+/*
+ * Static functions
+ */
+
+/*
+ * Checks and executes a decoded frame of the host
+ */
+static void processFrame()
+{
+	uint8_t linkId = sendBuffer[0];
+	uint8_t type = sendBuffer[1];
+	uint16_t length = sendBuffer[2] | (sendBuffer[3] << 8);
+
+	if (frameLen != BIN_HEADER_LEN + length + BIN_CRC_LEN ||
+		crc16(0xFFFF, sendBuffer, BIN_HEADER_LEN + length) != (sendBuffer[frameLen - 2] | (sendBuffer[frameLen - 1] << 8)))
+	{
+		binModeSendFrame(linkId, BIN_ERROR, nullptr, 0);
+		return;
+	}
+
+	if (type == BIN_EXIT)
+	{
+		AT_DEBUG_PRINT("--- binary mode off\r\n");
+
+		binModeSendFrame(0, BIN_EXIT, nullptr, 0);
+		gsFlag_Binary = false;
+		return;
+	}
+
+	WiFiClient *cli = (linkId < MAX_LINKS ? clients[linkId].client : nullptr);
+
+	if (cli == nullptr || (type != BIN_DATA && type != BIN_CLOSE))
+	{
+		binModeSendFrame(linkId, BIN_ERROR, nullptr, 0);
+		return;
+	}
+
+	if (type == BIN_CLOSE)
+	{
+		// The closing is reported by loop() with the BIN_CLOSE frame
+		cli->stop();
+		return;
+	}
+
+	if (clients[linkId].type == TYPE_SSL)
+		cpuFreqBoost();
+
+	PERF_START(writeStart);
+
+	bool sent = cli->connected() && cli->write(sendBuffer + BIN_HEADER_LEN, length) == length;
+
+	PERF_STOP(PERF_CLIENT_WRITE, writeStart);
+	PERF_LINK_OUT(linkId, length);
+
+	if (sent)
+	{
+		clients[linkId].lastActivityMillis = millis();
+		binModeSendFrame(linkId, BIN_SEND_OK, sendBuffer + 2, 2); // The length field
+	}
+	else
+	{
+		binModeSendFrame(linkId, BIN_SEND_FAIL, sendBuffer + 2, 2);
+	}
+}
+
+/*
+ * CRC-16/CCITT-FALSE (polynomial 0x1021), the initial value is 0xFFFF
+ */
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length)
+{
+	while (length-- > 0)
+	{
+		crc ^= (uint16_t)*data++ << 8;
+
+		for (uint8_t i = 0; i < 8; ++i)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+
+	return crc;
+}
+
+/*
+ * Writes the data to the serial port with the SLIP escapes
+ */
+static void writeEncoded(const uint8_t *data, size_t length)
+{
+	uint8_t out[64];
+	size_t n = 0;
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		uint8_t c = data[i];
+
+		if (c == BIN_END || c == BIN_ESC)
+		{
+			out[n++] = BIN_ESC;
+			c = (c == BIN_END ? BIN_ESC_END : BIN_ESC_ESC);
+		}
+
+		out[n++] = c;
+
+		if (n >= sizeof(out) - 1)
+		{
+			SerialTx.write(out, n);
+			n = 0;
+		}
+	}
+
+	if (n > 0)
+		SerialTx.write(out, n);
+}
@@ -0,0 +1,65 @@
+/*
+ * binaryMode.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYMODE_H_
+#define BINARYMODE_H_
+
+#include "Arduino.h"
+
+/*
+ * Defines
+ */
+
+// SLIP framing (RFC 1055), every frame starts and ends with BIN_END
+#define BIN_END 0xC0
+#define BIN_ESC 0xDB
+#define BIN_ESC_END 0xDC
+#define BIN_ESC_ESC 0xDD
+
+#define BIN_HEADER_LEN 4	  // <link ID>, <type>, <length> (2 bytes, little endian)
+#define BIN_CRC_LEN 2		  // CRC-16/CCITT-FALSE of the header and the payload, little endian
+#define BIN_MAX_PAYLOAD 2040 // The decoded frame is kept in sendBuffer
+
+/*
+ * Types
+ */
+
+enum binFrameType_t
+{
+	BIN_DATA = 0x01,	  // host: data for the link, module: data received from the link
+	BIN_CLOSE = 0x02,	  // host: close the link, module: the link is closed
+	BIN_CONNECT = 0x03,	  // module: a server accepted the link
+	BIN_SEND_OK = 0x04,	  // module: the data of the host were written, payload = length (2 bytes)
+	BIN_SEND_FAIL = 0x05, // module: writing the data failed
+	BIN_EXIT = 0x7F,	  // host: leave the binary mode, module: the binary mode ends
+	BIN_ERROR = 0xFF	  // module: invalid frame (CRC, length, link ID or type)
+};
+
+/*
+ * Public functions
+ */
+
+void binModeStart();
+void binModeInput();
+void binModeSendData(uint8_t linkId);
+void binModeSendFrame(uint8_t linkId, uint8_t type, const uint8_t *payload, uint16_t length);
+
+#endif /* BINARYMODE_H_ */
@@ -30,6 +30,15 @@
 #include "command.h"
 #include "settings.h"
 #include "asnDecode.h"
+#include "dnsCache.h"
+#include "sslSessionCache.h"
+#include "mflnCache.h"
+#include "perf.h"
+#include "cpuFreq.h"
+#include "binaryMode.h"
+#include "fastJoin.h"
+#include "scanCache.h"
+#include "udpClient.h"
 #include "debug.h"
 
 /*
@@ -53,90 +62,177 @@ enum cmdMode_t
 typedef struct
 {
 	const char *text;
+	const uint8_t len;	   // Length of the text
+	const uint8_t nameLen; // Length of the command name (text without the trailing '?')
+	const uint32_t hash;   // Hash of the command name
 	const cmdMode_t mode;
 	const commands_t cmd;
 } commandDef_t;
 
-static const commandDef_t commandList[] = {
-	{"+RST", MODE_EXACT_MATCH, CMD_AT_RST},
-	{"+GMR", MODE_EXACT_MATCH, CMD_AT_GMR},
-	{"E", MODE_NO_CHECKING, CMD_ATE},
-	{"+RESTORE", MODE_EXACT_MATCH, CMD_AT_RESTORE},
-	{"+UART", MODE_QUERY_SET, CMD_AT_UART},
-	{"+UART_CUR", MODE_QUERY_SET, CMD_AT_UART_CUR},
-	{"+UART_DEF", MODE_QUERY_SET, CMD_AT_UART_DEF},
-	{"+SYSRAM?", MODE_EXACT_MATCH, CMD_AT_SYSRAM},
-
-	{"+CWMODE", MODE_QUERY_SET, CMD_AT_CWMODE},
-	{"+CWMODE_CUR", MODE_QUERY_SET, CMD_AT_CWMODE_CUR},
-	{"+CWMODE_DEF", MODE_QUERY_SET, CMD_AT_CWMODE_DEF},
-	{"+CWJAP", MODE_QUERY_SET, CMD_AT_CWJAP},
-	{"+CWJAP_CUR", MODE_QUERY_SET, CMD_AT_CWJAP_CUR},
-	{"+CWJAP_DEF", MODE_QUERY_SET, CMD_AT_CWJAP_DEF},
-	{"+CWLAPOPT", MODE_QUERY_SET, CMD_AT_CWLAPOPT},
-	{"+CWLAP", MODE_EXACT_MATCH, CMD_AT_CWLAP},
-	{"+CWQAP", MODE_EXACT_MATCH, CMD_AT_CWQAP},
-	{"+CWSAP", MODE_QUERY_SET, CMD_AT_CWSAP},
-	{"+CWSAP_CUR", MODE_QUERY_SET, CMD_AT_CWSAP_CUR},
-	{"+CWSAP_DEF", MODE_QUERY_SET, CMD_AT_CWSAP_DEF},
-	{"+CWDHCP", MODE_QUERY_SET, CMD_AT_CWDHCP},
-	{"+CWDHCP_CUR", MODE_QUERY_SET, CMD_AT_CWDHCP_CUR},
-	{"+CWDHCP_DEF", MODE_QUERY_SET, CMD_AT_CWDHCP_DEF},
-	{"+CWAUTOCONN", MODE_QUERY_SET, CMD_AT_CWAUTOCONN},
-	{"+CIPSTAMAC", MODE_QUERY_SET, CMD_AT_CIPSTAMAC},
-	{"+CIPSTAMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPSTAMAC_CUR},
-	{"+CIPSTAMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPSTAMAC_DEF},
-	{"+CIPAPMAC", MODE_QUERY_SET, CMD_AT_CIPAPMAC},
-	{"+CIPAPMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPAPMAC_CUR},
-	{"+CIPAPMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPAPMAC_DEF},
-	{"+CIPSTA", MODE_QUERY_SET, CMD_AT_CIPSTA},
-	{"+CIPSTA_CUR", MODE_QUERY_SET, CMD_AT_CIPSTA_CUR},
-	{"+CIPSTA_DEF", MODE_QUERY_SET, CMD_AT_CIPSTA_DEF},
-	{"+CIPAP", MODE_QUERY_SET, CMD_AT_CIPAP},
-	{"+CIPAP_CUR", MODE_QUERY_SET, CMD_AT_CIPAP_CUR},
-	{"+CIPAP_DEF", MODE_QUERY_SET, CMD_AT_CIPAP_DEF},
-	{"+CWHOSTNAME", MODE_QUERY_SET, CMD_AT_CWHOSTNAME},
+/*
+ * The command name consists of alphabetic characters, '+' and '_'
+ */
+static constexpr bool isCommandNameChar(char c)
+{
+	return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '+' || c == '_';
+}
+
+static constexpr uint8_t commandNameLen(const char *text)
+{
+	uint8_t len = 0;
+
+	while (isCommandNameChar(text[len]))
+		++len;
+
+	return len;
+}
+
+/*
+ * FNV-1a hash of the command name
+ */
+static constexpr uint32_t commandHash(const char *name, uint16_t len)
+{
+	uint32_t hash = 2166136261u;
+
+	for (uint16_t i = 0; i < len; ++i)
+		hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+
+	return hash;
+}
+
+#define COMMAND_DEF(text, mode, cmd) {text, sizeof(text) - 1, commandNameLen(text), commandHash(text, commandNameLen(text)), mode, cmd}
+
+static constexpr commandDef_t commandList[] = {
+	COMMAND_DEF("+RST", MODE_EXACT_MATCH, CMD_AT_RST),
+	COMMAND_DEF("+GMR", MODE_EXACT_MATCH, CMD_AT_GMR),
+	COMMAND_DEF("E", MODE_NO_CHECKING, CMD_ATE),
+	COMMAND_DEF("+RESTORE", MODE_EXACT_MATCH, CMD_AT_RESTORE),
+	COMMAND_DEF("+UART", MODE_QUERY_SET, CMD_AT_UART),
+	COMMAND_DEF("+UART_CUR", MODE_QUERY_SET, CMD_AT_UART_CUR),
+	COMMAND_DEF("+UART_DEF", MODE_QUERY_SET, CMD_AT_UART_DEF),
+	COMMAND_DEF("+SYSRAM?", MODE_EXACT_MATCH, CMD_AT_SYSRAM),
+
+	COMMAND_DEF("+CWMODE", MODE_QUERY_SET, CMD_AT_CWMODE),
+	COMMAND_DEF("+CWMODE_CUR", MODE_QUERY_SET, CMD_AT_CWMODE_CUR),
+	COMMAND_DEF("+CWMODE_DEF", MODE_QUERY_SET, CMD_AT_CWMODE_DEF),
+	COMMAND_DEF("+CWJAP", MODE_QUERY_SET, CMD_AT_CWJAP),
+	COMMAND_DEF("+CWJAP_CUR", MODE_QUERY_SET, CMD_AT_CWJAP_CUR),
+	COMMAND_DEF("+CWJAP_DEF", MODE_QUERY_SET, CMD_AT_CWJAP_DEF),
+	COMMAND_DEF("+CWLAPOPT", MODE_QUERY_SET, CMD_AT_CWLAPOPT),
+	COMMAND_DEF("+CWLAP", MODE_NO_CHECKING, CMD_AT_CWLAP),
+	COMMAND_DEF("+CWQAP", MODE_EXACT_MATCH, CMD_AT_CWQAP),
+	COMMAND_DEF("+CWSAP", MODE_QUERY_SET, CMD_AT_CWSAP),
+	COMMAND_DEF("+CWSAP_CUR", MODE_QUERY_SET, CMD_AT_CWSAP_CUR),
+	COMMAND_DEF("+CWSAP_DEF", MODE_QUERY_SET, CMD_AT_CWSAP_DEF),
+	COMMAND_DEF("+CWDHCP", MODE_QUERY_SET, CMD_AT_CWDHCP),
+	COMMAND_DEF("+CWDHCP_CUR", MODE_QUERY_SET, CMD_AT_CWDHCP_CUR),
+	COMMAND_DEF("+CWDHCP_DEF", MODE_QUERY_SET, CMD_AT_CWDHCP_DEF),
+	COMMAND_DEF("+CWAUTOCONN", MODE_QUERY_SET, CMD_AT_CWAUTOCONN),
+	COMMAND_DEF("+CIPSTAMAC", MODE_QUERY_SET, CMD_AT_CIPSTAMAC),
+	COMMAND_DEF("+CIPSTAMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPSTAMAC_CUR),
+	COMMAND_DEF("+CIPSTAMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPSTAMAC_DEF),
+	COMMAND_DEF("+CIPAPMAC", MODE_QUERY_SET, CMD_AT_CIPAPMAC),
+	COMMAND_DEF("+CIPAPMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPAPMAC_CUR),
+	COMMAND_DEF("+CIPAPMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPAPMAC_DEF),
+	COMMAND_DEF("+CIPSTA", MODE_QUERY_SET, CMD_AT_CIPSTA),
+	COMMAND_DEF("+CIPSTA_CUR", MODE_QUERY_SET, CMD_AT_CIPSTA_CUR),
+	COMMAND_DEF("+CIPSTA_DEF", MODE_QUERY_SET, CMD_AT_CIPSTA_DEF),
+	COMMAND_DEF("+CIPAP", MODE_QUERY_SET, CMD_AT_CIPAP),
+	COMMAND_DEF("+CIPAP_CUR", MODE_QUERY_SET, CMD_AT_CIPAP_CUR),
+	COMMAND_DEF("+CIPAP_DEF", MODE_QUERY_SET, CMD_AT_CIPAP_DEF),
+	COMMAND_DEF("+CWHOSTNAME", MODE_QUERY_SET, CMD_AT_CWHOSTNAME),
 #ifdef ETHERNET_CLASS
-	{"+CIPETHMAC", MODE_QUERY_SET, CMD_AT_CIPETHMAC},
-	{"+CIPETHMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPETHMAC_CUR},
-	{"+CIPETHMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPETHMAC_DEF},
-	{"+CIPETH", MODE_QUERY_SET, CMD_AT_CIPETH},
-	{"+CIPETH_CUR", MODE_QUERY_SET, CMD_AT_CIPETH_CUR},
-	{"+CIPETH_DEF", MODE_QUERY_SET, CMD_AT_CIPETH_DEF},
-	{"+CEHOSTNAME", MODE_QUERY_SET, CMD_AT_CEHOSTNAME},
+	COMMAND_DEF("+CIPETHMAC", MODE_QUERY_SET, CMD_AT_CIPETHMAC),
+	COMMAND_DEF("+CIPETHMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPETHMAC_CUR),
+	COMMAND_DEF("+CIPETHMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPETHMAC_DEF),
+	COMMAND_DEF("+CIPETH", MODE_QUERY_SET, CMD_AT_CIPETH),
+	COMMAND_DEF("+CIPETH_CUR", MODE_QUERY_SET, CMD_AT_CIPETH_CUR),
+	COMMAND_DEF("+CIPETH_DEF", MODE_QUERY_SET, CMD_AT_CIPETH_DEF),
+	COMMAND_DEF("+CEHOSTNAME", MODE_QUERY_SET, CMD_AT_CEHOSTNAME),
+	COMMAND_DEF("+CIPETHCFG", MODE_QUERY_SET, CMD_AT_CIPETHCFG),
 #endif
 
-	{"+CIPSTATUS", MODE_EXACT_MATCH, CMD_AT_CIPSTATUS},
-	{"+CIPDOMAIN", MODE_NO_CHECKING, CMD_AT_CIPDOMAIN},
-	{"+CIPSTART", MODE_NO_CHECKING, CMD_AT_CIPSTART},
-	{"+CIPSSLSIZE", MODE_QUERY_SET, CMD_AT_CIPSSLSIZE},
-	{"+CIPSEND", MODE_NO_CHECKING, CMD_AT_CIPSEND},
-	{"+CIPCLOSEMODE", MODE_NO_CHECKING, CMD_AT_CIPCLOSEMODE},
-	{"+CIPCLOSE", MODE_NO_CHECKING, CMD_AT_CIPCLOSE},
-	{"+CIFSR", MODE_EXACT_MATCH, CMD_AT_CIFSR},
-	{"+CIPMUX", MODE_QUERY_SET, CMD_AT_CIPMUX},
-	{"+CIPDINFO", MODE_QUERY_SET, CMD_AT_CIPDINFO},
-	{"+CIPSERVER", MODE_NO_CHECKING, CMD_AT_CIPSERVER},
-	{"+CIPSERVERMAXCONN", MODE_QUERY_SET, CMD_AT_CIPSERVERMAXCONN},
-	{"+CIPSTO", MODE_QUERY_SET, CMD_AT_CIPSTO},
-	{"+CIPRECVMODE", MODE_QUERY_SET, CMD_AT_CIPRECVMODE},
-	{"+CIPRECVDATA", MODE_QUERY_SET, CMD_AT_CIPRECVDATA},
-	{"+CIPRECVLEN", MODE_QUERY_SET, CMD_AT_CIPRECVLEN},
-	{"+CIPSNTPCFG", MODE_QUERY_SET, CMD_AT_CIPSNTPCFG},
-	{"+CIPSNTPTIME?", MODE_EXACT_MATCH, CMD_AT_CIPSNTPTIME},
-	{"+CIPDNS", MODE_QUERY_SET, CMD_AT_CIPDNS},
-	{"+CIPDNS_CUR", MODE_QUERY_SET, CMD_AT_CIPDNS_CUR},
-	{"+CIPDNS_DEF", MODE_QUERY_SET, CMD_AT_CIPDNS_DEF},
-
-	{"+SYSCPUFREQ", MODE_QUERY_SET, CMD_AT_SYSCPUFREQ},
-	{"+RFMODE", MODE_QUERY_SET, CMD_AT_RFMODE},
-	{"+CIPSSLAUTH", MODE_QUERY_SET, CMD_AT_CIPSSLAUTH},
-	{"+CIPSSLFP", MODE_QUERY_SET, CMD_AT_CIPSSLFP},
-	{"+CIPSSLCERTMAX", MODE_QUERY_SET, CMD_AT_CIPSSLCERTMAX},
-	{"+CIPSSLCERT", MODE_NO_CHECKING, CMD_AT_CIPSSLCERT},
-	{"+CIPSSLMFLN", MODE_QUERY_SET, CMD_AT_CIPSSLMFLN},
-	{"+CIPSSLSTA", MODE_NO_CHECKING, CMD_AT_CIPSSLSTA},
-	{"+SNTPTIME?", MODE_EXACT_MATCH, CMD_AT_SNTPTIME}};
+	COMMAND_DEF("+CIPSTATUS", MODE_EXACT_MATCH, CMD_AT_CIPSTATUS),
+	COMMAND_DEF("+CIPDOMAIN", MODE_NO_CHECKING, CMD_AT_CIPDOMAIN),
+	COMMAND_DEF("+CIPSTART", MODE_NO_CHECKING, CMD_AT_CIPSTART),
+	COMMAND_DEF("+CIPSSLSIZE", MODE_QUERY_SET, CMD_AT_CIPSSLSIZE),
+	COMMAND_DEF("+CIPSEND", MODE_NO_CHECKING, CMD_AT_CIPSEND),
+	COMMAND_DEF("+CIPSENDBUF", MODE_QUERY_SET, CMD_AT_CIPSENDBUF),
+	COMMAND_DEF("+CIPBUFSTATUS", MODE_NO_CHECKING, CMD_AT_CIPBUFSTATUS),
+	COMMAND_DEF("+CIPCLOSEMODE", MODE_NO_CHECKING, CMD_AT_CIPCLOSEMODE),
+	COMMAND_DEF("+CIPCLOSE", MODE_NO_CHECKING, CMD_AT_CIPCLOSE),
+	COMMAND_DEF("+CIFSR", MODE_EXACT_MATCH, CMD_AT_CIFSR),
+	COMMAND_DEF("+CIPMUX", MODE_QUERY_SET, CMD_AT_CIPMUX),
+	COMMAND_DEF("+CIPDINFO", MODE_QUERY_SET, CMD_AT_CIPDINFO),
+	COMMAND_DEF("+CIPSERVER", MODE_NO_CHECKING, CMD_AT_CIPSERVER),
+	COMMAND_DEF("+CIPSERVERMAXCONN", MODE_QUERY_SET, CMD_AT_CIPSERVERMAXCONN),
+	COMMAND_DEF("+CIPSTO", MODE_QUERY_SET, CMD_AT_CIPSTO),
+	COMMAND_DEF("+CIPMODE", MODE_QUERY_SET, CMD_AT_CIPMODE),
+	COMMAND_DEF("+CIPRECVMODE", MODE_QUERY_SET, CMD_AT_CIPRECVMODE),
+	COMMAND_DEF("+CIPRECVDATA", MODE_QUERY_SET, CMD_AT_CIPRECVDATA),
+	COMMAND_DEF("+CIPRECVLEN", MODE_QUERY_SET, CMD_AT_CIPRECVLEN),
+	COMMAND_DEF("+CIPSNTPCFG", MODE_QUERY_SET, CMD_AT_CIPSNTPCFG),
+	COMMAND_DEF("+CIPSNTPTIME?", MODE_EXACT_MATCH, CMD_AT_CIPSNTPTIME),
+	COMMAND_DEF("+CIPDNS", MODE_QUERY_SET, CMD_AT_CIPDNS),
+	COMMAND_DEF("+CIPDNS_CUR", MODE_QUERY_SET, CMD_AT_CIPDNS_CUR),
+	COMMAND_DEF("+CIPDNS_DEF", MODE_QUERY_SET, CMD_AT_CIPDNS_DEF),
+	COMMAND_DEF("+CIPDNSCACHE", MODE_QUERY_SET, CMD_AT_CIPDNSCACHE),
+
+	COMMAND_DEF("+SYSCPUFREQ", MODE_QUERY_SET, CMD_AT_SYSCPUFREQ),
+	COMMAND_DEF("+UARTBUF", MODE_QUERY_SET, CMD_AT_UARTBUF),
+	COMMAND_DEF("+SYSSAVE", MODE_EXACT_MATCH, CMD_AT_SYSSAVE),
+	COMMAND_DEF("+SYSHEAP?", MODE_EXACT_MATCH, CMD_AT_SYSHEAP),
+	COMMAND_DEF("+SYSPERF", MODE_QUERY_SET, CMD_AT_SYSPERF),
+	COMMAND_DEF("+RFMODE", MODE_QUERY_SET, CMD_AT_RFMODE),
+	COMMAND_DEF("+CIPSERVERCFG", MODE_QUERY_SET, CMD_AT_CIPSERVERCFG),
+	COMMAND_DEF("+CIPRECVCOALESCE", MODE_QUERY_SET, CMD_AT_CIPRECVCOALESCE),
+	COMMAND_DEF("+CIPTCPOPT", MODE_QUERY_SET, CMD_AT_CIPTCPOPT),
+	COMMAND_DEF("+CIPBINMODE", MODE_QUERY_SET, CMD_AT_CIPBINMODE),
+	COMMAND_DEF("+CIPSENDMULTI", MODE_QUERY_SET, CMD_AT_CIPSENDMULTI),
+	COMMAND_DEF("+CWFASTJOIN", MODE_QUERY_SET, CMD_AT_CWFASTJOIN),
+	COMMAND_DEF("+CWLAPCACHE", MODE_QUERY_SET, CMD_AT_CWLAPCACHE),
+	COMMAND_DEF("+CIPSSLAUTH", MODE_QUERY_SET, CMD_AT_CIPSSLAUTH),
+	COMMAND_DEF("+CIPSSLFP", MODE_QUERY_SET, CMD_AT_CIPSSLFP),
+	COMMAND_DEF("+CIPSSLCERTMAX", MODE_QUERY_SET, CMD_AT_CIPSSLCERTMAX),
+	COMMAND_DEF("+CIPSSLCERT", MODE_NO_CHECKING, CMD_AT_CIPSSLCERT),
+	COMMAND_DEF("+CIPSSLMFLN", MODE_QUERY_SET, CMD_AT_CIPSSLMFLN),
+	COMMAND_DEF("+CIPSSLSTA", MODE_NO_CHECKING, CMD_AT_CIPSSLSTA),
+	COMMAND_DEF("+CIPSSLSESS", MODE_QUERY_SET, CMD_AT_CIPSSLSESS),
+	COMMAND_DEF("+SNTPTIME?", MODE_EXACT_MATCH, CMD_AT_SNTPTIME)};
+
+static constexpr uint16_t COMMAND_COUNT = sizeof(commandList) / sizeof(commandDef_t);
+
+/*
+ * Open addressing hash index of the command list, built at compile time
+ * The slot contains the command list index + 1, 0 is an empty slot
+ */
+static constexpr uint16_t COMMAND_INDEX_SIZE = 256; // Power of 2
+
+static_assert(COMMAND_COUNT < 255 && 2 * COMMAND_COUNT <= COMMAND_INDEX_SIZE, "Command index too small");
+
+typedef struct
+{
+	uint8_t slot[COMMAND_INDEX_SIZE];
+} commandIndex_t;
+
+static constexpr commandIndex_t buildCommandIndex()
+{
+	commandIndex_t index = {};
+
+	for (uint16_t i = 0; i < COMMAND_COUNT; ++i)
+	{
+		uint16_t h = commandList[i].hash & (COMMAND_INDEX_SIZE - 1);
+
+		while (index.slot[h] != 0)
+			h = (h + 1) & (COMMAND_INDEX_SIZE - 1);
+
+		index.slot[h] = i + 1;
+	}
+
+	return index;
+}
+
+static constexpr commandIndex_t commandIndex = buildCommandIndex();
 
 /*
  * Static functions
@@ -146,11 +242,14 @@ commands_t findCommand(uint8_t *input, uint16_t inpLen);
 String readStringFromBuffer(unsigned char *inpBuf, uint16_t &offset, bool escape, bool allowEmpty = false);
 bool readNumber(unsigned char *inpBuf, uint16_t &offset, uint32_t &output);
 bool readIpAddress(unsigned char *inpBuf, uint16_t &offset, uint32_t &output);
+bool readLinkId(unsigned char *inpBuf, uint16_t &offset, uint8_t &linkId);
 uint8_t readHex(char c);
 void printCertificateName(uint8_t certNumber);
 int compWifiRssi(const void *elem1, const void *elem2);
-void printCWLAP(int networksFound);
-void printScanResult(int networksFound);
+void printCWLAP(int indices[], size_t size);
+void printScanResult();
+static bool blockedByScan(commands_t cmd);
+void printLinkOptions(uint8_t linkId);
 
 /*
  * Variables
@@ -159,6 +258,10 @@ uint32_t sort_enable = 0;
 uint32_t printMask = 0x7FF;
 int rssiFilter = -100;
 uint32_t authmodeMask = 0xFFFF;
+static char cwlapSsid[33];		// AT+CWLAP=<ssid>,<mac>,<channel> filter, empty = all
+static uint8_t cwlapBssid[6];
+static bool cwlapBssidSet = false;
+static uint8_t cwlapChannel = 0;	// 0 = all
 
 /*
  * Commands
@@ -188,6 +291,7 @@ static void cmd_AT_CWHOSTNAME();
 static void cmd_AT_CIPETHMAC(commands_t cmd);
 static void cmd_AT_CIPETH(commands_t cmd);
 static void cmd_AT_CEHOSTNAME();
+static void cmd_AT_CIPETHCFG();
 #endif
 
 static void cmd_AT_CIPSTATUS();
@@ -195,6 +299,8 @@ static void cmd_AT_CIPDOMAIN();
 static void cmd_AT_CIPSTART();
 static void cmd_AT_CIPSSLSIZE();
 static void cmd_AT_CIPSEND();
+static void cmd_AT_CIPSENDBUF();
+static void cmd_AT_CIPBUFSTATUS();
 static void cmd_AT_CIPCLOSEMODE();
 static void cmd_AT_CIPCLOSE();
 static void cmd_AT_CIFSR();
@@ -202,6 +308,7 @@ static void cmd_AT_CIPMUX();
 static void cmd_AT_CIPSERVER();
 static void cmd_AT_CIPSERVERMAXCONN();
 static void cmd_AT_CIPSTO();
+static void cmd_AT_CIPMODE();
 static void cmd_AT_CIPDINFO();
 static void cmd_AT_CIPRECVMODE();
 static void cmd_AT_CIPRECVDATA();
@@ -209,15 +316,28 @@ static void cmd_AT_CIPRECVLEN();
 static void cmd_AT_CIPSNTPCFG();
 static void cmd_AT_CIPSNTPTIME();
 static void cmd_AT_CIPDNS(commands_t cmd);
+static void cmd_AT_CIPDNSCACHE();
 
 static void cmd_AT_SYSCPUFREQ();
+static void cmd_AT_UARTBUF();
+static void cmd_AT_SYSSAVE();
+static void cmd_AT_SYSHEAP();
+static void cmd_AT_SYSPERF();
 static void cmd_AT_RFMODE();
+static void cmd_AT_CIPSERVERCFG();
+static void cmd_AT_CIPRECVCOALESCE();
+static void cmd_AT_CIPTCPOPT();
+static void cmd_AT_CIPBINMODE();
+static void cmd_AT_CIPSENDMULTI();
+static void cmd_AT_CWFASTJOIN();
+static void cmd_AT_CWLAPCACHE();
 static void cmd_AT_CIPSSLAUTH();
 static void cmd_AT_CIPSSLFP();
 static void cmd_AT_CIPSSLCERTMAX();
 static void cmd_AT_CIPSSLCERT();
 static void cmd_AT_CIPSSLMFLN();
 static void cmd_AT_CIPSSLSTA();
+static void cmd_AT_CIPSSLSESS();
 static void cmd_AT_SNTPTIME();
 
 /*
@@ -227,231 +347,401 @@ void processCommandBuffer(void)
 {
 	commands_t cmd = findCommand(inputBuffer, inputBufferCnt);
 
+	// A running AT+CWLAP scan holds only the commands changing the Wi-Fi state, the links keep working
+	if (scanCacheIsRunning() && blockedByScan(cmd))
+	{
+		SerialTx.println(F("\r\nbusy p..."));
+		PERF_COUNT(PERF_BUSY);
+		return;
+	}
+
+	switch (cmd)
+	{
 	// ------------------------------------------------------------------------------------ AT
-	if (cmd == CMD_AT)
+	case CMD_AT:
 		cmd_AT();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+RST
-	else if (cmd == CMD_AT_RST) // AT+RST - soft reset
+	case CMD_AT_RST: // AT+RST - soft reset
 		cmd_AT_RST();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+GMR
-	else if (cmd == CMD_AT_GMR) // AT+GMR - firmware version
+	case CMD_AT_GMR: // AT+GMR - firmware version
 		cmd_AT_GMR();
+		break;
 
 	// ------------------------------------------------------------------------------------ ATE
-	else if (cmd == CMD_ATE) // ATE0, ATE1 - echo enabled / disabled
+	case CMD_ATE: // ATE0, ATE1 - echo enabled / disabled
 		cmd_ATE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+RESTORE
-	else if (cmd == CMD_AT_RESTORE) // AT+RESTORE - Restores the Factory Default Settings
+	case CMD_AT_RESTORE: // AT+RESTORE - Restores the Factory Default Settings
 		cmd_AT_RESTORE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+UART
-	else if (cmd == CMD_AT_UART || cmd == CMD_AT_UART_CUR || cmd == CMD_AT_UART_DEF)
+	case CMD_AT_UART:
+	case CMD_AT_UART_CUR:
+	case CMD_AT_UART_DEF:
 		// AT+UART=baudrate,databits,stopbits,parity,flow - UART Configuration
 		cmd_AT_UART(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+SYSRAM
-	else if (cmd == CMD_AT_SYSRAM) // AT+SYSRAM? - Checks the Remaining Space of RAM
+	case CMD_AT_SYSRAM: // AT+SYSRAM? - Checks the Remaining Space of RAM
 		cmd_AT_SYSRAM();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWMODE
-	else if (cmd == CMD_AT_CWMODE || cmd == CMD_AT_CWMODE_CUR || cmd == CMD_AT_CWMODE_DEF)
+	case CMD_AT_CWMODE:
+	case CMD_AT_CWMODE_CUR:
+	case CMD_AT_CWMODE_DEF:
 		// AT+CWMODE - Sets the Current Wi-Fi mode
 		cmd_AT_CWMODE(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWJAP
-	else if (cmd == CMD_AT_CWJAP || cmd == CMD_AT_CWJAP_CUR || cmd == CMD_AT_CWJAP_DEF)
+	case CMD_AT_CWJAP:
+	case CMD_AT_CWJAP_CUR:
+	case CMD_AT_CWJAP_DEF:
 		// AT+CWJAP="ssid","pwd" [,"bssid"] - Connects to an AP, only ssid, pwd and bssid supported
 		cmd_AT_CWJAP(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWLAPOPT
-	else if (cmd == CMD_AT_CWLAPOPT) // AT+CWLAPOPT - Set the configuration for the command AT+CWLAP.
+	case CMD_AT_CWLAPOPT: // AT+CWLAPOPT - Set the configuration for the command AT+CWLAP.
 		cmd_AT_CWLAPOPT();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWLAP
-	else if (cmd == CMD_AT_CWLAP) // AT+CWLAP - List available APs.
+	case CMD_AT_CWLAP: // AT+CWLAP - List available APs.
 		cmd_AT_CWLAP();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWQAP
-	else if (cmd == CMD_AT_CWQAP) // AT+CWQAP - Disconnects from the AP
+	case CMD_AT_CWQAP: // AT+CWQAP - Disconnects from the AP
 		cmd_AT_CWQAP();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWSAP
-	else if (cmd == CMD_AT_CWSAP || cmd == CMD_AT_CWSAP_CUR || cmd == CMD_AT_CWSAP_DEF)
+	case CMD_AT_CWSAP:
+	case CMD_AT_CWSAP_CUR:
+	case CMD_AT_CWSAP_DEF:
 		// AT+CWSAP="ssid","pwd",chl,ecn [,max conm, ssid hidden] - Function: to configure the SoftA
 		cmd_AT_CWSAP(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWDHCP
-	else if (cmd == CMD_AT_CWDHCP || cmd == CMD_AT_CWDHCP_CUR || cmd == CMD_AT_CWDHCP_DEF)
+	case CMD_AT_CWDHCP:
+	case CMD_AT_CWDHCP_CUR:
+	case CMD_AT_CWDHCP_DEF:
 		// AT+CWDHCP=x,y - Enables/Disables DHCP
 		cmd_AT_CWDHCP(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWAUTOCONN
-	else if (cmd == CMD_AT_CWAUTOCONN) // AT+CWAUTOCONN - auto connect to AP
+	case CMD_AT_CWAUTOCONN: // AT+CWAUTOCONN - auto connect to AP
 		cmd_AT_CWAUTOCONN();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSTAMAC
-	else if (cmd == CMD_AT_CIPSTAMAC || cmd == CMD_AT_CIPSTAMAC_CUR || cmd == CMD_AT_CIPSTAMAC_DEF)
+	case CMD_AT_CIPSTAMAC:
+	case CMD_AT_CIPSTAMAC_CUR:
+	case CMD_AT_CIPSTAMAC_DEF:
 		// AT+CIPSTAMAC - Sets or prints the MAC Address of the ESP8266 Station
 		cmd_AT_CIPXXMAC(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPAPMAC
-	else if (cmd == CMD_AT_CIPAPMAC || cmd == CMD_AT_CIPAPMAC_CUR || cmd == CMD_AT_CIPAPMAC_DEF)
+	case CMD_AT_CIPAPMAC:
+	case CMD_AT_CIPAPMAC_CUR:
+	case CMD_AT_CIPAPMAC_DEF:
 		// AT+CIPAPMAC - Sets or prints the MAC Address of the ESP8266 SoftAP
 		cmd_AT_CIPXXMAC(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSTA
-	else if (cmd == CMD_AT_CIPSTA || cmd == CMD_AT_CIPSTA_CUR || cmd == CMD_AT_CIPSTA_DEF)
+	case CMD_AT_CIPSTA:
+	case CMD_AT_CIPSTA_CUR:
+	case CMD_AT_CIPSTA_DEF:
 		// AT+CIPSTA - Sets or prints the network configuration
 		cmd_AT_CIPSTA(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPAP
-	else if (cmd == CMD_AT_CIPAP || cmd == CMD_AT_CIPAP_CUR || cmd == CMD_AT_CIPAP_DEF)
+	case CMD_AT_CIPAP:
+	case CMD_AT_CIPAP_CUR:
+	case CMD_AT_CIPAP_DEF:
 		// AT+CIPAP - Sets or prints the SoftAP configuration
 		cmd_AT_CIPAP(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CWHOSTNAME
-	else if (cmd == CMD_AT_CWHOSTNAME)
+	case CMD_AT_CWHOSTNAME:
 		// AT+CWHOSTNAME - Query/Set the host name of an ESP station
 		cmd_AT_CWHOSTNAME();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSTATUS
-	else if (cmd == CMD_AT_CIPSTATUS) // AT+CIPSTATUS - Gets the Connection Status
+	case CMD_AT_CIPSTATUS: // AT+CIPSTATUS - Gets the Connection Status
 		cmd_AT_CIPSTATUS();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPDOMAIN
-	else if (cmd == CMD_AT_CIPDOMAIN) // AT+CIPDOMAIN - resolves a hostname to IP address with DNS
+	case CMD_AT_CIPDOMAIN: // AT+CIPDOMAIN - resolves a hostname to IP address with DNS
 		cmd_AT_CIPDOMAIN();
+		break;
 
 #ifdef ETHERNET_CLASS
 	// ------------------------------------------------------------------------------------ AT+CIPETHMAC
-	else if (cmd == CMD_AT_CIPETHMAC || cmd == CMD_AT_CIPETHMAC_CUR || cmd == CMD_AT_CIPETHMAC_DEF)
+	case CMD_AT_CIPETHMAC:
+	case CMD_AT_CIPETHMAC_CUR:
+	case CMD_AT_CIPETHMAC_DEF:
 		// AT+CIPETHMAC - Sets or prints the MAC Address of the Ethernet interace
 		cmd_AT_CIPETHMAC(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPETH
-	else if (cmd == CMD_AT_CIPETH || cmd == CMD_AT_CIPETH_CUR || cmd == CMD_AT_CIPETH_DEF)
+	case CMD_AT_CIPETH:
+	case CMD_AT_CIPETH_CUR:
+	case CMD_AT_CIPETH_DEF:
 		// AT+CIPETH - Sets or prints the Ethernet configuration
 		cmd_AT_CIPETH(cmd);
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CEHOSTNAME
-	else if (cmd == CMD_AT_CEHOSTNAME)
+	case CMD_AT_CEHOSTNAME:
 		// AT+CEHOSTNAME - Query/Set the host name of the Ethernet interface
 		cmd_AT_CEHOSTNAME();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPETHCFG
+	case CMD_AT_CIPETHCFG:
+		// AT+CIPETHCFG - SPI clock and INT pin of the Ethernet chip
+		cmd_AT_CIPETHCFG();
+		break;
 #endif
 
 	// ------------------------------------------------------------------------------------ AT+CIPSTART
-	else if (cmd == CMD_AT_CIPSTART)
+	case CMD_AT_CIPSTART:
 		// AT+CIPSTART - Establishes TCP Connection, UDP Transmission or SSL Connection
 		cmd_AT_CIPSTART();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLSIZE
-	else if (cmd == CMD_AT_CIPSSLSIZE)
+	case CMD_AT_CIPSSLSIZE:
 		// AT+CIPSSLSIZE - Sets the Size of SSL Buffer - the command is parsed but ignored
 		cmd_AT_CIPSSLSIZE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSEND
-	else if (cmd == CMD_AT_CIPSEND) // AT+CIPSEND - Sends Data
+	case CMD_AT_CIPSEND: // AT+CIPSEND - Sends Data
 		cmd_AT_CIPSEND();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPSENDBUF
+	case CMD_AT_CIPSENDBUF: // AT+CIPSENDBUF - Writes Data into the TCP-Send-Buffer
+		cmd_AT_CIPSENDBUF();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPBUFSTATUS
+	case CMD_AT_CIPBUFSTATUS: // AT+CIPBUFSTATUS - Checks the Status of the TCP-Send-Buffer
+		cmd_AT_CIPBUFSTATUS();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPCLOSE
-	else if (cmd == CMD_AT_CIPCLOSEMODE) // AT+CIPCLOSEMODE - Defines the closing mode - parsed but ignored for now
+	case CMD_AT_CIPCLOSEMODE: // AT+CIPCLOSEMODE - Defines the closing mode - parsed but ignored for now
 		cmd_AT_CIPCLOSEMODE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPCLOSE
-	else if (cmd == CMD_AT_CIPCLOSE) // AT+CIPCLOSE - Closes the TCP/UDP/SSL Connection
+	case CMD_AT_CIPCLOSE: // AT+CIPCLOSE - Closes the TCP/UDP/SSL Connection
 		cmd_AT_CIPCLOSE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIFSR
-	else if (cmd == CMD_AT_CIFSR) // AT+CIFSR - Gets the Local IP Address
+	case CMD_AT_CIFSR: // AT+CIFSR - Gets the Local IP Address
 		cmd_AT_CIFSR();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPMUX
-	else if (cmd == CMD_AT_CIPMUX) // AT+CIPMUX - Enable or Disable Multiple Connections
+	case CMD_AT_CIPMUX: // AT+CIPMUX - Enable or Disable Multiple Connections
 		cmd_AT_CIPMUX();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPDINFO
-	else if (cmd == CMD_AT_CIPDINFO) // AT+CIPDINFO - Shows the Remote IP and Port with +IPD
+	case CMD_AT_CIPDINFO: // AT+CIPDINFO - Shows the Remote IP and Port with +IPD
 		cmd_AT_CIPDINFO();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSERVER
-	else if (cmd == CMD_AT_CIPSERVER) // AT+CIPCIPSERVER - Deletes/Creates TCP Server
+	case CMD_AT_CIPSERVER: // AT+CIPCIPSERVER - Deletes/Creates TCP Server
 		cmd_AT_CIPSERVER();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSERVERMAXCONN
-	else if (cmd == CMD_AT_CIPSERVERMAXCONN) // AT+CIPSERVERMAXCONN - Set the Maximum Connections Allowed by Server
+	case CMD_AT_CIPSERVERMAXCONN: // AT+CIPSERVERMAXCONN - Set the Maximum Connections Allowed by Server
 		cmd_AT_CIPSERVERMAXCONN();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSTO
-	else if (cmd == CMD_AT_CIPSTO) // AT+CIPSTO - Sets the TCP Server Timeout
+	case CMD_AT_CIPSTO: // AT+CIPSTO - Sets the TCP Server Timeout
 		cmd_AT_CIPSTO();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPMODE
+	case CMD_AT_CIPMODE: // AT+CIPMODE - Sets Transmission Mode
+		cmd_AT_CIPMODE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPRECVMODE
-	else if (cmd == CMD_AT_CIPRECVMODE) // AT+CIPRECVMODE - Set TCP Receive Mode
+	case CMD_AT_CIPRECVMODE: // AT+CIPRECVMODE - Set TCP Receive Mode
 		cmd_AT_CIPRECVMODE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPRECVDATA
-	else if (cmd == CMD_AT_CIPRECVDATA) // AT+CIPRECVDATA - Get TCP Data in Passive Receive Mode
+	case CMD_AT_CIPRECVDATA: // AT+CIPRECVDATA - Get TCP Data in Passive Receive Mode
 		cmd_AT_CIPRECVDATA();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPRECVLEN
-	else if (cmd == CMD_AT_CIPRECVLEN) // AT+CIPRECVLEN - Get TCP Data Length in Passive Receive Mode
+	case CMD_AT_CIPRECVLEN: // AT+CIPRECVLEN - Get TCP Data Length in Passive Receive Mode
 		cmd_AT_CIPRECVLEN();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSNTPCFG
-	else if (cmd == CMD_AT_CIPSNTPCFG) // AT+CIPSNTPCFG - configure SNTP time
+	case CMD_AT_CIPSNTPCFG: // AT+CIPSNTPCFG - configure SNTP time
 		cmd_AT_CIPSNTPCFG();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSNTPTIME?
-	else if (cmd == CMD_AT_CIPSNTPTIME) // AT+CIPSNTPTIME? - get time in asctime format
+	case CMD_AT_CIPSNTPTIME: // AT+CIPSNTPTIME? - get time in asctime format
 		cmd_AT_CIPSNTPTIME();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPDNS
-	else if (cmd == CMD_AT_CIPDNS || cmd == CMD_AT_CIPDNS_CUR || cmd == CMD_AT_CIPDNS_DEF)
+	case CMD_AT_CIPDNS:
+	case CMD_AT_CIPDNS_CUR:
+	case CMD_AT_CIPDNS_DEF:
 		// AT+CIPDNS - Sets User-defined DNS Servers
 		cmd_AT_CIPDNS(cmd);
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPDNSCACHE
+	case CMD_AT_CIPDNSCACHE: // AT+CIPDNSCACHE - Query, flush or configure the DNS cache
+		cmd_AT_CIPDNSCACHE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+SYSCPUFREQ
-	else if (cmd == CMD_AT_SYSCPUFREQ) // AT+SYSCPUFREQ - Set or Get the Current CPU Frequency
+	case CMD_AT_SYSCPUFREQ: // AT+SYSCPUFREQ - Set or Get the Current CPU Frequency
 		cmd_AT_SYSCPUFREQ();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+UARTBUF
+	case CMD_AT_UARTBUF: // AT+UARTBUF - Sets the size of the UART receive buffer
+		cmd_AT_UARTBUF();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+SYSSAVE
+	case CMD_AT_SYSSAVE: // AT+SYSSAVE - Writes the changed settings to flash now
+		cmd_AT_SYSSAVE();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+SYSHEAP
+	case CMD_AT_SYSHEAP: // AT+SYSHEAP? - Heap state and the memory used by the links
+		cmd_AT_SYSHEAP();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+SYSPERF
+	case CMD_AT_SYSPERF: // AT+SYSPERF - Prints or resets the performance probes
+		cmd_AT_SYSPERF();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+RFMODE
-	else if (cmd == CMD_AT_RFMODE) // AT+RFMODE - Sets or queries current RF mode (custom command)
+	case CMD_AT_RFMODE: // AT+RFMODE - Sets or queries current RF mode (custom command)
 		cmd_AT_RFMODE();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPSERVERCFG
+	case CMD_AT_CIPSERVERCFG: // AT+CIPSERVERCFG - Sets the maximum connections and timeout of a server
+		cmd_AT_CIPSERVERCFG();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPRECVCOALESCE
+	case CMD_AT_CIPRECVCOALESCE: // AT+CIPRECVCOALESCE - Sets the merging of the received data into fewer +IPD
+		cmd_AT_CIPRECVCOALESCE();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPTCPOPT
+	case CMD_AT_CIPTCPOPT: // AT+CIPTCPOPT - Sets the TCP options of a link
+		cmd_AT_CIPTCPOPT();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPBINMODE
+	case CMD_AT_CIPBINMODE: // AT+CIPBINMODE - Starts the binary framing mode
+		cmd_AT_CIPBINMODE();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPSENDMULTI
+	case CMD_AT_CIPSENDMULTI: // AT+CIPSENDMULTI - Sends one payload to several links
+		cmd_AT_CIPSENDMULTI();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CWFASTJOIN
+	case CMD_AT_CWFASTJOIN: // AT+CWFASTJOIN - Fast rejoin to the cached access point
+		cmd_AT_CWFASTJOIN();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CWLAPCACHE
+	case CMD_AT_CWLAPCACHE: // AT+CWLAPCACHE - Maximum age of the cached AT+CWLAP result
+		cmd_AT_CWLAPCACHE();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLAUTH
-	else if (cmd == CMD_AT_CIPSSLAUTH) // AT+CIPSSLAUTH - Authentication type
+	case CMD_AT_CIPSSLAUTH: // AT+CIPSSLAUTH - Authentication type
 		cmd_AT_CIPSSLAUTH();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLFP
-	else if (cmd == CMD_AT_CIPSSLFP) // AT+CIPSSLFP - Shows or stores certificate fingerprint
+	case CMD_AT_CIPSSLFP: // AT+CIPSSLFP - Shows or stores certificate fingerprint
 		cmd_AT_CIPSSLFP();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLCERTMAX
-	else if (cmd == CMD_AT_CIPSSLCERTMAX) // AT+CIPSSLCERTMAX - Get or set the maximum certificate amount
+	case CMD_AT_CIPSSLCERTMAX: // AT+CIPSSLCERTMAX - Get or set the maximum certificate amount
 		cmd_AT_CIPSSLCERTMAX();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLCERT
-	else if (cmd == CMD_AT_CIPSSLCERT) // AT+CIPSSLCERT - Load CA certificate in PEM format
+	case CMD_AT_CIPSSLCERT: // AT+CIPSSLCERT - Load CA certificate in PEM format
 		cmd_AT_CIPSSLCERT();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLMFLN
-	else if (cmd == CMD_AT_CIPSSLMFLN) // AT+CIPSSLMFLN - Check the capability of MFLN for a site
+	case CMD_AT_CIPSSLMFLN: // AT+CIPSSLMFLN - Check the capability of MFLN for a site
 		cmd_AT_CIPSSLMFLN();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+CIPSSLSTA
-	else if (cmd == CMD_AT_CIPSSLSTA) // AT+CIPSSLSTA - Check the MFLN status for a connection
+	case CMD_AT_CIPSSLSTA: // AT+CIPSSLSTA - Check the MFLN status for a connection
 		cmd_AT_CIPSSLSTA();
+		break;
+
+	// ------------------------------------------------------------------------------------ AT+CIPSSLSESS
+	case CMD_AT_CIPSSLSESS: // AT+CIPSSLSESS - Configure, query or clear the TLS session cache
+		cmd_AT_CIPSSLSESS();
+		break;
 
 	// ------------------------------------------------------------------------------------ AT+SNTPTIME?
-	else if (cmd == CMD_AT_SNTPTIME) // AT+SNTPTIME? - get time
+	case CMD_AT_SNTPTIME: // AT+SNTPTIME? - get time
 		cmd_AT_SNTPTIME();
+		break;
 
-	else
-	{
-		Serial.printf_P(MSG_ERROR);
+	default:
+		SerialTx.printf_P(MSG_ERROR);
 	}
 
 	// Clear the buffer
@@ -467,7 +757,7 @@ void processCommandBuffer(void)
  */
 void cmd_AT()
 {
-	Serial.printf_P(MSG_OK);
+	SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -475,8 +765,11 @@ void cmd_AT()
  */
 void cmd_AT_RST()
 {
-	Serial.printf_P(MSG_OK);
-	Serial.flush();
+	SerialTx.printf_P(MSG_OK);
+	SerialTx.flush();
+
+	// Write the pending settings changes
+	Settings::save();
 
 	ESP.reset();
 }
@@ -486,10 +779,10 @@ void cmd_AT_RST()
  */
 void cmd_AT_GMR()
 {
-	Serial.println(F("AT version:1.7.0.0 (partial)"));
-	Serial.printf_P(PSTR("SDK version:%s\r\n"), system_get_sdk_version());
-	Serial.printf_P(PSTR("Compile time:%s %s\r\n"), __DATE__, __TIME__);
-	Serial.printf_P(PSTR("Version ESP_ATMod:%s\r\n"), APP_VERSION);
+	SerialTx.println(F("AT version:1.7.0.0 (partial)"));
+	SerialTx.printf_P(PSTR("SDK version:%s\r\n"), system_get_sdk_version());
+	SerialTx.printf_P(PSTR("Compile time:%s %s\r\n"), __DATE__, __TIME__);
+	SerialTx.printf_P(PSTR("Version ESP_ATMod:%s\r\n"), APP_VERSION);
 
 	/* The Arduino code version is based on file core_version.h
 	 * This file is by default unusable (version number 0) but can be (and maybe is) populated
@@ -503,11 +796,11 @@ void cmd_AT_GMR()
 	 */
 #if (ARDUINO_ESP8266_GIT_VER != 0)
 	{
-		Serial.printf_P(PSTR("Arduino core version:%s\r\n"), __STR(ARDUINO_ESP8266_GIT_DESC));
+		SerialTx.printf_P(PSTR("Arduino core version:%s\r\n"), __STR(ARDUINO_ESP8266_GIT_DESC));
 	}
 #endif
 
-	Serial.println(F("OK"));
+	SerialTx.println(F("OK"));
 }
 
 /*
@@ -519,11 +812,11 @@ void cmd_ATE()
 	uint16_t offset = 3;
 
 	if (!readNumber(inputBuffer, offset, echo) || echo > 1 || inputBufferCnt != offset + 2)
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	else
 	{
 		gsEchoEnabled = echo;
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 }
 
@@ -532,10 +825,12 @@ void cmd_ATE()
  */
 void cmd_AT_RESTORE()
 {
-	Serial.printf_P(MSG_OK);
+	SerialTx.printf_P(MSG_OK);
+	SerialTx.flush();
 
 	// Reset the EEPROM configuration
 	Settings::reset();
+	Settings::save();
 
 	ESP.reset();
 }
@@ -557,7 +852,7 @@ void cmd_AT_UART(commands_t cmd)
 		else if (cmd == CMD_AT_UART_DEF)
 			cmdSuffix = suffix_DEF;
 
-		Serial.printf_P(PSTR("+UART%s:"), cmdSuffix);
+		SerialTx.printf_P(PSTR("+UART%s:"), cmdSuffix);
 
 		/*
 		 * UART Register USC0:
@@ -569,23 +864,26 @@ void cmd_AT_UART(commands_t cmd)
 
 		uint32_t uartConfig;
 		uint32_t baudRate;
+		uint8_t flow;
 
 		if (cmd == CMD_AT_UART_DEF)
 		{
 			uartConfig = Settings::getUartConfig();
 			baudRate = Settings::getUartBaudRate();
+			flow = Settings::getUartFlowControl();
 		}
 		else
 		{
 			uartConfig = USC0(0);
 			baudRate = Serial.baudRate();
+			flow = gsUartFlowControl;
 		}
 
 		uint8_t databits = 5 + ((uartConfig >> UCBN) & 3);
 		uint8_t stopbits = (uartConfig >> UCSBN) & 3;
 		uint8_t parity = uartConfig & 3;
 
-		Serial.printf("%d,%d,%d,%d,0\r\nOK\r\n", baudRate, databits, stopbits, parity);
+		SerialTx.printf("%d,%d,%d,%d,%d\r\nOK\r\n", baudRate, databits, stopbits, parity, flow);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -625,11 +923,13 @@ void cmd_AT_UART(commands_t cmd)
 			if (!readNumber(inputBuffer, offset, flow) || flow > 3 || inputBufferCnt != offset + 2)
 				break;
 
-			if (flow != 0)
+#ifdef ETHERNET_CLASS
+			if (flow & 2) // GPIO13 (CTS) is the SPI MOSI of the Ethernet interface
 			{
-				Serial.println(F("NOT IMPLEMENTED"));
+				SerialTx.println(F("CTS not available with Ethernet"));
 				break;
 			}
+#endif
 
 			uartConfig = (SerialConfig)(((dataBits - 5) << UCBN) | (stopBits << UCSBN) | parity);
 
@@ -638,29 +938,31 @@ void cmd_AT_UART(commands_t cmd)
 			error = 0;
 
 			// Last message at the original speed
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 
 			// Restart the serial interface
 
-			Serial.flush();
+			SerialTx.flush();
 			Serial.end();
 			Serial.begin(baudRate, uartConfig);
+			setUartFlowControl(flow);
 			delay(250); // To let the line settle
 
 			if (cmd != CMD_AT_UART_CUR)
 			{
 				Settings::setUartBaudRate(baudRate);
 				Settings::setUartConfig(uartConfig);
+				Settings::setUartFlowControl(flow);
 			}
 
 		} while (0);
 
 		if (error == 1)
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -669,7 +971,7 @@ void cmd_AT_UART(commands_t cmd)
  */
 void cmd_AT_SYSRAM()
 {
-	Serial.printf_P(PSTR("+SYSRAM:%d\r\nOK\r\n"), ESP.getFreeHeap());
+	SerialTx.printf_P(PSTR("+SYSRAM:%d\r\nOK\r\n"), ESP.getFreeHeap());
 }
 
 /*
@@ -689,8 +991,8 @@ void cmd_AT_CWMODE(commands_t cmd)
 		else if (cmd == CMD_AT_CWMODE_DEF)
 			cmdSuffix = suffix_DEF;
 
-		Serial.printf_P(PSTR("+CWMODE%s:%d\r\n"), cmdSuffix, WiFi.getMode());
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(PSTR("+CWMODE%s:%d\r\n"), cmdSuffix, WiFi.getMode());
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -704,9 +1006,9 @@ void cmd_AT_CWMODE(commands_t cmd)
 				WiFi.persistent(true);
 
 			if (WiFi.mode((WiFiMode) mode))
-				Serial.printf_P(MSG_OK);
+				SerialTx.printf_P(MSG_OK);
 			else
-				Serial.printf_P(MSG_ERROR);
+				SerialTx.printf_P(MSG_ERROR);
 
 			WiFi.persistent(false);
 
@@ -721,11 +1023,11 @@ void cmd_AT_CWMODE(commands_t cmd)
 			}
 		}
 		else
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -736,7 +1038,7 @@ void cmd_AT_CWJAP(commands_t cmd)
 {
 	if (WiFi.getMode() == WIFI_AP)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 		return;
 	}
 
@@ -748,7 +1050,7 @@ void cmd_AT_CWJAP(commands_t cmd)
 	{
 		if (WiFi.status() != WL_CONNECTED)
 		{
-			Serial.println(F("No AP"));
+			SerialTx.println(F("No AP"));
 		}
 		else
 		{
@@ -770,14 +1072,14 @@ void cmd_AT_CWJAP(commands_t cmd)
 			else if (cmd == CMD_AT_CWJAP_DEF)
 				cmdSuffix = suffix_DEF;
 
-			Serial.printf_P(PSTR("+CWJAP%s:"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CWJAP%s:"), cmdSuffix);
 
 			// +CWJAP_CUR:<ssid>,<bssid>,<channel>,<rssi>
-			Serial.printf_P(PSTR("\"%s\",\"%02x:%02x:%02x:%02x:%02x:%02x\",%d,%d\r\n"), ssid,
+			SerialTx.printf_P(PSTR("\"%s\",\"%02x:%02x:%02x:%02x:%02x:%02x\",%d,%d\r\n"), ssid,
 							conf.bssid[0], conf.bssid[1], conf.bssid[2], conf.bssid[3], conf.bssid[4], conf.bssid[5],
 							WiFi.channel(), WiFi.RSSI());
 		}
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -818,9 +1120,6 @@ void cmd_AT_CWJAP(commands_t cmd)
 			if (inputBufferCnt != offset + 2)
 				break;
 
-			if (cmd != CMD_AT_CWJAP_CUR)
-				WiFi.persistent(true);
-
 			// If connected, disconnect first
 			if (WiFi.status() == WL_CONNECTED)
 			{
@@ -840,9 +1139,15 @@ void cmd_AT_CWJAP(commands_t cmd)
 			if (!bssid.isEmpty())
 				pBssid = uBssid;
 
-			WiFi.begin(ssid, pwd, 0, pBssid);
+			// Only the configuration is saved, the directed fast join must not be persistent
+			if (cmd != CMD_AT_CWJAP_CUR)
+			{
+				WiFi.persistent(true);
+				WiFi.begin(ssid, pwd, 0, pBssid, false);
+				WiFi.persistent(false);
+			}
 
-			WiFi.persistent(false);
+			fastJoinBegin(ssid.c_str(), pwd.c_str(), pBssid);
 
 			gsFlag_Connecting = true;
 			gsFlag_Busy = true;
@@ -857,12 +1162,12 @@ void cmd_AT_CWJAP(commands_t cmd)
 
 		if (error)
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -910,33 +1215,96 @@ void cmd_AT_CWLAPOPT()
 
 		if (error)
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 		else
 		{
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
 /*
- * AT+CWLAP - List available APs.
+ * AT+CWLAP[=<ssid>[,<mac>][,<channel>]] - List available APs.
+ *   The result of a full scan younger than AT+CWLAPCACHE answers without scanning, also filtered.
+ *   The scan runs in the background, the result is printed by processScanResult().
  */
 void cmd_AT_CWLAP()
 {
-	if (WiFi.getMode() == WIFI_AP)
+	uint16_t offset = strlen("AT+CWLAP");
+	bool error = true;
+
+	do
 	{
-		Serial.printf_P(MSG_ERROR);
-		return;
-	}
+		cwlapSsid[0] = '\0';
+		cwlapBssidSet = false;
+		cwlapChannel = 0;
+
+		if (inputBuffer[offset] == '=')
+		{
+			++offset;
+
+			String ssid = readStringFromBuffer(inputBuffer, offset, true, true);
+			if (ssid.length() >= sizeof(cwlapSsid))
+				break;
+
+			strcpy(cwlapSsid, ssid.c_str());
+
+			if (inputBuffer[offset] == ',')
+			{
+				++offset;
+
+				String bssid = readStringFromBuffer(inputBuffer, offset, false, true);
+
+				if (!bssid.isEmpty())
+				{
+					char fmt[40];
+					strcpy_P(fmt, PSTR("%2hhx:%2hhx:%2hhx:%2hhx:%2hhx:%2hhx"));
+					if (bssid.length() != 17 || sscanf(bssid.c_str(), fmt, &cwlapBssid[0], &cwlapBssid[1], &cwlapBssid[2],
+													   &cwlapBssid[3], &cwlapBssid[4], &cwlapBssid[5]) != 6)
+						break;
+
+					cwlapBssidSet = true;
+				}
+
+				if (inputBuffer[offset] == ',')
+				{
+					uint32_t channel;
+
+					++offset;
+
+					if (!readNumber(inputBuffer, offset, channel) || channel < 1 || channel > 14)
+						break;
+
+					cwlapChannel = channel;
+				}
+			}
+		}
+
+		if (inputBufferCnt != offset + 2 || WiFi.getMode() == WIFI_AP)
+			break;
+
+		if (scanCacheValid(gsScanCacheAge))
+		{
+			printScanResult();
+		}
+		else if (!scanCacheStart(cwlapSsid, cwlapChannel))
+		{
+			break;
+		}
+
+		error = false;
+
+	} while (0);
 
-	// Print found networks with printScanResult once the scan has finished
-	WiFi.scanNetworksAsync(printScanResult);
-	gsFlag_Busy = true;
+	if (error)
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
 }
 
 /*
@@ -944,11 +1312,13 @@ void cmd_AT_CWLAP()
  */
 void cmd_AT_CWQAP()
 {
+	fastJoinCancel();
+
 	if (WiFi.status() == WL_CONNECTED)
 	{
 		WiFi.disconnect();
 	}
-	Serial.printf_P(MSG_OK);
+	SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -958,7 +1328,7 @@ void cmd_AT_CWSAP(commands_t cmd)
 {
 	if (WiFi.getMode() == WIFI_STA)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 		return;
 	}
 
@@ -987,13 +1357,13 @@ void cmd_AT_CWSAP(commands_t cmd)
 		else if (cmd == CMD_AT_CWSAP_DEF)
 			cmdSuffix = suffix_DEF;
 
-		Serial.printf_P(PSTR("+CWSAP%s:"), cmdSuffix);
+		SerialTx.printf_P(PSTR("+CWSAP%s:"), cmdSuffix);
 
 		// +CWSAP_CUR:<ssid>,<pwd>,<chl>,<ecn>,<max conn>,<ssid hidden>
-		Serial.printf_P(PSTR("\"%s\",\"%s\",%d,%d,%d,%d\r\n"), ssid, conf.password,
+		SerialTx.printf_P(PSTR("\"%s\",\"%s\",%d,%d,%d,%d\r\n"), ssid, conf.password,
 				conf.channel, conf.authmode, conf.max_connection, conf.ssid_hidden);
 
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1061,16 +1431,16 @@ void cmd_AT_CWSAP(commands_t cmd)
 
 		if (error == 0)
 		{
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else if (error == 1)
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1100,9 +1470,9 @@ void cmd_AT_CWDHCP(commands_t cmd)
 		else
 			dhcp = gsCwDhcp;
 
-		Serial.printf_P(PSTR("+CWDHCP%s:%d\r\n"), cmdSuffix, dhcp);
+		SerialTx.printf_P(PSTR("+CWDHCP%s:%d\r\n"), cmdSuffix, dhcp);
 
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 		error = false;
 	}
 	else if (inputBuffer[offset] == '=')
@@ -1145,7 +1515,7 @@ void cmd_AT_CWDHCP(commands_t cmd)
 					if (cmd != CMD_AT_CWDHCP_CUR)
 						Settings::setDhcpMode(gsCwDhcp);
 
-					Serial.printf_P(MSG_OK);
+					SerialTx.printf_P(MSG_OK);
 					error = false;
 				}
 			}
@@ -1154,7 +1524,7 @@ void cmd_AT_CWDHCP(commands_t cmd)
 
 	if (error)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1165,9 +1535,9 @@ void cmd_AT_CWAUTOCONN()
 {
 	if (inputBuffer[13] == '?')
 	{
-		Serial.print(F("+CWAUTOCONN:"));
-		Serial.println(WiFi.getAutoConnect() ? "1" : "0");
-		Serial.printf_P(MSG_OK);
+		SerialTx.print(F("+CWAUTOCONN:"));
+		SerialTx.println(WiFi.getAutoConnect() ? "1" : "0");
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[13] == '=')
 	{
@@ -1177,16 +1547,16 @@ void cmd_AT_CWAUTOCONN()
 		if (readNumber(inputBuffer, offset, autoconn) && autoconn <= 1 && inputBufferCnt == offset + 2)
 		{
 			WiFi.setAutoConnect(autoconn);
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1210,9 +1580,9 @@ void cmd_AT_CIPXXMAC(commands_t cmd)
 			cmdSuffix = suffix_CUR;
 		else if (cmd == CMD_AT_CIPSTAMAC_DEF || cmd == CMD_AT_CIPAPMAC_DEF)
 			cmdSuffix = suffix_DEF;
-		Serial.printf_P(PSTR("+CIP%sMAC%s:\"%s\"\r\n"),
+		SerialTx.printf_P(PSTR("+CIP%sMAC%s:\"%s\"\r\n"),
 				(iface == STATION_IF) ? "STA" : "AP", cmdSuffix, mac.c_str());
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1239,18 +1609,18 @@ void cmd_AT_CIPXXMAC(commands_t cmd)
 			if (inputBufferCnt != offset + 2)
 				break;
 
-			Serial.println(F("NOT IMPLEMENTED"));
+			SerialTx.println(F("NOT IMPLEMENTED"));
 
 		} while (0);
 
 		if (error == 0)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else if (error == 1)
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 
 }
@@ -1262,7 +1632,7 @@ void cmd_AT_CIPSTA(commands_t cmd)
 {
 	if (WiFi.getMode() == WIFI_AP)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 		return;
 	}
 
@@ -1292,17 +1662,17 @@ void cmd_AT_CIPSTA(commands_t cmd)
 
 		if (WiFi.status() != WL_CONNECTED || cfg.ip == 0)
 		{
-			Serial.printf_P(PSTR("+CIPSTA%s:ip:\"0.0.0.0\"\r\n"), cmdSuffix);
-			Serial.printf_P(PSTR("+CIPSTA%s:gateway:\"0.0.0.0\"\r\n"), cmdSuffix);
-			Serial.printf_P(PSTR("+CIPSTA%s:netmask:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPSTA%s:ip:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPSTA%s:gateway:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPSTA%s:netmask:\"0.0.0.0\"\r\n"), cmdSuffix);
 		}
 		else
 		{
-			Serial.printf_P(PSTR("+CIPSTA%s:ip:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.ip).toString().c_str());
-			Serial.printf_P(PSTR("+CIPSTA%s:gateway:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.gw).toString().c_str());
-			Serial.printf_P(PSTR("+CIPSTA%s:netmask:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.mask).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPSTA%s:ip:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.ip).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPSTA%s:gateway:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.gw).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPSTA%s:netmask:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.mask).toString().c_str());
 		}
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1364,13 +1734,13 @@ void cmd_AT_CIPSTA(commands_t cmd)
 		} while (0);
 
 		if (error == 0)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else if (error == 1)
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1381,7 +1751,7 @@ void cmd_AT_CIPAP(commands_t cmd)
 {
 	if (WiFi.getMode() == WIFI_STA)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 		return;
 	}
 
@@ -1413,18 +1783,18 @@ void cmd_AT_CIPAP(commands_t cmd)
 
 		if (WiFi.getMode() == WIFI_STA || cfg.ip == 0)
 		{
-			Serial.printf_P(PSTR("+CIPSTA%s:ip:\"0.0.0.0\"\r\n"), cmdSuffix);
-			Serial.printf_P(PSTR("+CIPSTA%s:gateway:\"0.0.0.0\"\r\n"), cmdSuffix);
-			Serial.printf_P(PSTR("+CIPSTA%s:netmask:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPSTA%s:ip:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPSTA%s:gateway:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPSTA%s:netmask:\"0.0.0.0\"\r\n"), cmdSuffix);
 		}
 		else
 		{
-			Serial.printf_P(PSTR("+CIPAP%s:ip:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.ip).toString().c_str());
-			Serial.printf_P(PSTR("+CIPAP%s:gateway:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.gw).toString().c_str());
-			Serial.printf_P(PSTR("+CIPAP%s:netmask:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.mask).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPAP%s:ip:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.ip).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPAP%s:gateway:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.gw).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPAP%s:netmask:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.mask).toString().c_str());
 		}
 
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1483,13 +1853,13 @@ void cmd_AT_CIPAP(commands_t cmd)
 		} while (0);
 
 		if (error == 0)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else if (error == 1)
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 
 }
@@ -1506,14 +1876,14 @@ void cmd_AT_CWHOSTNAME()
 
 		// query is enabled in AP mode in standard AT firmware
 
-		Serial.printf_P(PSTR("+CWHOSTNAME:%s\r\n"), WiFi.hostname().c_str());
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(PSTR("+CWHOSTNAME:%s\r\n"), WiFi.hostname().c_str());
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
 		if (WiFi.getMode() == WIFI_AP)
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 			return;
 		}
 
@@ -1521,19 +1891,19 @@ void cmd_AT_CWHOSTNAME()
 
 		if (hostname.isEmpty())
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 			return;
 		}
 
 		WiFi.hostname(hostname);
 		if (WiFi.hostname() == hostname)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1553,9 +1923,9 @@ void cmd_AT_CIPETHMAC(commands_t cmd)
 			cmdSuffix = suffix_CUR;
 		else if (cmd == CMD_AT_CIPETHMAC_DEF)
 			cmdSuffix = suffix_DEF;
-		Serial.printf_P(PSTR("+CIPETHMAC%s:\"%02X:%02X:%02X:%02X:%02X:%02X\"\r\n"), cmdSuffix,
+		SerialTx.printf_P(PSTR("+CIPETHMAC%s:\"%02X:%02X:%02X:%02X:%02X:%02X\"\r\n"), cmdSuffix,
 				gsCipEthMAC[0], gsCipEthMAC[1], gsCipEthMAC[2], gsCipEthMAC[3], gsCipEthMAC[4], gsCipEthMAC[5]);
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1594,13 +1964,13 @@ void cmd_AT_CIPETHMAC(commands_t cmd)
 		} while (0);
 
 		if (error == 0)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else if (error == 1)
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 
 }
@@ -1637,17 +2007,17 @@ void cmd_AT_CIPETH(commands_t cmd)
 
 		if (Ethernet.status() != WL_CONNECTED || cfg.ip == 0)
 		{
-			Serial.printf_P(PSTR("+CIPETH%s:ip:\"0.0.0.0\"\r\n"), cmdSuffix);
-			Serial.printf_P(PSTR("+CIPETH%s:gateway:\"0.0.0.0\"\r\n"), cmdSuffix);
-			Serial.printf_P(PSTR("+CIPETH%s:netmask:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPETH%s:ip:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPETH%s:gateway:\"0.0.0.0\"\r\n"), cmdSuffix);
+			SerialTx.printf_P(PSTR("+CIPETH%s:netmask:\"0.0.0.0\"\r\n"), cmdSuffix);
 		}
 		else
 		{
-			Serial.printf_P(PSTR("+CIPETH%s:ip:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.ip).toString().c_str());
-			Serial.printf_P(PSTR("+CIPETH%s:gateway:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.gw).toString().c_str());
-			Serial.printf_P(PSTR("+CIPETH%s:netmask:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.mask).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPETH%s:ip:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.ip).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPETH%s:gateway:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.gw).toString().c_str());
+			SerialTx.printf_P(PSTR("+CIPETH%s:netmask:\"%s\"\r\n"), cmdSuffix, IPAddress(cfg.mask).toString().c_str());
 		}
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1709,13 +2079,13 @@ void cmd_AT_CIPETH(commands_t cmd)
 		} while (0);
 
 		if (error == 0)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else if (error == 1)
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1728,8 +2098,8 @@ void cmd_AT_CEHOSTNAME()
 
 		// query is enabled in AP mode in standard AT firmware
 
-		Serial.printf_P(PSTR("+CEHOSTNAME:%s\r\n"), Ethernet.hostname().c_str());
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(PSTR("+CEHOSTNAME:%s\r\n"), Ethernet.hostname().c_str());
+		SerialTx.printf_P(MSG_OK);
 	}
 	else if (inputBuffer[offset] == '=')
 	{
@@ -1737,19 +2107,96 @@ void cmd_AT_CEHOSTNAME()
 
 		if (hostname.isEmpty())
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 			return;
 		}
 
 		Ethernet.hostname(hostname);
 		if (Ethernet.hostname() == hostname)
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		else
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+CIPETHCFG - SPI clock and INT pin of the Ethernet chip (custom command), saved in flash
+ *   AT+CIPETHCFG=<SPI clock>,<INT GPIO>: 1 - ETH_SPI_CLOCK_MAX [MHz], GPIO 0, 2 or 4, -1 = polling
+ *   With AT_DEBUG_UART1 the GPIO2 is the debug output and not allowed
+ */
+void cmd_AT_CIPETHCFG()
+{
+	uint16_t offset = strlen("AT+CIPETHCFG");
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		SerialTx.printf_P(PSTR("+CIPETHCFG:%d,%d\r\n"), Settings::getEthSpiClock(), Ethernet.getInterruptPin());
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
+	{
+		bool error = true;
+
+		do
+		{
+			uint32_t clock;
+			uint32_t pin;
+			int8_t intPin = -1;
+
+			++offset;
+
+			if (!readNumber(inputBuffer, offset, clock) || clock < 1 || clock > ETH_SPI_CLOCK_MAX)
+				break;
+
+			if (inputBuffer[offset] != ',')
+				break;
+
+			++offset;
+
+			if (inputBuffer[offset] == '-')
+			{
+				++offset;
+
+				if (!readNumber(inputBuffer, offset, pin) || pin != 1)
+					break;
+			}
+			else
+			{
+				// GPIO 1, 3 are the UART, 5 the chip select, 6 - 11 the flash, 12 - 14 the SPI,
+				// 15 must be low on boot and 16 has no pull-up
+				if (!readNumber(inputBuffer, offset, pin) || pin > 15 || !(ETH_INT_PINS & (1 << pin)))
+					break;
+
+#if defined(AT_DEBUG) && defined(AT_DEBUG_UART1)
+				if (pin == 2) // The UART1 debug output
+					break;
+#endif
+
+				intPin = pin;
+			}
+
+			if (inputBufferCnt != offset + 2)
+				break;
+
+			SPI.setFrequency(clock * 1000000L);
+			Ethernet.setInterruptPin(intPin);
+
+			Settings::setEthSpiClock(clock);
+			Settings::setEthIntPin(intPin);
+
+			error = false;
+
+		} while (0);
+
+		SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 #endif
@@ -1770,14 +2217,14 @@ void cmd_AT_CIPSTATUS()
 
 	if (status != WL_CONNECTED)
 	{
-		Serial.println(F("STATUS:5"));
+		SerialTx.println(F("STATUS:5"));
 		statusPrinted = true;
 	}
 	
 	//	We have to list SoftAP TCP connections, too
 	uint8_t maxCli = 0; // Maximum client number
 	if (gsCipMux == 1)
-		maxCli = 4;
+		maxCli = MAX_LINKS - 1;
 
 	for (uint8_t i = 0; i <= maxCli; ++i)
 	{
@@ -1786,13 +2233,35 @@ void cmd_AT_CIPSTATUS()
 		{
 			if (!statusPrinted)
 			{
-				Serial.println(F("STATUS:3"));
+				SerialTx.println(F("STATUS:3"));
 				statusPrinted = true;
 			}
 
+			IPAddress remoteIP = cli->remoteIP();
+			uint16_t remotePort = cli->remotePort();
+			uint16_t localPort = cli->localPort();
+
+			if (clients[i].type == TYPE_UDP)
+			{
+				UdpClient *udp = static_cast<UdpClient *>(cli);
+
+				remoteIP = udp->udpRemoteIP();
+				remotePort = udp->udpRemotePort();
+				localPort = udp->udpLocalPort();
+			}
+
 			const char types_text[3][4] = {"TCP", "UDP", "SSL"};
-			Serial.printf_P(PSTR("+CIPSTATUS:%d,\"%s\",\"%s\",%d,%d,0\r\n"), i, types_text[clients[i].type],
-							cli->remoteIP().toString().c_str(), cli->remotePort(), cli->localPort());
+			SerialTx.printf_P(PSTR("+CIPSTATUS:%d,\"%s\",\"%s\",%d,%d,"), i, types_text[clients[i].type],
+							remoteIP.toString().c_str(), remotePort, localPort);
+
+			// tetype 1 and the port of the server for the links accepted by a server
+			if (clients[i].serverId != SERVER_NONE)
+				SerialTx.printf_P(PSTR("1,%d\r\n"), servers[clients[i].serverId].port());
+			else
+				SerialTx.println('0');
+
+			if (clients[i].type != TYPE_UDP)
+				printLinkOptions(i);
 		}
 	}
 
@@ -1805,10 +2274,10 @@ void cmd_AT_CIPSTATUS()
 		else
 			stat = '2';
 
-		Serial.printf_P(PSTR("STATUS:%c\r\n"), stat);
+		SerialTx.printf_P(PSTR("STATUS:%c\r\n"), stat);
 	}
 
-	Serial.printf_P(MSG_OK);
+	SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -1860,12 +2329,12 @@ void cmd_AT_CIPDOMAIN()
 
 			IPAddress remoteIP;
 			uint16_t _timeout = 15000;
-			if (WiFi.hostByName(hostname, remoteIP, _timeout))
+			if (dnsCacheResolve(hostname, remoteIP, _timeout))
 			{
-				Serial.print(F("+CIPDOMAIN:"));
-				Serial.println(remoteIP);
+				SerialTx.print(F("+CIPDOMAIN:"));
+				SerialTx.println(remoteIP);
 
-				Serial.printf_P(MSG_OK);
+				SerialTx.printf_P(MSG_OK);
 
 				error = 0;
 				break;
@@ -1878,11 +2347,11 @@ void cmd_AT_CIPDOMAIN()
 	if (error > 0)
 	{
 		if (error == 100)
-			Serial.println(F("DNS Fail"));
+			SerialTx.println(F("DNS Fail"));
 		else if (error == 2)
-			Serial.println(F("IP ERROR")); // as the standard AT 1 fw
+			SerialTx.println(F("IP ERROR")); // as the standard AT 1 fw
 
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -1894,6 +2363,7 @@ void cmd_AT_CIPSTART()
 	/*
 	 * AT+CIPMUX=0:  AT+CIPSTART=<type>,<remote IP>,<remote port>[,<TCP keep alive>]
 	 * AT+CIPMUX=1:  AT+CIPSTART=<link ID>,<type>,<remote IP>,<remote port>[,<TCP keep alive>]
+	 * UDP:          AT+CIPSTART=[<link ID>,]"UDP",<remote IP>,<remote port>[,<UDP local port>[,<UDP mode>]]
 	 */
 	uint8_t error = 1; // 1 = generic error, 0 = ok
 	uint16_t offset = 11;
@@ -1904,6 +2374,10 @@ void cmd_AT_CIPSTART()
 	clientTypes_t type = TYPE_NONE; // 0 = TCP, 1 = UDP, 2 = SSL
 	char *remoteAddr;
 	uint32_t remotePort = 0;
+	uint32_t localPort = 0; // UDP only
+	uint32_t udpMode = 0;	// UDP only
+	uint32_t keepAlive = 0; // TCP and SSL only
+	bool keepAliveSet = false;
 
 	do
 	{
@@ -1914,15 +2388,8 @@ void cmd_AT_CIPSTART()
 		error = 2;
 
 		// Read link ID
-		if (gsCipMux == 1)
-		{
-			if (inputBuffer[offset] >= '0' && inputBuffer[offset] <= '4' && inputBuffer[offset + 1] == ',')
-				linkID = inputBuffer[offset] - '0';
-			else
-				break;
-
-			offset += 2;
-		}
+		if (gsCipMux == 1 && !readLinkId(inputBuffer, offset, linkID))
+			break;
 
 		error = 3;
 
@@ -1972,8 +2439,6 @@ void cmd_AT_CIPSTART()
 		if (!readNumber(inputBuffer, offset, remotePort) || remotePort > 65535)
 			break;
 
-		// TCP timeout is read but ignored
-
 		if (offset + 2 < inputBufferCnt)
 		{
 			if (inputBuffer[offset] != ',')
@@ -1981,9 +2446,28 @@ void cmd_AT_CIPSTART()
 
 			++offset;
 
-			while (inputBuffer[offset] >= '0' && inputBuffer[offset] <= '9')
+			if (type == TYPE_UDP)
 			{
-				++offset;
+				// UDP local port and UDP mode
+
+				if (!readNumber(inputBuffer, offset, localPort) || localPort > 65535)
+					break;
+
+				if (inputBuffer[offset] == ',')
+				{
+					++offset;
+
+					if (!readNumber(inputBuffer, offset, udpMode) || udpMode > 2)
+						break;
+				}
+			}
+			else
+			{
+				// TCP keep-alive idle time, it goes to the link options when connected
+				if (!readNumber(inputBuffer, offset, keepAlive) || keepAlive > TCP_KEEPALIVE_MAX_IDLE)
+					break;
+
+				keepAliveSet = true;
 			}
 		}
 
@@ -2023,11 +2507,16 @@ void cmd_AT_CIPSTART()
 			{
 				cli = new WiFiClient();
 			}
+			else if (type == 1) // UDP
+			{
+				cli = new UdpClient(localPort, udpMode);
+			}
 			else if (type == 2) // SSL
 			{
 				cli = new BearSSL::WiFiClientSecure();
 
-				if (gsCipSslSize != 16384)
+				// The auto size (0) is set when the server is resolved
+				if (gsCipSslSize != 16384 && gsCipSslSize != 0)
 					static_cast<BearSSL::WiFiClientSecure *>(cli)->setBufferSizes(gsCipSslSize, 512);
 
 				if (gsCipSslAuth == 0)
@@ -2038,9 +2527,14 @@ void cmd_AT_CIPSTART()
 				{
 					static_cast<BearSSL::WiFiClientSecure *>(cli)->setFingerprint(fingerprint);
 				}
-				else if (gsCipSslAuth == 2 && CAcert->getCount() > 0) // certificate chain verification
+				else if (gsCipSslAuth == 2 && (CAcert->getCount() > 0 || certStoreCount > 0)) // certificate chain verification
 				{
-					static_cast<BearSSL::WiFiClientSecure *>(cli)->setTrustAnchors(CAcert);
+					if (CAcert->getCount() > 0)
+						static_cast<BearSSL::WiFiClientSecure *>(cli)->setTrustAnchors(CAcert);
+
+					// The anchors from the flash store are looked up by the subject hash during the handshake
+					if (certStoreCount > 0)
+						static_cast<BearSSL::WiFiClientSecure *>(cli)->setCertStore(&certStore);
 				}
 				else
 				{
@@ -2053,40 +2547,16 @@ void cmd_AT_CIPSTART()
 			if (cli == nullptr)
 				break;
 
-			// Test if the remote host exists
-			IPAddress remoteIP;
-			uint16_t _timeout = 5000;
-			if (!WiFi.hostByName(remoteAddr, remoteIP, _timeout))
-			{
-				delete cli;
-				error = 100;
-
-				Serial.println(F("DNS Fail"));
-				break;
-			}
-
-			// Connect using remote host name, not ip address (necessary for TLS)
-			if (!cli->connect(remoteAddr, remotePort))
+			// Resolve the remote host and connect in the background, the result is printed from loop()
+			if (!startLinkConnect(linkID, type, cli, remoteAddr, remotePort, keepAliveSet ? (int32_t)keepAlive : -1))
 			{
-				Serial.println("connect fail");
-
 				delete cli;
 				error = 100;
 
+				SerialTx.println(F("DNS Fail"));
 				break;
 			}
 
-			if (gsCipMux == 0)
-				Serial.println(F("CONNECT\r\n\r\nOK"));
-			else
-				Serial.printf_P(PSTR("%d,CONNECT\r\n\r\nOK\r\n"), linkID);
-
-			clients[linkID].client = cli;
-			clients[linkID].type = type;
-			clients[linkID].lastAvailableBytes = 0;
-
-			gsWasConnected = true; // Flag for CIPSTATUS command
-
 			error = 0;
 
 		} while (0);
@@ -2096,55 +2566,59 @@ void cmd_AT_CIPSTART()
 	{
 		if (error == 100)
 		{
-			Serial.printf_P(MSG_ERROR);
-			Serial.println(F("CLOSED"));
+			SerialTx.printf_P(MSG_ERROR);
+			SerialTx.println(F("CLOSED"));
 		}
 		else
 		{
 			if (error == 3)
-				Serial.println(F("Link type ERROR\r\n"));
+				SerialTx.println(F("Link type ERROR\r\n"));
 			else if (error == 4)
-				Serial.println(F("IP ERROR\r\n"));
+				SerialTx.println(F("IP ERROR\r\n"));
 			else if (error == 5)
-				Serial.println(F("ALREADY CONNECTED\r\n"));
+				SerialTx.println(F("ALREADY CONNECTED\r\n"));
 			else if (error == 6)
-				Serial.println(F("no ip"));
+				SerialTx.println(F("no ip"));
 
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 }
 
 /*
- * AT+CIPSSLSIZE - Sets the Size of SSL Buffer - only sizes 512, 1024, 2048 and 4096 are supported
+ * AT+CIPSSLSIZE - Sets the Size of SSL Buffer - only sizes 512, 1024, 2048, 4096 and 16384 are supported
+ *                 0 = auto, the smallest buffer for the servers supporting MFLN
  */
 void cmd_AT_CIPSSLSIZE()
 {
 	uint16_t offset = 13;
 
-	if (inputBuffer[offset] == '=')
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		SerialTx.printf_P(PSTR("+CIPSSLSIZE:%d\r\n"), gsCipSslSize);
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
 	{
 		unsigned int sslSize = 0;
 
 		++offset;
 
-		if (readNumber(inputBuffer, offset, sslSize) && inputBufferCnt == offset + 2 && (sslSize == 512 || sslSize == 1024 || sslSize == 2048 || sslSize == 4096 || sslSize == 16384))
+		if (readNumber(inputBuffer, offset, sslSize) && inputBufferCnt == offset + 2
+			&& (sslSize == 0 || sslSize == 512 || sslSize == 1024 || sslSize == 2048 || sslSize == 4096 || sslSize == 16384))
 		{
-			if (sslSize == 16384)
-				sslSize = 0; // default value
-
 			gsCipSslSize = sslSize;
 
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -2163,60 +2637,369 @@ void cmd_AT_CIPSEND()
 
 		// Test the input
 
-		if (inputBuffer[10] != '=')
-			break;
-
-		// Read linkId
-		if (inputBuffer[11] >= '0' && inputBuffer[11] <= '5' && inputBuffer[12] == ',')
+		if (inputBufferCnt == 12) // AT+CIPSEND without parameters - passthrough mode
 		{
-			if (gsCipMux == 0)
+			if (gsCipMode != 1)
+				break;
+
+			if (clients[0].client == nullptr || !clients[0].client->connected())
 			{
-				Serial.println("MUX=0");
+				SerialTx.println(F("link is not valid"));
 				break;
 			}
 
-			linkId = inputBuffer[11] - '0';
+			AT_DEBUG_PRINT("--- passthrough on\r\n");
 
-			offset = 13;
+			gsFlag_Passthrough = true;
+			dataRead = 0;
+
+			error = 2;
+			break;
 		}
-		else
-			offset = 11;
 
-		client_t *cli = &(clients[linkId]);
+		if (inputBuffer[10] != '=')
+			break;
 
-		// Test the link
-		if (cli->client == nullptr || !cli->client->connected())
+		// Read linkId
+		offset = 11;
+
+		if (readLinkId(inputBuffer, offset, linkId) && gsCipMux == 0)
 		{
-			Serial.println(F("link is not valid"));
+			SerialTx.println("MUX=0");
 			break;
 		}
 
-		if (!readNumber(inputBuffer, offset, size) || offset + 2 != inputBufferCnt)
-			break;
+		client_t *cli = &(clients[linkId]);
 
-		if (size > 2048)
+		// Test the link
+		if (cli->client == nullptr || !cli->client->connected())
 		{
-			Serial.println(F("too long"));
+			SerialTx.println(F("link is not valid"));
 			break;
 		}
 
-		AT_DEBUG_PRINTF("--- linkId: %d, size: %d\r\n", linkId, size);
+		if (!readNumber(inputBuffer, offset, size))
+			break;
 
-		// Start reading data into the buffer
+		// UDP: the remote host of this datagram may follow
+		uint32_t remoteIP = 0;
+		uint32_t remotePort = 0;
 
-		cli->sendLength = size;
+		if (cli->type == TYPE_UDP && inputBuffer[offset] == ',')
+		{
+			++offset;
 
-		gsLinkIdReading = linkId;
-		dataRead = 0;
+			if (!readIpAddress(inputBuffer, offset, remoteIP) || inputBuffer[offset] != ',')
+				break;
 
-		error = 0;
+			++offset;
 
-	} while (0);
+			if (!readNumber(inputBuffer, offset, remotePort) || remotePort == 0 || remotePort > 65535)
+				break;
+		}
 
-	if (error > 0)
-		Serial.printf_P(MSG_ERROR);
+		if (offset + 2 != inputBufferCnt)
+			break;
+
+		if (size > CIPSEND_MAX_LENGTH || (cli->type == TYPE_UDP && size > UDP_MAX_LENGTH))
+		{
+			SerialTx.println(F("too long"));
+			break;
+		}
+
+		if (remotePort != 0)
+			static_cast<UdpClient *>(cli->client)->setNextDestination(IPAddress(remoteIP), remotePort);
+
+		// The data must not overtake the queued AT+CIPSENDBUF segments
+		if (cli->sendQueue != nullptr && sendQueueSegments(cli->sendQueue) > 0)
+		{
+			SerialTx.println(F("busy"));
+			PERF_COUNT(PERF_BUSY);
+			break;
+		}
+
+		AT_DEBUG_PRINTF("--- linkId: %d, size: %d\r\n", linkId, size);
+
+		// Start reading data into the buffer
+
+		cli->sendLength = size;
+
+		gsLinkIdReading = linkId;
+		dataRead = 0;
+		dataSent = 0;
+		sendFailed = false;
+
+		error = 0;
+
+	} while (0);
+
+	if (error == 2)
+		SerialTx.print(F("\r\nOK\r\n\r\n>"));
+	else if (error > 0)
+		SerialTx.printf_P(MSG_ERROR);
+	else
+		SerialTx.print(F("OK\r\n> "));
+}
+
+/*
+ * AT+CIPSENDMULTI - Sends one payload to several links (custom command)
+ *   AT+CIPSENDMULTI=<length>[,<link ID>...], without the link IDs the data go to all open links
+ * The data are received once into sendBuffer and written to each link
+ */
+void cmd_AT_CIPSENDMULTI()
+{
+	uint8_t error = 1;
+	uint16_t offset = strlen("AT+CIPSENDMULTI");
+
+	do
+	{
+		uint32_t size;
+		bool targets[MAX_LINKS] = {false};
+		bool allLinks = true;
+
+		if (inputBuffer[offset] != '=' || gsCipMode != 0)
+			break;
+
+		if (gsCipMux == 0)
+		{
+			SerialTx.println(F("MUX=0"));
+			break;
+		}
+
+		++offset;
+
+		if (!readNumber(inputBuffer, offset, size) || size == 0)
+			break;
+
+		if (size > UDP_MAX_LENGTH)
+		{
+			SerialTx.println(F("too long"));
+			break;
+		}
+
+		// The list of the links
+		while (inputBuffer[offset] == ',')
+		{
+			uint32_t linkId;
+
+			++offset;
+
+			if (!readNumber(inputBuffer, offset, linkId) || linkId >= MAX_LINKS)
+			{
+				offset = 0; // Error
+				break;
+			}
+
+			targets[linkId] = true;
+			allLinks = false;
+		}
+
+		if (offset + 2 != inputBufferCnt)
+			break;
+
+		error = 0;
+		uint8_t count = 0;
+
+		for (uint8_t i = 0; i < MAX_LINKS && error == 0; ++i)
+		{
+			client_t *cli = &clients[i];
+			bool connected = cli->client != nullptr && cli->client->connected();
+
+			if (allLinks)
+				targets[i] = connected;
+			else if (targets[i] && !connected)
+			{
+				SerialTx.println(F("link is not valid"));
+				error = 1;
+			}
+
+			// The data must not overtake the queued AT+CIPSENDBUF segments
+			if (targets[i] && cli->sendQueue != nullptr && sendQueueSegments(cli->sendQueue) > 0)
+			{
+				SerialTx.println(F("busy"));
+				PERF_COUNT(PERF_BUSY);
+				error = 1;
+			}
+
+			if (targets[i])
+				++count;
+		}
+
+		if (error != 0 || count == 0)
+		{
+			error = 1;
+			break;
+		}
+
+		AT_DEBUG_PRINTF("--- links: %d, size: %d\r\n", count, size);
+
+		// Start reading data into the buffer
+		for (uint8_t i = 0; i < MAX_LINKS; ++i)
+		{
+			clients[i].sendMulti = targets[i];
+			clients[i].sendMultiTarget = targets[i];
+		}
+
+		gsSendMultiLength = size;
+		dataRead = 0;
+
+	} while (0);
+
+	if (error > 0)
+		SerialTx.printf_P(MSG_ERROR);
+	else
+		SerialTx.print(F("OK\r\n> "));
+}
+
+/*
+ * AT+CIPSENDBUF - Writes Data into the TCP-Send-Buffer
+ * The answer is <segment id>,<id of the last sent segment> and the prompt, the segment
+ * is written to the link in the background, <segment id>,SEND OK reports the completion
+ */
+void cmd_AT_CIPSENDBUF()
+{
+	uint8_t error = 1;
+	uint32_t seq = 0;
+	uint32_t sentSeq = 0;
+
+	do
+	{
+		uint8_t linkId = 0;
+		uint16_t offset;
+		uint32_t size = 0;
+
+		if (inputBuffer[13] != '=' || gsCipMode != 0)
+			break;
+
+		// Read linkId
+		offset = 14;
+
+		if (readLinkId(inputBuffer, offset, linkId) && gsCipMux == 0)
+		{
+			SerialTx.println("MUX=0");
+			break;
+		}
+
+		client_t *cli = &(clients[linkId]);
+
+		// Test the link
+		if (cli->client == nullptr || !cli->client->connected())
+		{
+			SerialTx.println(F("link is not valid"));
+			break;
+		}
+
+		// The segments may be split at the end of the ring buffer, not usable for datagrams
+		if (cli->type == TYPE_UDP)
+		{
+			SerialTx.println(F("UDP not supported"));
+			break;
+		}
+
+		if (!readNumber(inputBuffer, offset, size) || offset + 2 != inputBufferCnt)
+			break;
+
+		if (size == 0 || size > SEND_QUEUE_SIZE)
+		{
+			SerialTx.println(F("too long"));
+			break;
+		}
+
+		if (cli->sendQueue == nullptr)
+		{
+			cli->sendQueue = sendQueueCreate();
+
+			if (cli->sendQueue == nullptr)
+			{
+				SerialTx.println(F("out of mem"));
+				break;
+			}
+		}
+
+		if (!sendQueueBegin(cli->sendQueue, size))
+		{
+			SerialTx.println(F("buffer full"));
+			break;
+		}
+
+		seq = sendQueueNextSeq(cli->sendQueue);
+		sentSeq = sendQueueSentSeq(cli->sendQueue);
+
+		AT_DEBUG_PRINTF("--- linkId: %d, size: %d, segment: %d\r\n", linkId, size, seq);
+
+		// Start reading data into the queue
+
+		cli->sendLength = size;
+
+		gsLinkIdReading = linkId;
+		gsFlag_SendBuf = true;
+		dataRead = 0;
+
+		error = 0;
+
+	} while (0);
+
+	if (error > 0)
+		SerialTx.printf_P(MSG_ERROR);
+	else
+		SerialTx.printf_P(PSTR("%d,%d\r\n\r\nOK\r\n> "), seq, sentSeq);
+}
+
+/*
+ * AT+CIPBUFSTATUS - Checks the Status of the TCP-Send-Buffer
+ * Answer: <next segment id>,<last sent segment id>,<last sent segment id>,<free bytes>,<queued segments>
+ * A segment counts as sent when the client accepted it, the second and third fields are the same
+ */
+void cmd_AT_CIPBUFSTATUS()
+{
+	uint8_t error = 1;
+
+	do
+	{
+		uint8_t linkId = 0;
+
+		if (gsCipMux == 1)
+		{
+			uint16_t offset = 16;
+			uint32_t id;
+
+			if (inputBuffer[15] != '=' || !readNumber(inputBuffer, offset, id) || id >= MAX_LINKS ||
+				inputBufferCnt != offset + 2)
+				break;
+
+			linkId = id;
+		}
+		else if (inputBufferCnt != 17)
+			break;
+
+		client_t *cli = &(clients[linkId]);
+
+		if (cli->client == nullptr || !cli->client->connected())
+		{
+			SerialTx.println(F("link is not valid"));
+			break;
+		}
+
+		if (cli->sendQueue == nullptr)
+		{
+			SerialTx.printf_P(PSTR("+CIPBUFSTATUS:1,0,0,%d,0\r\n"), SEND_QUEUE_SIZE);
+		}
+		else
+		{
+			uint32_t sentSeq = sendQueueSentSeq(cli->sendQueue);
+
+			SerialTx.printf_P(PSTR("+CIPBUFSTATUS:%d,%d,%d,%d,%d\r\n"), sendQueueNextSeq(cli->sendQueue), sentSeq, sentSeq,
+							sendQueueFree(cli->sendQueue), sendQueueSegments(cli->sendQueue));
+		}
+
+		error = 0;
+
+	} while (0);
+
+	if (error > 0)
+		SerialTx.printf_P(MSG_ERROR);
 	else
-		Serial.print(F("OK\r\n> "));
+		SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -2238,7 +3021,7 @@ void cmd_AT_CIPCLOSEMODE()
 		if (inputBuffer[15] != '=')
 			break;
 
-		if (!readNumber(inputBuffer, offset, inputVal) || inputVal > 5)
+		if (!readNumber(inputBuffer, offset, inputVal) || inputVal > MAX_LINKS)
 			break;
 
 		if (gsCipMux == 0)
@@ -2268,9 +3051,9 @@ void cmd_AT_CIPCLOSEMODE()
 	} while (0);
 
 	if (error > 0)
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	else
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -2289,12 +3072,12 @@ void cmd_AT_CIPCLOSE()
 
 		if (inputBuffer[11] == '=')
 		{
-			if (!readNumber(inputBuffer, offset, linkId) || linkId > 5 || inputBufferCnt != offset + 2)
+			if (!readNumber(inputBuffer, offset, linkId) || linkId > MAX_LINKS || inputBufferCnt != offset + 2)
 				break;
 
 			if (gsCipMux == 0)
 			{
-				Serial.println(F("MUX=0"));
+				SerialTx.println(F("MUX=0"));
 				break;
 			}
 		}
@@ -2302,25 +3085,25 @@ void cmd_AT_CIPCLOSE()
 			break;
 		else if (gsCipMux != 0)
 		{
-			Serial.println(F("MUX=1"));
+			SerialTx.println(F("MUX=1"));
 			break;
 		}
 
 		error = 0;
 
-		for (uint8_t id = 0; id <= 4; ++id)
+		for (uint8_t id = 0; id < MAX_LINKS; ++id)
 		{
-			if (id == linkId || linkId == 5)
+			if (id == linkId || linkId == MAX_LINKS)
 			{
 				// Disconnect
 				WiFiClient *cli = clients[id].client;
 
 				if (cli == nullptr)
 				{
-					if (linkId != 5)
+					if (linkId != MAX_LINKS)
 					{
 						if (gsCipMux != 0)
-							Serial.println(F("UNLINK"));
+							SerialTx.println(F("UNLINK"));
 
 						error = 1;
 						break;
@@ -2334,9 +3117,9 @@ void cmd_AT_CIPCLOSE()
 					DeleteClient(id);
 
 					if (gsCipMux == 0)
-						Serial.println(F("CLOSED"));
+						SerialTx.println(F("CLOSED"));
 					else
-						Serial.printf_P(PSTR("%d,CLOSED\r\n"), id);
+						SerialTx.printf_P(PSTR("%d,CLOSED\r\n"), id);
 				}
 			}
 
@@ -2346,9 +3129,9 @@ void cmd_AT_CIPCLOSE()
 	} while (0);
 
 	if (error > 0)
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	else
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -2358,12 +3141,12 @@ void cmd_AT_CIFSR()
 {
 	IPAddress ip = WiFi.localIP();
 	if (!ip.isSet())
-		Serial.println(F("+CISFR:STAIP,\"0.0.0.0\""));
+		SerialTx.println(F("+CISFR:STAIP,\"0.0.0.0\""));
 	else
-		Serial.printf_P(PSTR("+CISFR:STAIP,\"%s\"\r\n"), ip.toString().c_str());
+		SerialTx.printf_P(PSTR("+CISFR:STAIP,\"%s\"\r\n"), ip.toString().c_str());
 
-	Serial.printf_P(PSTR("+CIFSR:STAMAC,\"%s\"\r\n"), WiFi.macAddress().c_str());
-	Serial.printf_P(MSG_OK);
+	SerialTx.printf_P(PSTR("+CIFSR:STAMAC,\"%s\"\r\n"), WiFi.macAddress().c_str());
+	SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -2375,7 +3158,7 @@ void cmd_AT_CIPMUX()
 
 	if (inputBuffer[9] == '?' && inputBufferCnt == 12)
 	{
-		Serial.printf_P(PSTR("+CIPMUX:%d\r\n\r\nOK\r\n"), gsCipMux);
+		SerialTx.printf_P(PSTR("+CIPMUX:%d\r\n\r\nOK\r\n"), gsCipMux);
 		error = false;
 	}
 	else if (inputBuffer[9] == '=')
@@ -2387,11 +3170,17 @@ void cmd_AT_CIPMUX()
 		{
 			bool openedError = false;
 
-			for (uint8_t i = 0; i <= 4; ++i)
+			if (mux == 1 && gsCipMode == 1)
+			{
+				SerialTx.println(F("CIPMODE must be 0"));
+				openedError = true;
+			}
+
+			for (uint8_t i = 0; i < MAX_LINKS && !openedError; ++i)
 			{
 				if (clients[i].client != nullptr)
 				{
-					Serial.println(F("link is builded"));
+					SerialTx.println(F("link is builded"));
 					openedError = true;
 					break;
 				}
@@ -2400,7 +3189,7 @@ void cmd_AT_CIPMUX()
 			{
 				if (servers[i].status() != CLOSED)
 				{
-					Serial.println(F("CIPSERVER must be 0"));
+					SerialTx.println(F("CIPSERVER must be 0"));
 					openedError = true;
 					break;
 				}
@@ -2408,7 +3197,7 @@ void cmd_AT_CIPMUX()
 			if (!openedError)
 			{
 				gsCipMux = mux;
-				Serial.printf_P(MSG_OK);
+				SerialTx.printf_P(MSG_OK);
 				error = false;
 			}
 		}
@@ -2416,7 +3205,7 @@ void cmd_AT_CIPMUX()
 
 	if (error)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -2428,7 +3217,7 @@ void cmd_AT_CIPSERVER()
 
 	if (!gsCipMux)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 		return;
 	}
 	uint8_t error = 1; // 1 = generic error, 0 = ok
@@ -2480,6 +3269,15 @@ void cmd_AT_CIPSERVER()
 				if (servers[i].port() == port || port == 0)
 				{
 					servers[i].close();
+					serversConfig[i] = {0, 0};
+
+					// The links accepted by the server stay open, the server settings no longer apply
+					for (uint8_t j = 0; j < MAX_LINKS; ++j)
+					{
+						if (clients[j].serverId == i)
+							clients[j].serverId = SERVER_NONE;
+					}
+
 					error = 0;
 					break;
 				}
@@ -2516,9 +3314,9 @@ void cmd_AT_CIPSERVER()
 	}
 	if (error == 3 || error == 4)
 	{
-		Serial.println("no change");
+		SerialTx.println("no change");
 	}
-	Serial.printf_P(error ? MSG_ERROR : MSG_OK);
+	SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
 }
 
 /*
@@ -2530,8 +3328,8 @@ void cmd_AT_CIPSERVERMAXCONN()
 
 	if (inputBuffer[offset] == '?')
 	{
-		Serial.printf_P(PSTR("+CIPSERVERMAXCONN:%d\r\n"), gsServersMaxConn);
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(PSTR("+CIPSERVERMAXCONN:%d\r\n"), gsServersMaxConn);
+		SerialTx.printf_P(MSG_OK);
 		return;
 	}
 
@@ -2542,84 +3340,400 @@ void cmd_AT_CIPSERVERMAXCONN()
 		if (inputBuffer[offset] != '=')
 			break;
 		++offset;
-		if (!readNumber(inputBuffer, offset, max) || max < 1 || max > 5 || inputBufferCnt != offset + 2)
+		if (!readNumber(inputBuffer, offset, max) || max < 1 || max > MAX_LINKS || inputBufferCnt != offset + 2)
 			break;
 		gsServersMaxConn = max;
 		error = 0;
 	} while (0);
 
-	Serial.printf_P(error ? MSG_ERROR : MSG_OK);
+	SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
 }
 
 /*
- * AT+CIPSTO - Sets the TCP Server Timeout
+ * AT+CIPSERVERCFG - Sets the maximum connections and the timeout of a running server (custom command)
+ *                   0 = the global AT+CIPSERVERMAXCONN / AT+CIPSTO setting applies
  */
-void cmd_AT_CIPSTO()
+void cmd_AT_CIPSERVERCFG()
 {
-	uint16_t offset = strlen("AT+CIPSTO");
+	uint16_t offset = strlen("AT+CIPSERVERCFG");
 
-	if (inputBuffer[offset] == '?')
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
 	{
-		Serial.printf_P(PSTR("+CIPSTO:%d\r\n"), gsServerConnTimeout / 1000);
-		Serial.printf_P(MSG_OK);
+		for (uint8_t i = 0; i < SERVERS_COUNT; ++i)
+		{
+			if (servers[i].status() == CLOSED)
+				continue;
+
+			uint8_t connCount = 0;
+			for (uint8_t j = 0; j < MAX_LINKS; ++j)
+			{
+				if (clients[j].client != nullptr && clients[j].serverId == i)
+					++connCount;
+			}
+
+			SerialTx.printf_P(PSTR("+CIPSERVERCFG:%d,%d,%d,%d\r\n"), servers[i].port(), serversConfig[i].maxConn,
+							serversConfig[i].timeout / 1000, connCount);
+		}
+		SerialTx.printf_P(MSG_OK);
 		return;
 	}
 
-	uint8_t error = 1; // 1 = generic error, 0 = ok
+	uint8_t error = 1; // 1 = generic error, 2 = server not running, 0 = ok
+	uint32_t port = 0;
+	uint32_t maxConn = 0;
 	uint32_t to = 0;
 	do
 	{
 		if (inputBuffer[offset] != '=')
 			break;
 		++offset;
+		if (!readNumber(inputBuffer, offset, port) || port > 65535 || inputBuffer[offset] != ',')
+			break;
+		++offset;
+		if (!readNumber(inputBuffer, offset, maxConn) || maxConn > MAX_LINKS || inputBuffer[offset] != ',')
+			break;
+		++offset;
 		if (!readNumber(inputBuffer, offset, to) || to > 7200 || inputBufferCnt != offset + 2)
 			break;
-		gsServerConnTimeout = to * 1000;
-		error = 0;
-	} while (0);
-
-	Serial.printf_P(error ? MSG_ERROR : MSG_OK);
-}
-
-/*
- * AT+CIPDINFO - Shows the Remote IP and Port with +IPD
- */
-void cmd_AT_CIPDINFO()
-{
-	if (inputBuffer[11] == '?' && inputBufferCnt == 14)
-	{
-		Serial.printf_P(PSTR("+CIPDINFO:%s\r\n\r\nOK\r\n"), gsCipdInfo ? "TRUE" : "FALSE");
-	}
-	else if (inputBuffer[11] == '=')
-	{
-		uint32_t ipdInfo;
-		uint16_t offset = 12;
 
-		if (readNumber(inputBuffer, offset, ipdInfo) && ipdInfo <= 1 && inputBufferCnt == offset + 2)
-		{
-			gsCipdInfo = ipdInfo;
-			Serial.printf_P(MSG_OK);
-		}
-		else
+		error = 2;
+		for (uint8_t i = 0; i < SERVERS_COUNT; ++i)
 		{
-			Serial.printf_P(MSG_ERROR);
+			if (servers[i].status() != CLOSED && servers[i].port() == port)
+			{
+				serversConfig[i].maxConn = maxConn;
+				serversConfig[i].timeout = to * 1000;
+				error = 0;
+				break;
+			}
 		}
-	}
-	else
+	} while (0);
+
+	if (error == 2)
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.println(F("server not running"));
 	}
+	SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
 }
 
 /*
- * AT+CIPRECVMODE - Set TCP Receive Mode
+ * AT+CIPRECVCOALESCE - Sets the byte threshold and the maximum hold time [ms] of merging
+ *                      the received data of a link into fewer +IPD (custom command), 0 bytes = off
+ *   AT+CIPRECVCOALESCE=[<link ID>,]<bytes>,<hold time>
+ * Kept in the link options, applies to the open link or to the next connection of the link ID
  */
-void cmd_AT_CIPRECVMODE()
+void cmd_AT_CIPRECVCOALESCE()
 {
-	if (inputBuffer[14] == '?' && inputBufferCnt == 17)
+	uint16_t offset = strlen("AT+CIPRECVCOALESCE");
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
 	{
-		Serial.printf_P(PSTR("+CIPRECVMODE:%d\r\n\r\nOK\r\n"), gsCipRecvMode);
-	}
+		uint8_t maxCli = (gsCipMux == 1 ? MAX_LINKS - 1 : 0);
+
+		for (uint8_t i = 0; i <= maxCli; ++i)
+			SerialTx.printf_P(PSTR("+CIPRECVCOALESCE:%d,%d,%d\r\n"), i, linkOptions[i].recvCoalesceBytes,
+							linkOptions[i].recvCoalesceTime);
+
+		SerialTx.printf_P(MSG_OK);
+		return;
+	}
+
+	uint8_t error = 1;
+
+	do
+	{
+		uint8_t linkId = 0;
+		uint32_t bytes;
+		uint32_t holdTime;
+
+		if (inputBuffer[offset] != '=')
+			break;
+
+		++offset;
+
+		if (gsCipMux == 1 && !readLinkId(inputBuffer, offset, linkId))
+			break;
+
+		if (!readNumber(inputBuffer, offset, bytes) || bytes > RECV_COALESCE_MAX_BYTES || inputBuffer[offset] != ',')
+			break;
+
+		++offset;
+
+		if (!readNumber(inputBuffer, offset, holdTime) || holdTime > RECV_COALESCE_MAX_TIME || inputBufferCnt != offset + 2)
+			break;
+
+		linkOptions[linkId].recvCoalesceBytes = bytes;
+		linkOptions[linkId].recvCoalesceTime = holdTime;
+
+		error = 0;
+	} while (0);
+
+	SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
+}
+
+/*
+ * AT+CIPTCPOPT - Sets the TCP options of a link (custom command):
+ *   AT+CIPTCPOPT=[<link ID>,]<no delay>,<sync>,<write timeout>,<keep alive>[,<interval>,<count>]
+ * The options apply to the open link or to the next connection of the link ID, until the link closes
+ */
+void cmd_AT_CIPTCPOPT()
+{
+	uint16_t offset = strlen("AT+CIPTCPOPT");
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		uint8_t maxCli = (gsCipMux == 1 ? MAX_LINKS - 1 : 0);
+
+		for (uint8_t i = 0; i <= maxCli; ++i)
+			printLinkOptions(i);
+
+		SerialTx.printf_P(MSG_OK);
+		return;
+	}
+
+	uint8_t error = 1;
+
+	do
+	{
+		uint8_t linkId = 0;
+		linkOptions_t opt;
+		uint32_t noDelay, sync, writeTimeout, keepAlive;
+
+		if (inputBuffer[offset] != '=')
+			break;
+
+		++offset;
+
+		if (gsCipMux == 1 && !readLinkId(inputBuffer, offset, linkId))
+			break;
+
+		opt = linkOptions[linkId];
+
+		if (!readNumber(inputBuffer, offset, noDelay) || noDelay > 1 || inputBuffer[offset] != ',')
+			break;
+
+		++offset;
+
+		if (!readNumber(inputBuffer, offset, sync) || sync > 1 || inputBuffer[offset] != ',')
+			break;
+
+		++offset;
+
+		if (!readNumber(inputBuffer, offset, writeTimeout) || writeTimeout > TCP_WRITE_TIMEOUT_MAX || inputBuffer[offset] != ',')
+			break;
+
+		++offset;
+
+		if (!readNumber(inputBuffer, offset, keepAlive) || keepAlive > TCP_KEEPALIVE_MAX_IDLE)
+			break;
+
+		// Optional keep-alive interval and count
+		if (inputBuffer[offset] == ',')
+		{
+			uint32_t interval, count;
+
+			++offset;
+
+			if (!readNumber(inputBuffer, offset, interval) || interval < 1 || interval > 255 || inputBuffer[offset] != ',')
+				break;
+
+			++offset;
+
+			if (!readNumber(inputBuffer, offset, count) || count < 1 || count > 255)
+				break;
+
+			opt.keepAliveInterval = interval;
+			opt.keepAliveCount = count;
+		}
+
+		if (inputBufferCnt != offset + 2)
+			break;
+
+		opt.noDelay = noDelay;
+		opt.sync = sync;
+		opt.writeTimeout = writeTimeout;
+		opt.keepAliveIdle = keepAlive;
+
+		linkOptions[linkId] = opt;
+
+		// The open link changes immediately
+		if (clients[linkId].client != nullptr && clients[linkId].client->connected())
+			applyLinkOptions(linkId);
+
+		error = 0;
+	} while (0);
+
+	SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
+}
+
+/*
+ * AT+CIPBINMODE - Starts the binary framing mode (custom command), the BIN_EXIT frame ends it
+ */
+void cmd_AT_CIPBINMODE()
+{
+	uint16_t offset = strlen("AT+CIPBINMODE");
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		SerialTx.printf_P(PSTR("+CIPBINMODE:%d\r\n"), gsFlag_Binary);
+		SerialTx.printf_P(MSG_OK);
+		return;
+	}
+
+	uint8_t error = 1;
+
+	do
+	{
+		if (inputBuffer[offset] != '=' || inputBuffer[offset + 1] != '1' || inputBufferCnt != offset + 4)
+			break;
+
+		// The received data are delivered in the frames as they come
+		if (gsCipMode != 0 || gsCipRecvMode != 0)
+		{
+			SerialTx.println(F("CIPMODE and CIPRECVMODE must be 0"));
+			break;
+		}
+
+		// The completion of the queued segments would be printed as text
+		for (uint8_t i = 0; i < MAX_LINKS; ++i)
+		{
+			if (clients[i].sendQueue != nullptr && sendQueueSegments(clients[i].sendQueue) > 0)
+			{
+				SerialTx.println(F("busy"));
+				error = 2;
+				break;
+			}
+		}
+
+		if (error == 2)
+			break;
+
+		error = 0;
+	} while (0);
+
+	if (error > 0)
+	{
+		SerialTx.printf_P(MSG_ERROR);
+		return;
+	}
+
+	SerialTx.printf_P(MSG_OK);
+
+	AT_DEBUG_PRINT("--- binary mode on\r\n");
+
+	binModeStart();
+	gsFlag_Binary = true;
+}
+
+/*
+ * AT+CIPSTO - Sets the TCP Server Timeout
+ */
+void cmd_AT_CIPSTO()
+{
+	uint16_t offset = strlen("AT+CIPSTO");
+
+	if (inputBuffer[offset] == '?')
+	{
+		SerialTx.printf_P(PSTR("+CIPSTO:%d\r\n"), gsServerConnTimeout / 1000);
+		SerialTx.printf_P(MSG_OK);
+		return;
+	}
+
+	uint8_t error = 1; // 1 = generic error, 0 = ok
+	uint32_t to = 0;
+	do
+	{
+		if (inputBuffer[offset] != '=')
+			break;
+		++offset;
+		if (!readNumber(inputBuffer, offset, to) || to > 7200 || inputBufferCnt != offset + 2)
+			break;
+		gsServerConnTimeout = to * 1000;
+		error = 0;
+	} while (0);
+
+	SerialTx.printf_P(error ? MSG_ERROR : MSG_OK);
+}
+
+/*
+ * AT+CIPMODE - Sets Transmission Mode
+ *              0 = normal mode
+ *              1 = UART-WiFi passthrough mode, only for AT+CIPMUX=0
+ */
+void cmd_AT_CIPMODE()
+{
+	if (inputBuffer[10] == '?' && inputBufferCnt == 13)
+	{
+		SerialTx.printf_P(PSTR("+CIPMODE:%d\r\n\r\nOK\r\n"), gsCipMode);
+	}
+	else if (inputBuffer[10] == '=')
+	{
+		uint32_t mode;
+		uint16_t offset = 11;
+
+		if (readNumber(inputBuffer, offset, mode) && mode <= 1 && inputBufferCnt == offset + 2)
+		{
+			if (mode == 1 && gsCipMux != 0)
+			{
+				SerialTx.println(F("CIPMUX must be 0"));
+				SerialTx.printf_P(MSG_ERROR);
+			}
+			else
+			{
+				gsCipMode = mode;
+				SerialTx.printf_P(MSG_OK);
+			}
+		}
+		else
+		{
+			SerialTx.printf_P(MSG_ERROR);
+		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+CIPDINFO - Shows the Remote IP and Port with +IPD
+ */
+void cmd_AT_CIPDINFO()
+{
+	if (inputBuffer[11] == '?' && inputBufferCnt == 14)
+	{
+		SerialTx.printf_P(PSTR("+CIPDINFO:%s\r\n\r\nOK\r\n"), gsCipdInfo ? "TRUE" : "FALSE");
+	}
+	else if (inputBuffer[11] == '=')
+	{
+		uint32_t ipdInfo;
+		uint16_t offset = 12;
+
+		if (readNumber(inputBuffer, offset, ipdInfo) && ipdInfo <= 1 && inputBufferCnt == offset + 2)
+		{
+			gsCipdInfo = ipdInfo;
+			SerialTx.printf_P(MSG_OK);
+		}
+		else
+		{
+			SerialTx.printf_P(MSG_ERROR);
+		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+CIPRECVMODE - Set TCP Receive Mode
+ */
+void cmd_AT_CIPRECVMODE()
+{
+	if (inputBuffer[14] == '?' && inputBufferCnt == 17)
+	{
+		SerialTx.printf_P(PSTR("+CIPRECVMODE:%d\r\n\r\nOK\r\n"), gsCipRecvMode);
+	}
 	else if (inputBuffer[14] == '=')
 	{
 		uint32_t recvMode;
@@ -2627,17 +3741,24 @@ void cmd_AT_CIPRECVMODE()
 
 		if (readNumber(inputBuffer, offset, recvMode) && recvMode <= 1 && inputBufferCnt == offset + 2)
 		{
+			// The held or announced data are reported again in the new mode
+			if (recvMode != gsCipRecvMode)
+			{
+				for (uint8_t i = 0; i < MAX_LINKS; ++i)
+					clients[i].lastAvailableBytes = 0;
+			}
+
 			gsCipRecvMode = recvMode;
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -2660,27 +3781,20 @@ void cmd_AT_CIPRECVDATA()
 			break;
 
 		// Read linkId
-		if (inputBuffer[15] >= '0' && inputBuffer[15] <= '5' && inputBuffer[16] == ',')
-		{
-			if (gsCipMux == 0)
-			{
-				Serial.println("MUX=0");
-				break;
-			}
-
-			linkId = inputBuffer[15] - '0';
+		offset = 15;
 
-			offset = 17;
+		if (readLinkId(inputBuffer, offset, linkId) && gsCipMux == 0)
+		{
+			SerialTx.println("MUX=0");
+			break;
 		}
-		else
-			offset = 15;
 
 		client_t *cli = &(clients[linkId]);
 
 		// Test the link
 		if (cli->client == nullptr)
 		{
-			Serial.println(F("link is not valid"));
+			SerialTx.println(F("link is not valid"));
 			break;
 		}
 
@@ -2689,7 +3803,7 @@ void cmd_AT_CIPRECVDATA()
 
 		if (size > 2048)
 		{
-			Serial.println(F("too long"));
+			SerialTx.println(F("too long"));
 			break;
 		}
 
@@ -2714,9 +3828,9 @@ void cmd_AT_CIPRECVDATA()
 	} while (0);
 
 	if (error > 0)
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	else
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 }
 
 /*
@@ -2726,25 +3840,25 @@ void cmd_AT_CIPRECVLEN()
 {
 	if (inputBuffer[13] == '?' && inputBufferCnt == 16)
 	{
-		Serial.print(F("+CIPRECVLEN:"));
+		SerialTx.print(F("+CIPRECVLEN:"));
 
-		for (uint8_t i = 0; i <= 4; ++i)
+		for (uint8_t i = 0; i < MAX_LINKS; ++i)
 		{
 			int avail = 0;
 
 			if (i > 0)
-				Serial.print(',');
+				SerialTx.print(',');
 
 			if (clients[i].client != nullptr)
 			{
 				avail = clients[i].client->available();
 			}
 
-			Serial.print(avail);
+			SerialTx.print(avail);
 		}
 
-		Serial.println();
-		Serial.printf_P(MSG_OK);
+		SerialTx.println();
+		SerialTx.printf_P(MSG_OK);
 	}
 }
 
@@ -2757,21 +3871,21 @@ void cmd_AT_CIPSNTPCFG() // FIXME:
 
 	if (inputBuffer[13] == '?' && inputBufferCnt == 16)
 	{
-		Serial.printf_P(PSTR("+CIPSNTPCFG:%d"), gsSTNPEnabled ? 1 : 0);
+		SerialTx.printf_P(PSTR("+CIPSNTPCFG:%d"), gsSTNPEnabled ? 1 : 0);
 
 		if (gsSTNPEnabled)
 		{
-			Serial.printf_P(PSTR(",%d"), gsSTNPTimezone);
+			SerialTx.printf_P(PSTR(",%d"), gsSTNPTimezone);
 
 			for (uint8_t i = 0; i < 3; ++i)
 			{
 				const char *sn = sntp_getservername(i);
 				if (sn != nullptr)
-					Serial.printf_P(PSTR(",\"%s\""), sn);
+					SerialTx.printf_P(PSTR(",\"%s\""), sn);
 			}
 		}
 
-		Serial.println();
+		SerialTx.println();
 
 		error = 0;
 	}
@@ -2837,11 +3951,11 @@ void cmd_AT_CIPSNTPCFG() // FIXME:
 
 	if (error == 0)
 	{
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -2860,160 +3974,436 @@ void cmd_AT_CIPSNTPTIME()
 
 	struct tm *info = localtime((const time_t *)&now);
 
-	Serial.printf_P(PSTR("+CIPSNTPTIME:%s"), asctime(info));
-	Serial.println(F("OK"));
+	SerialTx.printf_P(PSTR("+CIPSNTPTIME:%s"), asctime(info));
+	SerialTx.println(F("OK"));
+}
+
+/*
+ * AT+CIPDNS - Sets User-defined DNS Servers
+ */
+void cmd_AT_CIPDNS(commands_t cmd)
+{
+	uint16_t offset = 9;
+
+	if (cmd != CMD_AT_CIPDNS)
+		offset += 4;
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		dnsConfig_t cfg;
+
+		if (cmd == CMD_AT_CIPDNS_DEF)
+		{
+			cfg = Settings::getDnsConfig();
+		}
+		else
+		{
+			cfg = {WiFi.dnsIP(0), WiFi.dnsIP(1)};
+		}
+
+		const char *cmdSuffix = "";
+		if (cmd == CMD_AT_CIPDNS_CUR)
+			cmdSuffix = suffix_CUR;
+		else if (cmd == CMD_AT_CIPDNS_DEF)
+			cmdSuffix = suffix_DEF;
+
+		if (cfg.dns1 != 0)
+		{
+			SerialTx.printf_P(PSTR("+CIPDNS%s:%s\r\n"), cmdSuffix, IPAddress(cfg.dns1).toString().c_str());
+
+			if (cfg.dns2 != 0 && cfg.dns1 != cfg.dns2)
+			{
+				SerialTx.printf_P(PSTR("+CIPDNS%s:%s\r\n"), cmdSuffix, IPAddress(cfg.dns2).toString().c_str());
+			}
+		}
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
+	{
+		uint8_t error = 1;
+
+		dnsConfig_t cfg = {0, 0};
+		uint32_t dnsEnable;
+
+		++offset;
+
+		do
+		{
+			if (!readNumber(inputBuffer, offset, dnsEnable) || dnsEnable > 1)
+				break;
+
+			// enable = 0 ... no dns data, enable = 1 ... one or two ip addresses
+			if ((dnsEnable == 0 && inputBufferCnt != offset + 2) ||
+				(dnsEnable == 1 && inputBuffer[offset] != ','))
+				break;
+
+			if (dnsEnable == 1)
+			{
+				++offset;
+
+				if (!readIpAddress(inputBuffer, offset, cfg.dns1))
+					break;
+
+				if (cfg.dns1 == 0)
+				{
+					SerialTx.println(F("IP1 invalid"));
+					break;
+				}
+
+				if (inputBufferCnt != offset + 2)
+				{
+					if (inputBuffer[offset] != ',')
+						break;
+
+					++offset;
+
+					if (!readIpAddress(inputBuffer, offset, cfg.dns2) || inputBufferCnt != offset + 2)
+						break;
+
+					if (cfg.dns2 == 0)
+					{
+						SerialTx.println(F("IP2 invalid"));
+						break;
+					}
+				}
+			}
+
+			// We got the dns configuration
+
+			if (cmd != CMD_AT_CIPDNS_CUR)
+			{
+				Settings::setDnsConfig(cfg);
+			}
+
+			gsCipDnsCfg = cfg;
+
+			setDns();
+
+			// The cached addresses may come from the previous servers
+			dnsCacheFlush();
+
+			error = 0;
+
+		} while (0);
+
+		if (error == 0)
+			SerialTx.printf_P(MSG_OK);
+		else if (error == 1)
+			SerialTx.printf_P(MSG_ERROR);
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+CIPDNSCACHE - Query, flush or configure the DNS cache
+ *                  AT+CIPDNSCACHE? lists the cache lifetime and the cached hosts
+ *                  AT+CIPDNSCACHE=<lifetime> sets the lifetime in seconds, 0 disables the cache
+ *                  AT+CIPDNSCACHE=FLUSH empties the cache
+ */
+void cmd_AT_CIPDNSCACHE()
+{
+	uint16_t offset = 14;
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		SerialTx.printf_P(PSTR("+CIPDNSCACHE:%d\r\n"), gsDnsCacheTtl);
+
+		for (uint8_t i = 0; i < DNS_CACHE_SIZE; ++i)
+		{
+			const dnsCacheEntry_t *entry = dnsCacheEntry(i);
+
+			if (entry != nullptr)
+				SerialTx.printf_P(PSTR("+CIPDNSCACHE:\"%s\",\"%s\",%d\r\n"), entry->hostname,
+								IPAddress(entry->ip).toString().c_str(), dnsCacheTimeLeft(entry));
+		}
+
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (!memcmp_P(&(inputBuffer[offset]), PSTR("=FLUSH"), 6) && inputBufferCnt == offset + 8)
+	{
+		dnsCacheFlush();
+
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
+	{
+		uint32_t ttl;
+
+		++offset;
+
+		if (readNumber(inputBuffer, offset, ttl) && ttl <= 86400 && inputBufferCnt == offset + 2)
+		{
+			gsDnsCacheTtl = ttl;
+
+			if (ttl == 0)
+				dnsCacheFlush();
+
+			SerialTx.printf_P(MSG_OK);
+		}
+		else
+		{
+			SerialTx.printf_P(MSG_ERROR);
+		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+SYSCPUFREQ - Set or Get the Current CPU Frequency, 0 = the automatic mode
+ */
+void cmd_AT_SYSCPUFREQ()
+{
+	uint8_t error = 1;
+
+	if (inputBuffer[13] == '?' && inputBufferCnt == 16)
+	{
+		uint8_t freq = system_get_cpu_freq();
+		uint32_t ms80, ms160;
+
+		cpuFreqGetTimes(ms80, ms160);
+
+		SerialTx.printf("+SYSCPUFREQ:%d\r\n", freq);
+		SerialTx.printf_P(PSTR("+SYSCPUFREQ:%d,%d,%u,%u\r\n"), cpuFreqGetMode(), cpuFreqGetIdleTime(), ms80, ms160);
+		error = 0;
+	}
+
+	else if (inputBuffer[13] == '=')
+	{
+		uint16_t offset = 14;
+		uint32_t freq;
+		uint32_t idleTime = cpuFreqGetIdleTime();
+
+		if (readNumber(inputBuffer, offset, freq) && (freq == CPU_FREQ_AUTO || freq == 80 || freq == 160))
+		{
+			// Optional idle time of the auto mode
+			if (freq == CPU_FREQ_AUTO && inputBuffer[offset] == ',')
+			{
+				++offset;
+
+				if (!readNumber(inputBuffer, offset, idleTime) || idleTime < 1 || idleTime > CPU_FREQ_IDLE_MAX)
+					offset = 0; // Error
+			}
+
+			if (offset != 0 && inputBufferCnt == offset + 2 && cpuFreqSetMode(freq, idleTime))
+				error = 0; // Success
+		}
+	}
+
+	if (error == 0)
+	{
+		SerialTx.printf_P(MSG_OK);
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+CWFASTJOIN - Fast rejoin to the cached access point (custom command), saved in flash
+ *   AT+CWFASTJOIN=<mode>: 0 = off (the cache is cleared), 1 = cached BSSID and channel, 2 = the DHCP lease as well
+ */
+void cmd_AT_CWFASTJOIN()
+{
+	uint16_t offset = strlen("AT+CWFASTJOIN");
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		joinCache_t cache = Settings::getJoinCache();
+
+		// +CWFASTJOIN:<mode>,<bssid>,<channel>,<ip>
+		SerialTx.printf_P(PSTR("+CWFASTJOIN:%d,\"%02x:%02x:%02x:%02x:%02x:%02x\",%d,\"%s\"\r\n"), Settings::getFastJoinMode(),
+						cache.bssid[0], cache.bssid[1], cache.bssid[2], cache.bssid[3], cache.bssid[4], cache.bssid[5],
+						cache.channel, IPAddress(cache.lease.ip).toString().c_str());
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
+	{
+		uint32_t mode;
+
+		++offset;
+
+		if (readNumber(inputBuffer, offset, mode) && mode <= FAST_JOIN_LEASE && inputBufferCnt == offset + 2)
+		{
+			Settings::setFastJoinMode(mode);
+
+			if (mode == FAST_JOIN_OFF)
+			{
+				joinCache_t cache;
+				memset(&cache, 0, sizeof(cache));
+				Settings::setJoinCache(cache);
+			}
+
+			SerialTx.printf_P(MSG_OK);
+		}
+		else
+		{
+			SerialTx.printf_P(MSG_ERROR);
+		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
 }
 
 /*
- * AT+CIPDNS - Sets User-defined DNS Servers
+ * AT+CWLAPCACHE - Maximum age of the cached AT+CWLAP result (custom command)
+ *   AT+CWLAPCACHE=<max age>: 0 - SCAN_CACHE_MAX_AGE [s], 0 = every AT+CWLAP scans, the cache is cleared
  */
-void cmd_AT_CIPDNS(commands_t cmd)
+void cmd_AT_CWLAPCACHE()
 {
-	uint16_t offset = 9;
-
-	if (cmd != CMD_AT_CIPDNS)
-		offset += 4;
+	uint16_t offset = strlen("AT+CWLAPCACHE");
 
 	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
 	{
-		dnsConfig_t cfg;
+		bool valid = scanCacheValid(gsScanCacheAge);
 
-		if (cmd == CMD_AT_CIPDNS_DEF)
+		// +CWLAPCACHE:<max age>,<entries>,<age>
+		SerialTx.printf_P(PSTR("+CWLAPCACHE:%u,%d,%d\r\n"), gsScanCacheAge, valid ? scanCacheCount() : 0,
+						valid ? scanCacheAge() : -1);
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
+	{
+		uint32_t maxAge;
+
+		++offset;
+
+		if (readNumber(inputBuffer, offset, maxAge) && maxAge <= SCAN_CACHE_MAX_AGE && inputBufferCnt == offset + 2)
 		{
-			cfg = Settings::getDnsConfig();
+			gsScanCacheAge = maxAge;
+
+			if (maxAge == 0)
+				scanCacheFlush();
+
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			cfg = {WiFi.dnsIP(0), WiFi.dnsIP(1)};
+			SerialTx.printf_P(MSG_ERROR);
 		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
 
-		const char *cmdSuffix = "";
-		if (cmd == CMD_AT_CIPDNS_CUR)
-			cmdSuffix = suffix_CUR;
-		else if (cmd == CMD_AT_CIPDNS_DEF)
-			cmdSuffix = suffix_DEF;
-
-		if (cfg.dns1 != 0)
-		{
-			Serial.printf_P(PSTR("+CIPDNS%s:%s\r\n"), cmdSuffix, IPAddress(cfg.dns1).toString().c_str());
+/*
+ * AT+UARTBUF - Sets the size of the UART receive buffer, saved in flash
+ */
+void cmd_AT_UARTBUF()
+{
+	uint16_t offset = 10;
 
-			if (cfg.dns2 != 0 && cfg.dns1 != cfg.dns2)
-			{
-				Serial.printf_P(PSTR("+CIPDNS%s:%s\r\n"), cmdSuffix, IPAddress(cfg.dns2).toString().c_str());
-			}
-		}
-		Serial.printf_P(MSG_OK);
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		SerialTx.printf_P(PSTR("+UARTBUF:%d\r\nOK\r\n"), Settings::getUartRxBufferSize());
 	}
 	else if (inputBuffer[offset] == '=')
 	{
-		uint8_t error = 1;
-
-		dnsConfig_t cfg = {0, 0};
-		uint32_t dnsEnable;
+		uint32_t size;
 
 		++offset;
 
-		do
+		if (readNumber(inputBuffer, offset, size) && size >= UART_RX_BUFFER_MIN && size <= UART_RX_BUFFER_MAX
+			&& inputBufferCnt == offset + 2 && Serial.setRxBufferSize(size) == size)
 		{
-			if (!readNumber(inputBuffer, offset, dnsEnable) || dnsEnable > 1)
-				break;
-
-			// enable = 0 ... no dns data, enable = 1 ... one or two ip addresses
-			if ((dnsEnable == 0 && inputBufferCnt != offset + 2) ||
-				(dnsEnable == 1 && inputBuffer[offset] != ','))
-				break;
-
-			if (dnsEnable == 1)
-			{
-				++offset;
+			Settings::setUartRxBufferSize(size);
 
-				if (!readIpAddress(inputBuffer, offset, cfg.dns1))
-					break;
+			SerialTx.printf_P(MSG_OK);
+		}
+		else
+		{
+			SerialTx.printf_P(MSG_ERROR);
+		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
 
-				if (cfg.dns1 == 0)
-				{
-					Serial.println(F("IP1 invalid"));
-					break;
-				}
+/*
+ * AT+SYSSAVE - Writes the changed settings to flash now, without waiting for the quiet period
+ */
+void cmd_AT_SYSSAVE()
+{
+	Settings::save();
 
-				if (inputBufferCnt != offset + 2)
-				{
-					if (inputBuffer[offset] != ',')
-						break;
+	SerialTx.printf_P(MSG_OK);
+}
 
-					++offset;
+/*
+ * AT+SYSHEAP? - Heap state, the memory used by the links and needed by the next TLS connection
+ */
+void cmd_AT_SYSHEAP()
+{
+	uint32_t freeHeap;
+	uint32_t maxBlock;
+	uint8_t fragmentation;
 
-					if (!readIpAddress(inputBuffer, offset, cfg.dns2) || inputBufferCnt != offset + 2)
-						break;
+	ESP.getHeapStats(&freeHeap, &maxBlock, &fragmentation);
 
-					if (cfg.dns2 == 0)
-					{
-						Serial.println(F("IP2 invalid"));
-						break;
-					}
-				}
-			}
+	if (freeHeap < gsHeapLowWatermark)
+		gsHeapLowWatermark = freeHeap;
 
-			// We got the dns configuration
+	SerialTx.printf_P(PSTR("+SYSHEAP:%d,%d,%d,%d\r\n"), freeHeap, maxBlock, fragmentation, gsHeapLowWatermark);
 
-			if (cmd != CMD_AT_CIPDNS_CUR)
-			{
-				Settings::setDnsConfig(cfg);
-			}
+	// The next AT+CIPSTART="SSL": the receive buffer is the largest block, the auto size (0) may need the full one
+	uint32_t sslIn = (gsCipSslSize == 0 ? 16384 : gsCipSslSize) + SSL_IN_OVERHEAD;
+	uint32_t sslTotal = sslIn + 512 + SSL_OUT_OVERHEAD + sizeof(br_ssl_client_context) + sizeof(br_x509_minimal_context);
 
-			gsCipDnsCfg = cfg;
+	SerialTx.printf_P(PSTR("+SYSHEAP:SSL,%d,%d,%d\r\n"), sslIn, sslTotal, maxBlock >= sslIn && freeHeap >= sslTotal);
 
-			setDns();
+	for (uint8_t i = 0; i < MAX_LINKS; ++i)
+	{
+		WiFiClient *cli = clients[i].client;
 
-			error = 0;
+		if (cli == nullptr)
+			continue;
 
-		} while (0);
+		uint16_t queued = 0;
+		if (clients[i].sendQueue != nullptr)
+			queued = SEND_QUEUE_SIZE - sendQueueFree(clients[i].sendQueue);
 
-		if (error == 0)
-			Serial.printf_P(MSG_OK);
-		else if (error == 1)
-			Serial.printf_P(MSG_ERROR);
-	}
-	else
-	{
-		Serial.printf_P(MSG_ERROR);
+		const char types_text[3][4] = {"TCP", "UDP", "SSL"};
+		SerialTx.printf_P(PSTR("+SYSHEAP,%d:\"%s\",%d,%d,%d\r\n"), i, types_text[clients[i].type], clients[i].sslBufferSize,
+						cli->available(), queued);
 	}
+
+	SerialTx.printf_P(MSG_OK);
 }
 
 /*
- * AT+SYSCPUFREQ - Set or Get the Current CPU Frequency
+ * AT+SYSPERF - Prints the performance histograms and counters (AT+SYSPERF?) or resets them (AT+SYSPERF=0)
  */
-void cmd_AT_SYSCPUFREQ()
+void cmd_AT_SYSPERF()
 {
-	uint8_t error = 1;
-
-	if (inputBuffer[13] == '?' && inputBufferCnt == 16)
-	{
-		uint8_t freq = system_get_cpu_freq();
-
-		Serial.printf("+SYSCPUFREQ:%d\r\n", freq);
-		error = 0;
-	}
+#if defined(AT_PERF)
+	uint16_t offset = strlen("AT+SYSPERF");
 
-	else if (inputBuffer[13] == '=')
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
 	{
-		uint16_t offset = 14;
-		uint32_t freq;
-
-		if (readNumber(inputBuffer, offset, freq) && (freq == 80 || freq == 160))
-		{
-			if (system_update_cpu_freq(freq) != 0)
-				error = 0; // Success
-		}
+		perfPrint();
+		SerialTx.printf_P(MSG_OK);
 	}
-
-	if (error == 0)
+	else if (inputBuffer[offset] == '=' && inputBuffer[offset + 1] == '0' && inputBufferCnt == offset + 4)
 	{
-		Serial.printf_P(MSG_OK);
+		perfReset();
+		SerialTx.printf_P(MSG_OK);
 	}
 	else
+#endif
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3024,7 +4414,7 @@ void cmd_AT_RFMODE()
 {
 	if (inputBuffer[9] == '?' && inputBufferCnt == 12)
 	{
-		Serial.printf_P(PSTR("+RFMODE:%d\r\nOK\r\n"), wifi_get_phy_mode());
+		SerialTx.printf_P(PSTR("+RFMODE:%d\r\nOK\r\n"), wifi_get_phy_mode());
 	}
 	else if (inputBuffer[9] == '=')
 	{
@@ -3036,16 +4426,16 @@ void cmd_AT_RFMODE()
 			phy_mode_t phymode = phy_mode_t(mode);
 			wifi_set_phy_mode(phymode);
 
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3061,7 +4451,7 @@ void cmd_AT_CIPSSLAUTH()
 
 	if (inputBuffer[13] == '?' && inputBufferCnt == 16)
 	{
-		Serial.printf_P(PSTR("+CIPSSLAUTH:%d\r\n"), gsCipSslAuth);
+		SerialTx.printf_P(PSTR("+CIPSSLAUTH:%d\r\n"), gsCipSslAuth);
 		error = false;
 	}
 	else if (inputBuffer[13] == '=')
@@ -3073,11 +4463,11 @@ void cmd_AT_CIPSSLAUTH()
 		{
 			if (sslAuth == 1 && !fingerprintValid)
 			{
-				Serial.println(F("fp not valid"));
+				SerialTx.println(F("fp not valid"));
 			}
-			else if (sslAuth == 2 && CAcert->getCount() == 0)
+			else if (sslAuth == 2 && CAcert->getCount() == 0 && certStoreCount == 0)
 			{
-				Serial.println(F("CA cert not loaded"));
+				SerialTx.println(F("CA cert not loaded"));
 			}
 			else
 			{
@@ -3090,11 +4480,11 @@ void cmd_AT_CIPSSLAUTH()
 
 	if (!error)
 	{
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3109,22 +4499,22 @@ void cmd_AT_CIPSSLFP()
 	{
 		if (fingerprintValid)
 		{
-			Serial.print(F("+CIPSSLFP:\""));
+			SerialTx.print(F("+CIPSSLFP:\""));
 
 			for (int i = 0; i < 20; ++i)
 			{
 				if (i > 0)
-					Serial.print(':');
+					SerialTx.print(':');
 
-				Serial.printf("%02x", fingerprint[i]);
+				SerialTx.printf("%02x", fingerprint[i]);
 			}
 
-			Serial.println(F("\"\r\n\r\nOK"));
+			SerialTx.println(F("\"\r\n\r\nOK"));
 		}
 		else
 		{
-			Serial.println("not valid");
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.println("not valid");
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else if (inputBuffer[11] == '=' && inputBuffer[12] == '"' && (inputBufferCnt == 56 || inputBufferCnt == 75)) // count = 16 + 2*20 (+ 19)
@@ -3150,16 +4540,16 @@ void cmd_AT_CIPSSLFP()
 			memcpy(fingerprint, fp, sizeof(fingerprint));
 			fingerprintValid = true;
 
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3170,7 +4560,7 @@ void cmd_AT_CIPSSLCERTMAX()
 {
 	if (inputBuffer[16] == '?' && inputBufferCnt == 19)
 	{
-		Serial.printf_P(PSTR("+CIPSSLCERTMAX:%d\r\nOK\r\n"), maximumCertificates);
+		SerialTx.printf_P(PSTR("+CIPSSLCERTMAX:%d\r\nOK\r\n"), maximumCertificates);
 	}
 	else if (inputBuffer[16] == '=')
 	{
@@ -3182,16 +4572,16 @@ void cmd_AT_CIPSSLCERTMAX()
 			maximumCertificates = max;
 			Settings::setMaximumCertificates(maximumCertificates);
 
-			Serial.printf_P(MSG_OK);
+			SerialTx.printf_P(MSG_OK);
 		}
 		else
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 		}
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3207,44 +4597,58 @@ void cmd_AT_CIPSSLCERT()
 	{
 		if (CAcert->getCount() >= maximumCertificates)
 		{
-			Serial.printf_P(PSTR("Reached the maximum of %d certificates\r\n"), maximumCertificates);
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(PSTR("Reached the maximum of %d certificates\r\n"), maximumCertificates);
+			SerialTx.printf_P(MSG_ERROR);
 			return;
 		}
 
-		PemCertificate = new char[MAX_PEM_CERT_LENGTH];
-		PemCertificatePos = 0;
+		// The DER buffer is allocated when the certificate length is known
+		pemDecoderInit(&pemDecoder, MAX_DER_CERT_LENGTH);
 		PemCertificateCount = 0;
 
-		if (PemCertificate != nullptr)
-		{
-			gsCertLoading = true;
+		gsCertLoading = true;
 
-			Serial.printf_P(MSG_OK);
-			Serial.print('>');
-		}
-		else // OOM
-		{
-			Serial.printf_P(MSG_ERROR);
-		}
+		SerialTx.printf_P(MSG_OK);
+		SerialTx.print('>');
 	}
 	// Print all certificates
 	else if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
 	{
 		if (CAcert->getCount() == 0)
 		{
-			Serial.println(F("+CIPSSLCERT:no certs loaded"));
+			SerialTx.println(F("+CIPSSLCERT:no certs loaded"));
 		}
 		else
 		{
 			for (size_t i = 0; i < CAcert->getCount(); i++)
 			{
-				Serial.printf_P(PSTR("+CIPSSLCERT,%d:"), i + 1);
+				SerialTx.printf_P(PSTR("+CIPSSLCERT,%d:"), i + 1);
 				printCertificateName(i);
 			}
 		}
 
-		Serial.printf_P(MSG_OK);
+		if (certStoreCount > 0)
+		{
+			SerialTx.printf_P(PSTR("+CIPSSLCERT:store,%d\r\n"), certStoreCount);
+		}
+
+		SerialTx.printf_P(MSG_OK);
+	}
+	// Print all certificates with the fingerprints
+	else if (!memcmp_P(&(inputBuffer[offset]), PSTR("?FP"), 3) && inputBufferCnt == offset + 5)
+	{
+		for (size_t i = 0; i < CAcert->getCount(); i++)
+		{
+			SerialTx.printf_P(PSTR("+CIPSSLCERT,%d:"), i + 1);
+
+			for (uint8_t j = 0; j < sizeof(certIndex[i].sha256); ++j)
+				SerialTx.printf_P(PSTR("%02x"), certIndex[i].sha256[j]);
+
+			SerialTx.print(',');
+			printCertificateName(i);
+		}
+
+		SerialTx.printf_P(MSG_OK);
 	}
 	// Print specific certificate
 	else if (inputBuffer[offset] == '?' && inputBufferCnt >= 16 && inputBufferCnt <= 18)
@@ -3254,30 +4658,30 @@ void cmd_AT_CIPSSLCERT()
 		++offset;
 		if (!readNumber(inputBuffer, offset, certNumber) || certNumber == 0)
 		{
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(MSG_ERROR);
 			return;
 		}
 
 		if (certNumber > CAcert->getCount())
 		{
-			Serial.printf_P(PSTR("+CIPSSLCERT,%d:no certificate\r\n"), certNumber);
-			Serial.printf_P(MSG_ERROR);
+			SerialTx.printf_P(PSTR("+CIPSSLCERT,%d:no certificate\r\n"), certNumber);
+			SerialTx.printf_P(MSG_ERROR);
 			return;
 		}
 		else
 		{
-			Serial.printf_P(PSTR("+CIPSSLCERT,%d:"), certNumber);
+			SerialTx.printf_P(PSTR("+CIPSSLCERT,%d:"), certNumber);
 			printCertificateName(certNumber - 1);
 		}
 
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	}
 	// Delete specific certificate
 	else if (!memcmp_P(&(inputBuffer[offset]), PSTR("=DELETE,"), 8) && (inputBufferCnt >= 22 && inputBufferCnt <= 25))
 	{
 		if (CAcert->getCount() == 0)
 		{
-			Serial.println(F("+CIPSSLCERT:no certificates"));
+			SerialTx.println(F("+CIPSSLCERT:no certificates"));
 		}
 		else
 		{
@@ -3286,44 +4690,24 @@ void cmd_AT_CIPSSLCERT()
 
 			if (readNumber(inputBuffer, offset, certNumberToDelete) && certNumberToDelete <= CAcert->getCount() && certNumberToDelete != 0)
 			{
-				BearSSL::X509List *certList = new BearSSL::X509List();
-
 				// Delete certificate
-				for (size_t i = 0; i < CAcert->getCount(); i++)
-				{
-					if (certNumberToDelete != (i + 1))
-					{
-						const br_x509_certificate *cert = &(CAcert->getX509Certs()[i]);
-						certList->append(cert->data, cert->data_len);
-					}
-				}
-
-				delete CAcert;
-				CAcert = certList;
+				deleteCertificate(certNumberToDelete - 1);
 
-/*				CAcert = BearSSL::X509List();
-
-				for (size_t i = 0; i < certList.getCount(); i++)
-				{
-					const br_x509_certificate *cert = &(certList.getX509Certs()[i]);
-					CAcert.append(cert->data, cert->data_len);
-				}
-*/
-				Serial.printf_P(PSTR("+CIPSSLCERT,%d:deleted\r\n"), certNumberToDelete);
-				Serial.printf_P(MSG_OK);
+				SerialTx.printf_P(PSTR("+CIPSSLCERT,%d:deleted\r\n"), certNumberToDelete);
+				SerialTx.printf_P(MSG_OK);
 				return;
 			}
 			else if (certNumberToDelete > CAcert->getCount())
 			{
-				Serial.println(F("+CIPSSLCERT=DELETE:no certificate"));
+				SerialTx.println(F("+CIPSSLCERT=DELETE:no certificate"));
 			}
 		}
 
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 	else
 	{
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3331,6 +4715,7 @@ void cmd_AT_CIPSSLCERT()
  * AT+CIPSSLMFLN - Check the capability of MFLN for a site
  * Format: AT+CIPSSLMFLN=site,port,length
  * Example: AT+CIPSSLMFLN="tls.mbed.org",443,512
+ *          AT+CIPSSLMFLN=FLUSH empties the cache of the results
  */
 void cmd_AT_CIPSSLMFLN()
 {
@@ -3339,6 +4724,14 @@ void cmd_AT_CIPSSLMFLN()
 	uint32_t remotePort;
 	uint32_t maxLen;
 
+	if (!memcmp_P(&(inputBuffer[13]), PSTR("=FLUSH"), 6) && inputBufferCnt == 21)
+	{
+		mflnCacheFlush();
+
+		SerialTx.printf_P(MSG_OK);
+		return;
+	}
+
 	do
 	{
 		if (inputBuffer[13] != '=' || inputBuffer[14] != '"')
@@ -3391,27 +4784,39 @@ void cmd_AT_CIPSSLMFLN()
 			break;
 		}
 
+		IPAddress remoteIP;
+		if (!dnsCacheResolve(remoteSite, remoteIP, 5000))
+		{
+			error = 8;
+			break;
+		}
+
 		error = 0;
 
 		// Read the MFLN status
-		bool mfln = BearSSL::WiFiClientSecure::probeMaxFragmentLength(remoteSite, remotePort, maxLen);
+		bool mfln = BearSSL::WiFiClientSecure::probeMaxFragmentLength(remoteIP, remotePort, maxLen);
 
-		Serial.printf_P(PSTR("+CIPSSLMFLN:%s\r\n"), mfln ? "TRUE" : "FALSE");
+		// Remember the result, AT+CIPSSLSIZE=0 uses the result for SSL_MFLN_AUTO_SIZE
+		mflnCacheAdd(remoteSite, remotePort, maxLen, mfln);
+
+		SerialTx.printf_P(PSTR("+CIPSSLMFLN:%s\r\n"), mfln ? "TRUE" : "FALSE");
 
 	} while (0);
 
 	if (error == 0)
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	else
 	{
 		if (error == 4)
-			Serial.println(F("HOSTNAME ERROR\r\n"));
+			SerialTx.println(F("HOSTNAME ERROR\r\n"));
 		else if (error == 6)
-			Serial.println(F("NO AP"));
+			SerialTx.println(F("NO AP"));
 		else if (error == 7)
-			Serial.println(F("SIZE ERROR\r\n"));
+			SerialTx.println(F("SIZE ERROR\r\n"));
+		else if (error == 8)
+			SerialTx.println(F("DNS Fail"));
 
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3439,12 +4844,12 @@ void cmd_AT_CIPSSLSTA()
 
 		if (inputBuffer[12] == '=')
 		{
-			if (!readNumber(inputBuffer, offset, linkId) || linkId > 4 || inputBufferCnt != offset + 2)
+			if (!readNumber(inputBuffer, offset, linkId) || linkId >= MAX_LINKS || inputBufferCnt != offset + 2)
 				break;
 
 			if (gsCipMux == 0)
 			{
-				Serial.println(F("MUX=0"));
+				SerialTx.println(F("MUX=0"));
 				break;
 			}
 		}
@@ -3452,7 +4857,7 @@ void cmd_AT_CIPSSLSTA()
 			break;
 		else if (gsCipMux != 0)
 		{
-			Serial.println(F("MUX=1"));
+			SerialTx.println(F("MUX=1"));
 			break;
 		}
 
@@ -3477,22 +4882,74 @@ void cmd_AT_CIPSSLSTA()
 
 		bool mfln = static_cast<WiFiClientSecure *>(cli)->getMFLNStatus();
 
-		Serial.printf_P(PSTR("+CIPSSLSTA:%d\r\n"), mfln);
+		SerialTx.printf_P(PSTR("+CIPSSLSTA:%d,%d\r\n"), mfln, clients[linkId].sslResumed);
 
 	} while (0);
 
 	if (error == 0)
-		Serial.printf_P(MSG_OK);
+		SerialTx.printf_P(MSG_OK);
 	else
 	{
 		if (error == 2)
-			Serial.println(F("NOT CONNECTED"));
+			SerialTx.println(F("NOT CONNECTED"));
 		else if (error == 3)
-			Serial.println(F("NOT OPENED"));
+			SerialTx.println(F("NOT OPENED"));
 		else if (error == 4)
-			Serial.println(F("NOT A SSL"));
+			SerialTx.println(F("NOT A SSL"));
+
+		SerialTx.printf_P(MSG_ERROR);
+	}
+}
+
+/*
+ * AT+CIPSSLSESS - Configure, query or clear the TLS session cache
+ *                 AT+CIPSSLSESS? prints the cache size and the cached sessions
+ *                 AT+CIPSSLSESS=<size> sets the number of cached sessions, 0 disables the cache
+ *                 AT+CIPSSLSESS=FLUSH removes all sessions
+ */
+void cmd_AT_CIPSSLSESS()
+{
+	uint16_t offset = 13;
+
+	if (inputBuffer[offset] == '?' && inputBufferCnt == offset + 3)
+	{
+		SerialTx.printf_P(PSTR("+CIPSSLSESS:%d\r\n"), sslSessionCacheGetSize());
+
+		for (uint8_t i = 0; i < sslSessionCacheGetSize(); ++i)
+		{
+			const sslSessionCacheEntry_t *entry = sslSessionCacheEntry(i);
+
+			if (entry != nullptr)
+				SerialTx.printf_P(PSTR("+CIPSSLSESS:\"%s\",%d\r\n"), entry->host.c_str(), entry->port);
+		}
 
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (!memcmp_P(&(inputBuffer[offset]), PSTR("=FLUSH"), 6) && inputBufferCnt == offset + 8)
+	{
+		sslSessionCacheClear();
+
+		SerialTx.printf_P(MSG_OK);
+	}
+	else if (inputBuffer[offset] == '=')
+	{
+		uint32_t size;
+
+		++offset;
+
+		if (readNumber(inputBuffer, offset, size) && size <= SSL_SESSION_CACHE_MAX && inputBufferCnt == offset + 2
+			&& sslSessionCacheSetSize(size))
+		{
+			SerialTx.printf_P(MSG_OK);
+		}
+		else
+		{
+			SerialTx.printf_P(MSG_ERROR);
+		}
+	}
+	else
+	{
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3508,15 +4965,15 @@ void cmd_AT_SNTPTIME()
 
 		struct tm *info = localtime((const time_t *)&now);
 
-		Serial.printf_P(PSTR("+SNTPTIME:%ld,%04d-%02d-%02d %02d:%02d:%02d\r\n"),
+		SerialTx.printf_P(PSTR("+SNTPTIME:%ld,%04d-%02d-%02d %02d:%02d:%02d\r\n"),
 						now, info->tm_year + 1900, info->tm_mon + 1, info->tm_mday, info->tm_hour, info->tm_min, info->tm_sec);
 
-		Serial.println(F("OK"));
+		SerialTx.println(F("OK"));
 	}
 	else
 	{
-		Serial.println(F("+SNTPTIME:Enable SNTP first (AT+CIPSNTPCFG)"));
-		Serial.printf_P(MSG_ERROR);
+		SerialTx.println(F("+SNTPTIME:Enable SNTP first (AT+CIPSNTPCFG)"));
+		SerialTx.printf_P(MSG_ERROR);
 	}
 }
 
@@ -3533,49 +4990,51 @@ commands_t findCommand(uint8_t *input, uint16_t inpLen)
 	if (inpLen == 4)
 		return CMD_AT;
 
-	// Check the command list
-	for (unsigned int i = 0; i < sizeof(commandList) / sizeof(commandDef_t); ++i)
-	{
-		const char *cmd = commandList[i].text;
+	// Get the command name and look it up in the index
+	const char *name = (const char *)input + 2;
+	uint16_t nameLen = 0;
 
-		if (!memcmp(cmd, input + 2, strlen(cmd)))
-		{
-			// Potentionally, we have a command
+	while (isCommandNameChar(name[nameLen]))
+		++nameLen;
 
-			switch (commandList[i].mode)
-			{
-			case MODE_EXACT_MATCH:
-				if (inpLen == strlen(cmd) + 4) // Check exact length
-					return commandList[i].cmd;
-				break;
+	uint32_t hash = commandHash(name, nameLen);
 
-			case MODE_QUERY_SET:
-			{
-				char c = input[strlen(cmd) + 2];
-				if (c == '=' || c == '?')
-				{
-					if (c == '?' && inpLen != strlen(cmd) + 5) // Check exact length
-						return CMD_ERROR;
+	for (uint16_t h = hash & (COMMAND_INDEX_SIZE - 1); commandIndex.slot[h] != 0; h = (h + 1) & (COMMAND_INDEX_SIZE - 1))
+	{
+		const commandDef_t &def = commandList[commandIndex.slot[h] - 1];
 
-					return commandList[i].cmd;
-				}
-			}
+		if (def.hash != hash || def.nameLen != nameLen || memcmp(def.text, name, def.len))
+			continue;
+
+		// The command name is unique, check the rest of the input according to the mode
+		char c = input[def.len + 2];
+
+		switch (def.mode)
+		{
+		case MODE_EXACT_MATCH:
+			if (inpLen == def.len + 4) // Check exact length
+				return def.cmd;
 			break;
 
-			case MODE_NO_CHECKING:
+		case MODE_QUERY_SET:
+			if (c == '=' || c == '?')
 			{
-				// The input must not continue with an alphabetic character
-				char c = input[strlen(cmd) + 2];
+				if (c == '?' && inpLen != def.len + 5) // Check exact length
+					return CMD_ERROR;
 
-				if (!isAlpha(c))
-					return commandList[i].cmd;
+				return def.cmd;
 			}
 			break;
 
-			default:
-				return CMD_ERROR; // should not be reached
-			}
+		case MODE_NO_CHECKING:
+			// The name ends with a non-alphabetic character
+			return def.cmd;
+
+		default:
+			break; // should not be reached
 		}
+
+		return CMD_ERROR;
 	}
 
 	return CMD_ERROR;
@@ -3644,6 +5103,24 @@ bool readNumber(unsigned char *inpBuf, uint16_t &offset, uint32_t &output)
 	return ret;
 }
 
+/*
+ * Reads the link ID followed by a comma, moves the offset behind the comma
+ * Returns false and keeps the offset if there is no valid link ID, i.e. the number is the next parameter
+ */
+bool readLinkId(unsigned char *inpBuf, uint16_t &offset, uint8_t &linkId)
+{
+	uint16_t pos = offset;
+	uint32_t id;
+
+	if (!readNumber(inpBuf, pos, id) || id >= MAX_LINKS || inpBuf[pos] != ',')
+		return false;
+
+	linkId = id;
+	offset = pos + 1;
+
+	return true;
+}
+
 /*
  * Reads a IPv4 address from buffer, returns a 32 bit integer
  * The address is enclosed in double quotes
@@ -3687,6 +5164,17 @@ bool readIpAddress(unsigned char *inpBuf, uint16_t &offset, uint32_t &output)
 	return ret;
 }
 
+/*
+ * Prints the TCP options of a link (AT+CIPTCPOPT, AT+CIPSTATUS)
+ */
+void printLinkOptions(uint8_t linkId)
+{
+	const linkOptions_t *opt = &linkOptions[linkId];
+
+	SerialTx.printf_P(PSTR("+CIPTCPOPT:%d,%d,%d,%d,%d,%d,%d\r\n"), linkId, opt->noDelay, opt->sync, opt->writeTimeout,
+					opt->keepAliveIdle, opt->keepAliveInterval, opt->keepAliveCount);
+}
+
 /*
  * Translates ASCII to 1 nibble hex
  */
@@ -3708,30 +5196,17 @@ uint8_t readHex(char c)
 void printCertificateName(uint8_t number)
 {
 	const br_x509_certificate *cert = &(CAcert->getX509Certs()[number]);
+	uint16_t cnOffset = certIndex[number].cnOffset;
 
-	uint8_t *cnBytes = getCnFromDer(cert->data, cert->data_len);
-
-	if (cnBytes != nullptr)
+	if (cnOffset != 0)
 	{
-		char *cn = new char[cnBytes[0] + 1];
-
-		if (cn != nullptr)
-		{
-			memcpy(cn, &(cnBytes[1]), cnBytes[0]);
-			cn[cnBytes[0]] = '\0';
-
-			Serial.println(cn);
-
-			delete cn;
-		}
-		else
-		{
-			Serial.println(F("cert ok"));
-		}
+		// The CN was found when the certificate was loaded
+		SerialTx.write(cert->data + cnOffset + 1, cert->data[cnOffset]);
+		SerialTx.println();
 	}
 	else
 	{
-		Serial.println(F("cert ok"));
+		SerialTx.println(F("cert ok"));
 	}
 }
 
@@ -3740,11 +5215,11 @@ void printCertificateName(uint8_t number)
  */
 int compWifiRssi(const void *elem1, const void *elem2)
 {
-	int f = *((int *)elem1);
-	int s = *((int *)elem2);
-	if (WiFi.RSSI(f) > WiFi.RSSI(s)) // @suppress("Invalid arguments")
+	int f = scanCacheEntry(*((int *)elem1))->rssi;
+	int s = scanCacheEntry(*((int *)elem2))->rssi;
+	if (f > s)
 		return -1;
-	if (WiFi.RSSI(f) < WiFi.RSSI(s)) // @suppress("Invalid arguments")
+	if (f < s)
 		return 1;
 	return 0;
 }
@@ -3756,45 +5231,50 @@ void printCWLAP(int indices[], size_t size)
 {
 	for (size_t i = 0; i < size; i++)
 	{
+		const scanCacheEntry_t *entry = scanCacheEntry(indices[i]);
+
 		bool show = false;
-		if (authmodeMask & (1 << WiFi.encryptionType(indices[i])))
+		if (authmodeMask & (1 << entry->encryption))
 		{
 			show = true;
 		}
-		else if (WiFi.encryptionType(indices[i]) > 8)
+		else if (entry->encryption > 8)
 		{
 			show = true;
 		}
 
 		if (show)
 		{
-			if (WiFi.RSSI(indices[i]) > rssiFilter) // @suppress("Invalid arguments")
+			if (entry->rssi > rssiFilter)
 			{
 				String result = "+CWLAP:(";
 
 				if (printMask & (1 << 0))
 				{
-					result += WiFi.encryptionType(indices[i]);
+					result += entry->encryption;
 					result += ",";
 				}
 				if (printMask & (1 << 1))
 				{
-					result += WiFi.SSID(indices[i]); // @suppress("Invalid arguments")
+					result += entry->ssid;
 					result += ",";
 				}
 				if (printMask & (1 << 2))
 				{
-					result += WiFi.RSSI(indices[i]); // @suppress("Invalid arguments")
+					result += (int)entry->rssi;
 					result += ",";
 				}
 				if (printMask & (1 << 3))
 				{
-					result += WiFi.BSSIDstr(indices[i]).c_str(); // @suppress("Invalid arguments") // @suppress("Method cannot be resolved")
+					char bssid[18];
+					sprintf_P(bssid, PSTR("%02X:%02X:%02X:%02X:%02X:%02X"), entry->bssid[0], entry->bssid[1], entry->bssid[2],
+							  entry->bssid[3], entry->bssid[4], entry->bssid[5]);
+					result += bssid;
 					result += ",";
 				}
 				if (printMask & (1 << 4))
 				{
-					result += WiFi.channel(indices[i]); // @suppress("Invalid arguments")
+					result += entry->channel;
 					result += ",";
 				}
 				if (printMask & (1 << 5))
@@ -3837,43 +5317,80 @@ void printCWLAP(int indices[], size_t size)
 				// Remove trailing comma
 				result.remove(result.lastIndexOf(','));
 				result += ")";
-				Serial.printf("%s\n", result.c_str());
+				SerialTx.printf("%s\n", result.c_str());
 			}
 		}
 	}
 
-	gsFlag_Busy = false;
-	Serial.printf_P(MSG_OK);
+	SerialTx.printf_P(MSG_OK);
 }
 
 /*
- * Print the networks found from scanning
+ * Print the networks found from scanning, filtered by AT+CWLAP=<ssid>,<mac>,<channel>
  */
-void printScanResult(int networksFound)
+void printScanResult()
 {
-	if (sort_enable == 0)
-	{
-		int indices[networksFound];
-		for (int i = 0; i < networksFound; i++)
-		{
-			indices[i] = i;
-		}
+	int indices[SCAN_CACHE_MAX_ENTRIES];
+	size_t size = 0;
 
-		// Print the unsorted networks
-		printCWLAP(indices, sizeof(indices) / sizeof(indices[0]));
-	}
-	else if (sort_enable == 1)
+	for (uint8_t i = 0; i < scanCacheCount(); i++)
 	{
-		int indices[networksFound];
-		for (int i = 0; i < networksFound; i++)
+		const scanCacheEntry_t *entry = scanCacheEntry(i);
+
+		if ((cwlapSsid[0] == '\0' || !strcmp(entry->ssid, cwlapSsid))
+			&& (!cwlapBssidSet || !memcmp(entry->bssid, cwlapBssid, sizeof(cwlapBssid)))
+			&& (cwlapChannel == 0 || entry->channel == cwlapChannel))
 		{
-			indices[i] = i;
+			indices[size++] = i;
 		}
+	}
 
-		// Sort by RSSI
-		qsort(indices, sizeof(indices) / sizeof(indices[0]), sizeof(indices[0]), compWifiRssi);
+	// Sort by RSSI
+	if (sort_enable == 1)
+		qsort(indices, size, sizeof(indices[0]), compWifiRssi);
 
-		// Print the sorted networks
-		printCWLAP(indices, sizeof(indices) / sizeof(indices[0]));
+	printCWLAP(indices, size);
+}
+
+/*
+ * Prints the result of the background AT+CWLAP scan when finished, called from loop()
+ */
+void processScanResult()
+{
+	int networksFound = scanCacheProcess();
+
+	if (networksFound == WIFI_SCAN_RUNNING)
+		return;
+
+	if (networksFound == WIFI_SCAN_FAILED)
+		SerialTx.printf_P(MSG_ERROR);
+	else
+		printScanResult();
+}
+
+/*
+ * Returns true for the commands which must wait for the end of the AT+CWLAP scan
+ */
+static bool blockedByScan(commands_t cmd)
+{
+	switch (cmd)
+	{
+	case CMD_AT_RST:
+	case CMD_AT_RESTORE:
+	case CMD_AT_CWMODE:
+	case CMD_AT_CWMODE_CUR:
+	case CMD_AT_CWMODE_DEF:
+	case CMD_AT_CWJAP:
+	case CMD_AT_CWJAP_CUR:
+	case CMD_AT_CWJAP_DEF:
+	case CMD_AT_CWLAP:
+	case CMD_AT_CWQAP:
+	case CMD_AT_CWSAP:
+	case CMD_AT_CWSAP_CUR:
+	case CMD_AT_CWSAP_DEF:
+		return true;
+
+	default:
+		return false;
 	}
 }
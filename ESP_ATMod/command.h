@@ -74,12 +74,15 @@ enum commands_t
 	CMD_AT_CIPETH_CUR,
 	CMD_AT_CIPETH_DEF,
 	CMD_AT_CEHOSTNAME,
+	CMD_AT_CIPETHCFG,	  // New command
 	// TCP/IP AT Commands
 	CMD_AT_CIPSTATUS,
 	CMD_AT_CIPDOMAIN,
 	CMD_AT_CIPSTART,
 	CMD_AT_CIPSSLSIZE,
 	CMD_AT_CIPSEND,
+	CMD_AT_CIPSENDBUF,
+	CMD_AT_CIPBUFSTATUS,
 	CMD_AT_CIPCLOSEMODE,
 	CMD_AT_CIPCLOSE,
 	CMD_AT_CIFSR,
@@ -87,6 +90,7 @@ enum commands_t
 	CMD_AT_CIPSERVER,
 	CMD_AT_CIPSERVERMAXCONN,
 	CMD_AT_CIPSTO,
+	CMD_AT_CIPMODE,
 	CMD_AT_CIPDINFO,
 	CMD_AT_CIPRECVMODE, // v 1.7
 	CMD_AT_CIPRECVDATA, // v 1.7
@@ -96,15 +100,28 @@ enum commands_t
 	CMD_AT_CIPDNS,
 	CMD_AT_CIPDNS_CUR,
 	CMD_AT_CIPDNS_DEF,
+	CMD_AT_CIPDNSCACHE,
 	// New commands
 	CMD_AT_SYSCPUFREQ,	  // New command
+	CMD_AT_UARTBUF,		  // New command
+	CMD_AT_SYSSAVE,		  // New command
+	CMD_AT_SYSHEAP,		  // New command
+	CMD_AT_SYSPERF,		  // New command
 	CMD_AT_RFMODE,		  // New command
+	CMD_AT_CIPSERVERCFG,  // New command
+	CMD_AT_CIPRECVCOALESCE, // New command
+	CMD_AT_CIPTCPOPT,	  // New command
+	CMD_AT_CIPBINMODE,	  // New command
+	CMD_AT_CIPSENDMULTI,  // New command
+	CMD_AT_CWFASTJOIN,	  // New command
+	CMD_AT_CWLAPCACHE,	  // New command
 	CMD_AT_CIPSSLAUTH,	  // New command
 	CMD_AT_CIPSSLFP,	  // New command
 	CMD_AT_CIPSSLCERTMAX, // New command
 	CMD_AT_CIPSSLCERT,	  // New command
 	CMD_AT_CIPSSLMFLN,	  // New command
 	CMD_AT_CIPSSLSTA,	  // New command
+	CMD_AT_CIPSSLSESS,	  // New command
 	CMD_AT_SNTPTIME,	  // New command
 };
 
@@ -113,5 +130,6 @@ enum commands_t
  */
 
 void processCommandBuffer();
+void processScanResult();
 
 #endif /* COMMAND_H_ */
@@ -0,0 +1,161 @@
+/*
+ * cpuFreq.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "cpuFreq.h"
+#include "debug.h"
+
+/*
+ * Note: in the auto mode the CPU runs at 80 MHz and the work which takes long at 80 MHz
+ *       (TLS handshakes, TLS records, large +IPD deliveries) raises it to 160 MHz by
+ *       calling cpuFreqBoost(). cpuFreqProcess() called from loop() returns to 80 MHz
+ *       after the idle time without a boost. The UART clock does not depend on the CPU clock.
+ */
+
+/*
+ * Variables
+ */
+
+static uint8_t mode = F_CPU / 1000000L;			// CPU_FREQ_AUTO, 80 or 160
+static uint16_t idleTime = CPU_FREQ_IDLE_DEFAULT;	// [ms]
+static uint32_t lastBoostMillis = 0;				// The last cpuFreqBoost() in the auto mode
+static uint32_t lastChangeMillis = 0;				// The last time accounting
+static uint32_t timeAt[2] = {0, 0};					// Time [ms] at 80 and 160 MHz
+
+/*
+ * Static functions
+ */
+
+static void setFrequency(uint8_t freq);
+static void accountTime();
+
+/*
+ * Public functions
+ */
+
+/*
+ * Sets the fixed frequency (80 or 160) or the auto mode with the idle time [ms]
+ */
+bool cpuFreqSetMode(uint8_t newMode, uint16_t newIdleTime)
+{
+	if (newMode != CPU_FREQ_AUTO && newMode != 80 && newMode != 160)
+		return false;
+
+	mode = newMode;
+
+	if (mode == CPU_FREQ_AUTO)
+	{
+		idleTime = newIdleTime;
+		lastBoostMillis = millis();
+	}
+	else
+	{
+		setFrequency(mode);
+	}
+
+	return true;
+}
+
+/*
+ * Returns the mode: CPU_FREQ_AUTO, 80 or 160
+ */
+uint8_t cpuFreqGetMode()
+{
+	return mode;
+}
+
+/*
+ * Returns the idle time [ms] of the auto mode
+ */
+uint16_t cpuFreqGetIdleTime()
+{
+	return idleTime;
+}
+
+/*
+ * Raises the clock to 160 MHz in the auto mode
+ */
+void cpuFreqBoost()
+{
+	if (mode != CPU_FREQ_AUTO)
+		return;
+
+	lastBoostMillis = millis();
+
+	if (system_get_cpu_freq() != 160)
+	{
+		AT_DEBUG_PRINT("--- CPU 160 MHz\r\n");
+		setFrequency(160);
+	}
+}
+
+/*
+ * Returns to 80 MHz after the idle time in the auto mode, called from loop()
+ */
+void cpuFreqProcess()
+{
+	if (mode != CPU_FREQ_AUTO || system_get_cpu_freq() == 80)
+		return;
+
+	if (millis() - lastBoostMillis >= idleTime)
+	{
+		AT_DEBUG_PRINT("--- CPU 80 MHz\r\n");
+		setFrequency(80);
+	}
+}
+
+/*
+ * Returns the time [ms] spent at 80 and 160 MHz since the start
+ */
+void cpuFreqGetTimes(uint32_t &ms80, uint32_t &ms160)
+{
+	accountTime();
+
+	ms80 = timeAt[0];
+	ms160 = timeAt[1];
+}
+
+/*
+ * Static functions
+ */
+
+/*
+ * Changes the CPU clock, the time at the previous frequency is accounted first
+ */
+static void setFrequency(uint8_t freq)
+{
+	accountTime();
+
+	system_update_cpu_freq(freq);
+}
+
+/*
+ * Adds the time since the last accounting to the current frequency
+ */
+static void accountTime()
+{
+	uint32_t now = millis();
+
+	timeAt[system_get_cpu_freq() == 160 ? 1 : 0] += now - lastChangeMillis;
+	lastChangeMillis = now;
+}
@@ -0,0 +1,47 @@
+/*
+ * cpuFreq.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPUFREQ_H_
+#define CPUFREQ_H_
+
+#include "Arduino.h"
+
+/*
+ * Defines
+ */
+
+#define CPU_FREQ_AUTO 0				   // AT+SYSCPUFREQ=0, the governor switches between 80 and 160 MHz
+#define CPU_FREQ_IDLE_DEFAULT 2000	   // Default idle time [ms] before the governor returns to 80 MHz
+#define CPU_FREQ_IDLE_MAX 60000		   // Maximum idle time [ms]
+#define CPU_FREQ_BOOST_MIN_BYTES 1460 // Smallest +IPD delivery of a TCP link raising the clock
+
+/*
+ * Public functions
+ */
+
+bool cpuFreqSetMode(uint8_t mode, uint16_t idleTime);
+uint8_t cpuFreqGetMode();
+uint16_t cpuFreqGetIdleTime();
+void cpuFreqBoost();
+void cpuFreqProcess();
+void cpuFreqGetTimes(uint32_t &ms80, uint32_t &ms160);
+
+#endif /* CPUFREQ_H_ */
@@ -24,18 +24,24 @@
  * Debug flag
  */
 //#define AT_DEBUG
+//#define AT_DEBUG_UART1 // Debug output to UART1 (GPIO2, TX only) instead of the AT port
 
 #if defined(AT_DEBUG)
 
-#define AT_DEBUG_PRINTF(format, args...) \
-	do                                   \
-	{                                    \
-		char buf[200];                   \
-		sprintf(buf, format, args);      \
-		Serial.print(buf);               \
+#if defined(AT_DEBUG_UART1)
+#define AT_DEBUG_PORT Serial1
+#else
+#include "serialTx.h"
+#define AT_DEBUG_PORT SerialTx
+#endif
+
+#define AT_DEBUG_PRINTF(format, args...)    \
+	do                                      \
+	{                                       \
+		AT_DEBUG_PORT.printf(format, args); \
 	} while (0);
 
-#define AT_DEBUG_PRINT(string) Serial.print(string);
+#define AT_DEBUG_PRINT(string) AT_DEBUG_PORT.print(string);
 
 #else
 
@@ -0,0 +1,198 @@
+/*
+ * dnsCache.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "ESP_ATMod.h"
+#include "dnsCache.h"
+#include "debug.h"
+
+/*
+ * Note: lwIP does not pass the record TTL to the caller, so the entries
+ *       expire after a fixed lifetime set by AT+CIPDNSCACHE (gsDnsCacheTtl).
+ */
+
+/*
+ * Variables
+ */
+
+static dnsCacheEntry_t dnsCache[DNS_CACHE_SIZE];
+
+/*
+ * Static functions
+ */
+
+static dnsCacheEntry_t *findEntry(const char *hostname);
+static bool isValid(const dnsCacheEntry_t *entry);
+
+/*
+ * Public functions
+ */
+
+/*
+ * Looks up the hostname in the cache. Returns false if not found or expired.
+ */
+bool dnsCacheLookup(const char *hostname, uint32_t &ip)
+{
+	// An address needs no lookup, lwIP converts it directly
+	if (IPAddress::isValid(hostname))
+		return false;
+
+	dnsCacheEntry_t *entry = findEntry(hostname);
+
+	if (entry == nullptr)
+		return false;
+
+	if (!isValid(entry))
+	{
+		entry->hostname[0] = '\0';
+		return false;
+	}
+
+	ip = entry->ip;
+
+	AT_DEBUG_PRINTF("--- dns cache hit: %s\r\n", hostname);
+
+	return true;
+}
+
+/*
+ * Stores the resolved address. Replaces the same host, an unused or expired entry or the oldest one.
+ * IP address literals are not stored.
+ */
+void dnsCacheAdd(const char *hostname, uint32_t ip)
+{
+	if (gsDnsCacheTtl == 0 || ip == 0 || strlen(hostname) >= DNS_CACHE_HOST_LEN || IPAddress::isValid(hostname))
+		return;
+
+	dnsCacheEntry_t *entry = findEntry(hostname);
+
+	if (entry == nullptr)
+	{
+		entry = &dnsCache[0];
+
+		for (uint8_t i = 0; i < DNS_CACHE_SIZE; ++i)
+		{
+			if (!isValid(&dnsCache[i]))
+			{
+				entry = &dnsCache[i];
+				break;
+			}
+
+			if ((int32_t)(dnsCache[i].storedMillis - entry->storedMillis) < 0)
+				entry = &dnsCache[i];
+		}
+
+		strcpy(entry->hostname, hostname);
+	}
+
+	entry->ip = ip;
+	entry->storedMillis = millis();
+}
+
+/*
+ * Removes the host from the cache, e.g. when the cached address does not work
+ */
+void dnsCacheRemove(const char *hostname)
+{
+	dnsCacheEntry_t *entry = findEntry(hostname);
+
+	if (entry != nullptr)
+		entry->hostname[0] = '\0';
+}
+
+/*
+ * Removes all entries
+ */
+void dnsCacheFlush()
+{
+	for (uint8_t i = 0; i < DNS_CACHE_SIZE; ++i)
+		dnsCache[i].hostname[0] = '\0';
+}
+
+/*
+ * Returns the valid cache entry at the index or nullptr
+ */
+const dnsCacheEntry_t *dnsCacheEntry(uint8_t index)
+{
+	if (index >= DNS_CACHE_SIZE || !isValid(&dnsCache[index]))
+		return nullptr;
+
+	return &dnsCache[index];
+}
+
+/*
+ * Returns the remaining lifetime of the entry in seconds
+ */
+uint32_t dnsCacheTimeLeft(const dnsCacheEntry_t *entry)
+{
+	uint32_t age = (millis() - entry->storedMillis) / 1000;
+
+	return (age < gsDnsCacheTtl) ? gsDnsCacheTtl - age : 0;
+}
+
+/*
+ * Resolves the hostname using the cache first, then the DNS (blocking)
+ */
+bool dnsCacheResolve(const char *hostname, IPAddress &ip, uint32_t timeout)
+{
+	uint32_t cachedIp;
+
+	if (dnsCacheLookup(hostname, cachedIp))
+	{
+		ip = cachedIp;
+		return true;
+	}
+
+	if (!WiFi.hostByName(hostname, ip, timeout))
+		return false;
+
+	dnsCacheAdd(hostname, ip);
+
+	return true;
+}
+
+/*
+ * Static functions
+ */
+
+/*
+ * Returns the entry with the hostname (expired entries including) or nullptr
+ */
+static dnsCacheEntry_t *findEntry(const char *hostname)
+{
+	for (uint8_t i = 0; i < DNS_CACHE_SIZE; ++i)
+	{
+		if (dnsCache[i].hostname[0] != '\0' && !strcasecmp(dnsCache[i].hostname, hostname))
+			return &dnsCache[i];
+	}
+
+	return nullptr;
+}
+
+/*
+ * Checks the entry is used and not expired
+ */
+static bool isValid(const dnsCacheEntry_t *entry)
+{
+	return entry->hostname[0] != '\0' && millis() - entry->storedMillis < gsDnsCacheTtl * 1000;
+}
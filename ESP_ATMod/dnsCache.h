@@ -0,0 +1,57 @@
+/*
+ * dnsCache.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DNSCACHE_H_
+#define DNSCACHE_H_
+
+#include "Arduino.h"
+
+/*
+ * Defines
+ */
+
+#define DNS_CACHE_SIZE 4
+#define DNS_CACHE_HOST_LEN 64
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	char hostname[DNS_CACHE_HOST_LEN]; // empty = unused entry
+	uint32_t ip;
+	uint32_t storedMillis;
+} dnsCacheEntry_t;
+
+/*
+ * Public functions
+ */
+
+bool dnsCacheLookup(const char *hostname, uint32_t &ip);
+void dnsCacheAdd(const char *hostname, uint32_t ip);
+void dnsCacheRemove(const char *hostname);
+void dnsCacheFlush();
+const dnsCacheEntry_t *dnsCacheEntry(uint8_t index);
+uint32_t dnsCacheTimeLeft(const dnsCacheEntry_t *entry);
+bool dnsCacheResolve(const char *hostname, IPAddress &ip, uint32_t timeout);
+
+#endif /* DNSCACHE_H_ */
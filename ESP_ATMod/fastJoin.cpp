@@ -0,0 +1,319 @@
+/*
+ * fastJoin.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "ESP_ATMod.h"
+#include "fastJoin.h"
+#include "settings.h"
+#include "debug.h"
+
+/*
+ * Note: after a successful join the SSID, BSSID, channel and DHCP lease are kept in the settings.
+ *       The next join to the same SSID goes directly to the cached BSSID on the cached channel,
+ *       with FAST_JOIN_LEASE the lease is configured as the static address and DHCP is skipped.
+ *       When the directed join does not associate, it is restarted with the full scan.
+ *       The reused lease is not renewed, the DHCP server should keep the address reserved.
+ *       The directed join locks the station to the cached BSSID, the lock is released on the
+ *       first disconnect so that the SDK reconnects to any access point of the SSID.
+ */
+
+/*
+ * Types
+ */
+
+typedef enum : uint8_t
+{
+	JOIN_IDLE,		 // No directed join in progress
+	JOIN_DIRECTED,	 // Directed join started, waiting for the association
+	JOIN_FALLBACK	 // Full scan started, waiting for the SDK to leave the failed status
+} joinState_t;
+
+/*
+ * Variables
+ */
+
+static joinState_t state = JOIN_IDLE;
+static bool joinRunning = true;	  // A join is running, the boot autoconnect at the start
+static bool leaseApplied = false; // The cached lease is configured as the static address
+static bool bssidLocked = false;  // The current station config holds the cached BSSID
+static uint32_t startMillis = 0;  // Start of the running join, 0 = boot
+static uint32_t stateMillis = 0;  // Start of the current state
+static char joinSsid[33];		  // Credentials for the full scan fallback
+static char joinPwd[65];
+
+/*
+ * Static functions
+ */
+
+static bool cacheValid(const joinCache_t &cache, const char *ssid);
+static void restoreDhcp();
+static void releaseBssid();
+static void beginFullScan();
+
+/*
+ * Public functions
+ */
+
+/*
+ * Starts the join, directed to the cached access point if no BSSID is given and the cache belongs to the SSID
+ */
+void fastJoinBegin(const char *ssid, const char *pwd, const uint8_t *bssid)
+{
+	joinCache_t cache = Settings::getJoinCache();
+	uint8_t mode = Settings::getFastJoinMode();
+
+	restoreDhcp();
+
+	state = JOIN_IDLE;
+	joinRunning = true;
+	startMillis = millis();
+
+	if (bssid == nullptr && mode != FAST_JOIN_OFF && cacheValid(cache, ssid))
+	{
+		AT_DEBUG_PRINTF("--- fast join: channel %d\r\n", cache.channel);
+
+		strlcpy(joinSsid, ssid, sizeof(joinSsid));
+		strlcpy(joinPwd, pwd, sizeof(joinPwd));
+
+		if (mode == FAST_JOIN_LEASE && (gsCwDhcp & CWDHCP_STA) && cache.lease.ip != 0)
+		{
+			WiFi.config(cache.lease.ip, cache.lease.gw, cache.lease.mask, cache.dns);
+			leaseApplied = true;
+		}
+
+		WiFi.begin(ssid, pwd, cache.channel, cache.bssid);
+		bssidLocked = true;
+
+		state = JOIN_DIRECTED;
+		stateMillis = millis();
+	}
+	else
+	{
+		WiFi.begin(ssid, pwd, 0, bssid);
+		bssidLocked = false; // The BSSID given by the command stays
+	}
+}
+
+/*
+ * Restarts the boot autoconnect of the SDK as the directed join, called from setup()
+ */
+void fastJoinAutoConnect()
+{
+	if (Settings::getFastJoinMode() == FAST_JOIN_OFF || !(WiFi.getMode() & WIFI_STA) || !WiFi.getAutoConnect())
+		return;
+
+	struct station_config conf;
+	if (!wifi_station_get_config_default(&conf) || conf.bssid_set)
+		return;
+
+	char ssid[33];
+	char pwd[65];
+
+	memcpy(ssid, conf.ssid, 32);
+	ssid[32] = '\0';
+	memcpy(pwd, conf.password, 64);
+	pwd[64] = '\0';
+
+	if (ssid[0] == '\0' || !cacheValid(Settings::getJoinCache(), ssid))
+		return;
+
+	fastJoinBegin(ssid, pwd, nullptr);
+
+	startMillis = 0; // The join time is counted from the boot
+}
+
+/*
+ * Falls back to the full scan when the directed join fails, called from loop()
+ * Returns true while the connect status belongs to the directed join and is not final
+ */
+bool fastJoinProcess()
+{
+	if (state == JOIN_IDLE)
+		return false;
+
+	station_status_t status = wifi_station_get_connect_status();
+
+	if (state == JOIN_DIRECTED)
+	{
+		if (status == STATION_GOT_IP || status == STATION_WRONG_PASSWORD)
+		{
+			state = JOIN_IDLE; // The full scan would not help with the wrong password
+
+			return false;
+		}
+
+		if (status == STATION_NO_AP_FOUND || status == STATION_CONNECT_FAIL
+			|| millis() - stateMillis >= FAST_JOIN_ASSOC_TIMEOUT)
+			beginFullScan();
+
+		return true;
+	}
+
+	// JOIN_FALLBACK
+	if (status == STATION_CONNECTING || millis() - stateMillis >= 1000)
+	{
+		state = JOIN_IDLE;
+
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Stops the fast join state when the station is disconnected by a command
+ */
+void fastJoinCancel()
+{
+	state = JOIN_IDLE;
+	joinRunning = false;
+
+	restoreDhcp();
+	releaseBssid();
+}
+
+/*
+ * Called from the WiFi event when the station associates
+ */
+void fastJoinConnected()
+{
+	if (state == JOIN_DIRECTED)
+		state = JOIN_IDLE; // Associated, the status is handled as the normal join
+}
+
+/*
+ * Called from the WiFi event when the station disconnects, the reconnection is timed from now
+ */
+void fastJoinDisconnected()
+{
+	// The reconnect must not depend on the cached access point, the directed join itself waits
+	// for the association and falls back to the full scan
+	if (state != JOIN_DIRECTED)
+		releaseBssid();
+
+	if (!joinRunning)
+	{
+		joinRunning = true;
+		startMillis = millis();
+	}
+}
+
+/*
+ * Called from the WiFi event when the station gets the IP address, updates the cache
+ * Returns the join time [ms]
+ */
+uint32_t fastJoinGotIP(uint32_t ip, uint32_t mask, uint32_t gw)
+{
+	state = JOIN_IDLE;
+	joinRunning = false;
+
+	if (Settings::getFastJoinMode() != FAST_JOIN_OFF)
+	{
+		joinCache_t cache = Settings::getJoinCache();
+		joinCache_t newCache = cache;
+		String ssid = WiFi.SSID();
+
+		newCache.ssidCrc = crc32(ssid.c_str(), ssid.length());
+		memcpy(newCache.bssid, WiFi.BSSID(), sizeof(newCache.bssid));
+		newCache.channel = WiFi.channel();
+
+		if (!(gsCwDhcp & CWDHCP_STA))
+		{
+			newCache.lease = ipConfig_t({0, 0, 0});
+			newCache.dns = 0;
+		}
+		else if (!leaseApplied)
+		{
+			newCache.lease = ipConfig_t({ip, gw, mask});
+			newCache.dns = WiFi.dnsIP(0);
+		}
+
+		// Written to the flash only when changed
+		if (memcmp(&cache, &newCache, sizeof(cache)))
+			Settings::setJoinCache(newCache);
+	}
+
+	return millis() - startMillis;
+}
+
+/*
+ * Static functions
+ */
+
+/*
+ * Checks that the cache holds a join to the SSID
+ */
+static bool cacheValid(const joinCache_t &cache, const char *ssid)
+{
+	return cache.channel != 0 && cache.ssidCrc == crc32(ssid, strlen(ssid));
+}
+
+/*
+ * Returns to DHCP if the cached lease was configured
+ */
+static void restoreDhcp()
+{
+	if (leaseApplied)
+	{
+		leaseApplied = false;
+		setDhcpMode();
+	}
+}
+
+/*
+ * Removes the BSSID of the directed join from the current station config
+ */
+static void releaseBssid()
+{
+	if (!bssidLocked)
+		return;
+
+	bssidLocked = false;
+
+	struct station_config conf;
+	if (wifi_station_get_config(&conf) && conf.bssid_set)
+	{
+		conf.bssid_set = 0;
+		wifi_station_set_config_current(&conf);
+	}
+}
+
+/*
+ * The directed join failed: forgets the cache and joins with the full scan
+ */
+static void beginFullScan()
+{
+	AT_DEBUG_PRINT("--- fast join failed, full scan\r\n");
+
+	joinCache_t cache = Settings::getJoinCache();
+	cache.channel = 0;
+	Settings::setJoinCache(cache);
+
+	restoreDhcp();
+
+	WiFi.begin(joinSsid, joinPwd);
+	bssidLocked = false;
+
+	state = JOIN_FALLBACK;
+	stateMillis = millis();
+}
@@ -0,0 +1,49 @@
+/*
+ * fastJoin.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FASTJOIN_H_
+#define FASTJOIN_H_
+
+#include "Arduino.h"
+#include "user_interface.h"
+
+/*
+ * Defines
+ */
+
+#define FAST_JOIN_OFF 0			   // AT+CWFASTJOIN=0, every join scans all channels
+#define FAST_JOIN_DIRECTED 1	   // AT+CWFASTJOIN=1, the join goes to the cached BSSID and channel
+#define FAST_JOIN_LEASE 2		   // AT+CWFASTJOIN=2, the cached DHCP lease is reused as well
+#define FAST_JOIN_ASSOC_TIMEOUT 4000 // Time [ms] for the directed join to associate before the full scan
+
+/*
+ * Public functions
+ */
+
+void fastJoinBegin(const char *ssid, const char *pwd, const uint8_t *bssid);
+void fastJoinAutoConnect();
+bool fastJoinProcess();
+void fastJoinCancel();
+void fastJoinConnected();
+void fastJoinDisconnected();
+uint32_t fastJoinGotIP(uint32_t ip, uint32_t mask, uint32_t gw);
+
+#endif /* FASTJOIN_H_ */
@@ -0,0 +1,136 @@
+/*
+ * mflnCache.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+
+#include "mflnCache.h"
+#include "debug.h"
+
+/*
+ * Note: the cache keeps the MFLN support found by the connections of AT+CIPSSLSIZE=0 (auto) and
+ *       the probes of AT+CIPSSLMFLN, so each server is tested only once. The result is valid only
+ *       for the tested fragment length. When full, the least recently used entry is replaced.
+ */
+
+/*
+ * Variables
+ */
+
+static mflnCacheEntry_t mflnCache[MFLN_CACHE_SIZE];
+
+/*
+ * Static functions
+ */
+
+static mflnCacheEntry_t *findEntry(const char *host, uint16_t port, uint16_t maxLen);
+
+/*
+ * Public functions
+ */
+
+/*
+ * Looks up the MFLN support of the server. Returns false if not known.
+ */
+bool mflnCacheLookup(const char *host, uint16_t port, uint16_t maxLen, bool &supported)
+{
+	mflnCacheEntry_t *entry = findEntry(host, port, maxLen);
+
+	if (entry == nullptr)
+		return false;
+
+	supported = entry->supported;
+	entry->lastUsedMillis = millis();
+
+	AT_DEBUG_PRINTF("--- mfln cache hit: %s:%d\r\n", host, port);
+
+	return true;
+}
+
+/*
+ * Stores the probe result. Replaces the same server, an unused entry or the least recently used one.
+ */
+void mflnCacheAdd(const char *host, uint16_t port, uint16_t maxLen, bool supported)
+{
+	if (strlen(host) >= MFLN_CACHE_HOST_LEN)
+		return;
+
+	mflnCacheEntry_t *entry = findEntry(host, port, maxLen);
+
+	if (entry == nullptr)
+	{
+		entry = &mflnCache[0];
+
+		for (uint8_t i = 0; i < MFLN_CACHE_SIZE; ++i)
+		{
+			if (mflnCache[i].host[0] == '\0')
+			{
+				entry = &mflnCache[i];
+				break;
+			}
+
+			if ((int32_t)(mflnCache[i].lastUsedMillis - entry->lastUsedMillis) < 0)
+				entry = &mflnCache[i];
+		}
+
+		strcpy(entry->host, host);
+		entry->port = port;
+		entry->maxLen = maxLen;
+	}
+
+	entry->supported = supported;
+	entry->lastUsedMillis = millis();
+}
+
+/*
+ * Removes the server from the cache, e.g. when the connection with the reduced buffer failed
+ */
+void mflnCacheRemove(const char *host, uint16_t port, uint16_t maxLen)
+{
+	mflnCacheEntry_t *entry = findEntry(host, port, maxLen);
+
+	if (entry != nullptr)
+		entry->host[0] = '\0';
+}
+
+/*
+ * Removes all entries (AT+CIPSSLMFLN=FLUSH)
+ */
+void mflnCacheFlush()
+{
+	for (uint8_t i = 0; i < MFLN_CACHE_SIZE; ++i)
+		mflnCache[i].host[0] = '\0';
+}
+
+/*
+ * Static functions
+ */
+
+static mflnCacheEntry_t *findEntry(const char *host, uint16_t port, uint16_t maxLen)
+{
+	for (uint8_t i = 0; i < MFLN_CACHE_SIZE; ++i)
+	{
+		if (mflnCache[i].host[0] != '\0' && mflnCache[i].port == port && mflnCache[i].maxLen == maxLen
+			&& !strcasecmp(mflnCache[i].host, host))
+			return &mflnCache[i];
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,56 @@
+/*
+ * mflnCache.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MFLNCACHE_H_
+#define MFLNCACHE_H_
+
+#include "Arduino.h"
+
+/*
+ * Defines
+ */
+
+#define MFLN_CACHE_SIZE 8
+#define MFLN_CACHE_HOST_LEN 64
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	char host[MFLN_CACHE_HOST_LEN]; // empty = unused entry
+	uint16_t port;
+	uint16_t maxLen; // the tested fragment length
+	bool supported;	 // the server accepts the MFLN extension with maxLen
+	uint32_t lastUsedMillis;
+} mflnCacheEntry_t;
+
+/*
+ * Public functions
+ */
+
+bool mflnCacheLookup(const char *host, uint16_t port, uint16_t maxLen, bool &supported);
+void mflnCacheAdd(const char *host, uint16_t port, uint16_t maxLen, bool supported);
+void mflnCacheRemove(const char *host, uint16_t port, uint16_t maxLen);
+void mflnCacheFlush();
+
+#endif /* MFLNCACHE_H_ */
@@ -0,0 +1,132 @@
+/*
+ * perf.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "ESP_ATMod.h"
+#include "perf.h"
+
+/*
+ * Note: the probes measure CPU cycles (ESP.getCycleCount()), the counter wraps
+ *       after 53 s at 80 MHz, longer intervals are not measured correctly.
+ */
+
+/*
+ * Variables
+ */
+
+static perfHistogram_t histograms[PERF_PROBES];
+static uint32_t counters[PERF_COUNTERS];
+static uint32_t linkBytesIn[MAX_LINKS];
+static uint32_t linkBytesOut[MAX_LINKS];
+static uint32_t startMillis = 0; // Start of the measurement
+
+static const char *const PERF_PROBE_NAMES[PERF_PROBES] = {"loop", "command", "ipd", "write", "connect"};
+static const char *const PERF_COUNTER_NAMES[PERF_COUNTERS] = {"busy", "overflow", "overrun"};
+
+/*
+ * Public functions
+ */
+
+/*
+ * Adds the measured interval to the probe histogram
+ */
+void perfRecord(perfProbe_t probe, uint32_t cycles)
+{
+	perfHistogram_t *h = &histograms[probe];
+
+	++h->count;
+	h->totalCycles += cycles;
+	if (cycles > h->maxCycles)
+		h->maxCycles = cycles;
+
+	// Buckets by powers of 4 starting at 16 us
+	uint32_t us = cycles / ESP.getCpuFreqMHz();
+	uint8_t bucket = 0;
+
+	for (uint32_t limit = 16; bucket < PERF_BUCKETS - 1 && us >= limit; limit <<= 2)
+		++bucket;
+
+	++h->buckets[bucket];
+}
+
+void perfCount(perfCounter_t counter)
+{
+	++counters[counter];
+}
+
+void perfLinkBytes(uint8_t link, uint32_t in, uint32_t out)
+{
+	if (link >= MAX_LINKS)
+		return;
+
+	linkBytesIn[link] += in;
+	linkBytesOut[link] += out;
+}
+
+/*
+ * Clears all histograms and counters
+ */
+void perfReset()
+{
+	memset(histograms, 0, sizeof(histograms));
+	memset(counters, 0, sizeof(counters));
+	memset(linkBytesIn, 0, sizeof(linkBytesIn));
+	memset(linkBytesOut, 0, sizeof(linkBytesOut));
+	startMillis = millis();
+}
+
+/*
+ * Prints the measurement time in ms, the histograms (count, average and maximum in us, buckets),
+ * the counters and the link bytes
+ */
+void perfPrint()
+{
+	uint32_t mhz = ESP.getCpuFreqMHz();
+
+	SerialTx.printf_P(PSTR("+SYSPERF:time,%u\r\n"), (uint32_t)(millis() - startMillis));
+
+	for (uint8_t i = 0; i < PERF_PROBES; ++i)
+	{
+		const perfHistogram_t *h = &histograms[i];
+		uint32_t avg = (h->count > 0 ? (uint32_t)(h->totalCycles / h->count / mhz) : 0);
+
+		SerialTx.printf_P(PSTR("+SYSPERF:%s,%u,%u,%u"), PERF_PROBE_NAMES[i], h->count, avg, h->maxCycles / mhz);
+
+		for (uint8_t j = 0; j < PERF_BUCKETS; ++j)
+			SerialTx.printf_P(PSTR(",%u"), h->buckets[j]);
+
+		SerialTx.println();
+	}
+
+	for (uint8_t i = 0; i < PERF_COUNTERS; ++i)
+	{
+		SerialTx.printf_P(PSTR("+SYSPERF:%s,%u\r\n"), PERF_COUNTER_NAMES[i], counters[i]);
+	}
+
+	// Only the links with traffic
+	for (uint8_t i = 0; i < MAX_LINKS; ++i)
+	{
+		if (linkBytesIn[i] > 0 || linkBytesOut[i] > 0)
+			SerialTx.printf_P(PSTR("+SYSPERF,%d:%u,%u\r\n"), i, linkBytesIn[i], linkBytesOut[i]);
+	}
+}
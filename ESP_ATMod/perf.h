@@ -0,0 +1,115 @@
+/*
+ * perf.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERF_H_
+#define PERF_H_
+
+#include "Arduino.h"
+
+/*
+ * Performance probes flag, uncomment to add the probes and AT+SYSPERF
+ */
+//#define AT_PERF
+
+/*
+ * Defines
+ */
+
+#define PERF_BUCKETS 8 // Histogram buckets: < 16 us, < 64 us, ... (times 4), the last is >= 65536 us
+
+/*
+ * Types
+ */
+
+enum perfProbe_t
+{
+	PERF_LOOP = 0,	   // one loop() pass
+	PERF_COMMAND,	   // processCommandBuffer()
+	PERF_SENDDATA,	   // SendData() with data
+	PERF_CLIENT_WRITE, // client->write() of AT+CIPSEND, AT+CIPSENDBUF and passthrough data
+	PERF_CONNECT,	   // client->connect() of AT+CIPSTART
+	PERF_PROBES
+};
+
+enum perfCounter_t
+{
+	PERF_BUSY,			 // commands refused with busy
+	PERF_INPUT_OVERFLOW, // command lines longer than the input buffer
+	PERF_UART_OVERRUN,	 // UART receive buffer overruns
+	PERF_COUNTERS
+};
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t maxCycles;
+	uint64_t totalCycles;
+	uint32_t buckets[PERF_BUCKETS];
+} perfHistogram_t;
+
+/*
+ * Macros
+ */
+
+#if defined(AT_PERF)
+
+#define PERF_START(var) uint32_t var = ESP.getCycleCount()
+#define PERF_STOP(probe, var) perfRecord(probe, ESP.getCycleCount() - var)
+#define PERF_COUNT(counter) perfCount(counter)
+#define PERF_LINK_IN(link, bytes) perfLinkBytes(link, bytes, 0)
+#define PERF_LINK_OUT(link, bytes) perfLinkBytes(link, 0, bytes)
+
+#else
+
+#define PERF_START(var) \
+	do                  \
+	{                   \
+	} while (0)
+#define PERF_STOP(probe, var) \
+	do                        \
+	{                         \
+	} while (0)
+#define PERF_COUNT(counter) \
+	do                      \
+	{                       \
+	} while (0)
+#define PERF_LINK_IN(link, bytes) \
+	do                            \
+	{                             \
+	} while (0)
+#define PERF_LINK_OUT(link, bytes) \
+	do                             \
+	{                              \
+	} while (0)
+
+#endif
+
+/*
+ * Public functions
+ */
+
+void perfRecord(perfProbe_t probe, uint32_t cycles);
+void perfCount(perfCounter_t counter);
+void perfLinkBytes(uint8_t link, uint32_t in, uint32_t out);
+void perfReset();
+void perfPrint();
+
+#endif /* PERF_H_ */
@@ -0,0 +1,216 @@
+/*
+ * scanCache.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "scanCache.h"
+#include "debug.h"
+
+/*
+ * Note: the scan results are copied from the SDK list, which is freed afterwards. Only the result
+ *       of a full scan (all channels, all SSIDs) may answer the later AT+CWLAP commands, the result
+ *       of a restricted scan is kept just for printing.
+ */
+
+/*
+ * Variables
+ */
+
+static scanCacheEntry_t *entries = nullptr; // Allocated for the found access points
+static uint8_t count = 0;
+static bool complete = false;		  // The entries are the result of a full scan
+static bool running = false;		  // An asynchronous scan is running
+static bool restricted = false;		  // The running scan is restricted to a channel or SSID
+static uint32_t storedMillis = 0;
+static char scanSsid[33];			  // SSID of the running restricted scan
+
+/*
+ * Static functions
+ */
+
+static bool store(int networksFound);
+
+/*
+ * Public functions
+ */
+
+/*
+ * Starts an asynchronous scan, restricted to the SSID (empty = all) and the channel (0 = all)
+ */
+bool scanCacheStart(const char *ssid, uint8_t channel)
+{
+	if (running)
+		return false;
+
+	strlcpy(scanSsid, ssid, sizeof(scanSsid));
+	restricted = (scanSsid[0] != '\0' || channel != 0);
+
+	if (WiFi.scanNetworks(true, false, channel, scanSsid[0] != '\0' ? (uint8_t *)scanSsid : nullptr) == WIFI_SCAN_FAILED)
+		return false;
+
+	running = true;
+
+	return true;
+}
+
+/*
+ * Checks the running scan, called from loop()
+ * Returns WIFI_SCAN_RUNNING, WIFI_SCAN_FAILED or the number of the stored access points
+ */
+int scanCacheProcess()
+{
+	if (!running)
+		return WIFI_SCAN_FAILED;
+
+	int networksFound = WiFi.scanComplete();
+
+	if (networksFound == WIFI_SCAN_RUNNING)
+		return WIFI_SCAN_RUNNING;
+
+	running = false;
+
+	if (networksFound < 0 || !store(networksFound))
+	{
+		WiFi.scanDelete();
+		return WIFI_SCAN_FAILED;
+	}
+
+	WiFi.scanDelete();
+
+	return count;
+}
+
+/*
+ * Returns true while a scan is running
+ */
+bool scanCacheIsRunning()
+{
+	return running;
+}
+
+/*
+ * Checks that the entries are the result of a full scan younger than maxAge [s]
+ */
+bool scanCacheValid(uint32_t maxAge)
+{
+	return complete && maxAge != 0 && millis() - storedMillis < maxAge * 1000;
+}
+
+/*
+ * Returns the age of the full scan result [s] or -1
+ */
+int32_t scanCacheAge()
+{
+	if (!complete)
+		return -1;
+
+	return (millis() - storedMillis) / 1000;
+}
+
+/*
+ * Returns the number of the entries
+ */
+uint8_t scanCacheCount()
+{
+	return count;
+}
+
+/*
+ * Returns the entry at the index or nullptr
+ */
+const scanCacheEntry_t *scanCacheEntry(uint8_t index)
+{
+	if (index >= count)
+		return nullptr;
+
+	return &entries[index];
+}
+
+/*
+ * Removes all entries
+ */
+void scanCacheFlush()
+{
+	free(entries);
+	entries = nullptr;
+	count = 0;
+	complete = false;
+}
+
+/*
+ * Static functions
+ */
+
+/*
+ * Copies the SDK scan result to the entries, above SCAN_CACHE_MAX_ENTRIES the strongest access points are kept
+ */
+static bool store(int networksFound)
+{
+	scanCacheFlush();
+
+	uint8_t size = _min(networksFound, SCAN_CACHE_MAX_ENTRIES);
+
+	if (size > 0)
+	{
+		entries = (scanCacheEntry_t *)malloc(size * sizeof(scanCacheEntry_t));
+		if (entries == nullptr)
+			return false;
+	}
+
+	for (int i = 0; i < networksFound; ++i)
+	{
+		uint8_t index = count;
+
+		if (count == size)
+		{
+			// Full: replace the weakest entry if weaker than this one
+			index = 0;
+			for (uint8_t j = 1; j < count; ++j)
+			{
+				if (entries[j].rssi < entries[index].rssi)
+					index = j;
+			}
+
+			if (entries[index].rssi >= WiFi.RSSI(i))
+				continue;
+		}
+		else
+		{
+			++count;
+		}
+
+		scanCacheEntry_t &entry = entries[index];
+
+		strlcpy(entry.ssid, WiFi.SSID(i).c_str(), sizeof(entry.ssid));
+		memcpy(entry.bssid, WiFi.BSSID(i), sizeof(entry.bssid));
+		entry.rssi = WiFi.RSSI(i);
+		entry.channel = WiFi.channel(i);
+		entry.encryption = WiFi.encryptionType(i);
+	}
+
+	complete = !restricted;
+	storedMillis = millis();
+
+	AT_DEBUG_PRINTF("--- scan cache: %d entries\r\n", count);
+
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * scanCache.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANCACHE_H_
+#define SCANCACHE_H_
+
+#include "Arduino.h"
+
+/*
+ * Defines
+ */
+
+#define SCAN_CACHE_MAX_ENTRIES 32 // Maximum number of the stored access points
+#define SCAN_CACHE_MAX_AGE 3600	  // Maximum of AT+CWLAPCACHE [s]
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	char ssid[33];
+	uint8_t bssid[6];
+	int8_t rssi;
+	uint8_t channel;
+	uint8_t encryption; // WiFi.encryptionType()
+} scanCacheEntry_t;
+
+/*
+ * Public functions
+ */
+
+bool scanCacheStart(const char *ssid, uint8_t channel);
+int scanCacheProcess();
+bool scanCacheIsRunning();
+bool scanCacheValid(uint32_t maxAge);
+int32_t scanCacheAge();
+uint8_t scanCacheCount();
+const scanCacheEntry_t *scanCacheEntry(uint8_t index);
+void scanCacheFlush();
+
+#endif /* SCANCACHE_H_ */
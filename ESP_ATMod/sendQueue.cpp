@@ -0,0 +1,196 @@
+/*
+ * sendQueue.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "sendQueue.h"
+#include "debug.h"
+
+/*
+ * Note: the queue keeps the AT+CIPSENDBUF segments of a link. The segments are written
+ *       to the client from loop() as the TCP send buffer allows, the host doesn't wait.
+ *       The segment ids start at 1.
+ */
+
+/*
+ * Static functions
+ */
+
+static int32_t dropSegment(sendQueue_t *queue, uint32_t seq);
+
+/*
+ * Public functions
+ */
+
+/*
+ * Allocates an empty queue, returns nullptr when out of memory
+ */
+sendQueue_t *sendQueueCreate()
+{
+	sendQueue_t *queue = new sendQueue_t;
+
+	if (queue == nullptr)
+		return nullptr;
+
+	queue->head = 0;
+	queue->tail = 0;
+	queue->used = 0;
+	queue->reserved = 0;
+	queue->segCount = 0;
+	queue->nextSeq = 1;
+
+	return queue;
+}
+
+/*
+ * Reserves space for a new segment. Returns false when the queue is full.
+ */
+bool sendQueueBegin(sendQueue_t *queue, uint16_t length)
+{
+	if (queue->reserved > 0 || length == 0 || length > sendQueueFree(queue))
+		return false;
+
+	queue->reserved = length;
+	queue->used += length;
+
+	return true;
+}
+
+/*
+ * Adds a byte of the segment being read
+ */
+void sendQueuePut(sendQueue_t *queue, uint8_t c)
+{
+	queue->data[queue->head] = c;
+
+	if (++queue->head >= SEND_QUEUE_SIZE)
+		queue->head = 0;
+}
+
+/*
+ * Closes the segment being read, returns its id
+ */
+uint32_t sendQueueCommit(sendQueue_t *queue)
+{
+	uint32_t seq = queue->nextSeq++;
+
+	queue->segLength[seq % SEND_QUEUE_SEGMENTS] = queue->reserved;
+	queue->reserved = 0;
+	++queue->segCount;
+
+	return seq;
+}
+
+/*
+ * Writes the first segment to the client as far as the client accepts the data without waiting
+ * Returns the segment id when the whole segment was written, -id on a write error (the segment
+ * is dropped), 0 otherwise
+ */
+int32_t sendQueueTransmit(sendQueue_t *queue, WiFiClient *cli)
+{
+	if (queue->segCount == 0)
+		return 0;
+
+	uint32_t seq = queue->nextSeq - queue->segCount;
+	uint16_t *remaining = &(queue->segLength[seq % SEND_QUEUE_SEGMENTS]);
+
+	if (!cli->connected())
+		return dropSegment(queue, seq);
+
+	int room = cli->availableForWrite();
+
+	if (room <= 0)
+		return 0;
+
+	// Contiguous part of the ring
+	uint16_t len = *remaining;
+	if (len > SEND_QUEUE_SIZE - queue->tail)
+		len = SEND_QUEUE_SIZE - queue->tail;
+	if (len > room)
+		len = room;
+
+	size_t written = cli->write(queue->data + queue->tail, len);
+
+	if (written == 0)
+		return dropSegment(queue, seq);
+
+	queue->tail = (queue->tail + written) % SEND_QUEUE_SIZE;
+	queue->used -= written;
+	*remaining -= written;
+
+	if (*remaining > 0)
+		return 0;
+
+	--queue->segCount;
+
+	AT_DEBUG_PRINTF("--- segment sent: %d\r\n", seq);
+
+	return seq;
+}
+
+/*
+ * Returns the free space for a new segment
+ */
+uint16_t sendQueueFree(const sendQueue_t *queue)
+{
+	if (queue->segCount >= SEND_QUEUE_SEGMENTS)
+		return 0;
+
+	return SEND_QUEUE_SIZE - queue->used;
+}
+
+uint32_t sendQueueNextSeq(const sendQueue_t *queue)
+{
+	return queue->nextSeq;
+}
+
+/*
+ * Returns the id of the last segment written to the client, 0 = none
+ */
+uint32_t sendQueueSentSeq(const sendQueue_t *queue)
+{
+	return queue->nextSeq - queue->segCount - 1;
+}
+
+uint8_t sendQueueSegments(const sendQueue_t *queue)
+{
+	return queue->segCount;
+}
+
+/*
+ * Static functions
+ */
+
+/*
+ * Drops the first segment after a write error, returns -id
+ */
+int32_t dropSegment(sendQueue_t *queue, uint32_t seq)
+{
+	uint16_t *remaining = &(queue->segLength[seq % SEND_QUEUE_SEGMENTS]);
+
+	queue->tail = (queue->tail + *remaining) % SEND_QUEUE_SIZE;
+	queue->used -= *remaining;
+	*remaining = 0;
+	--queue->segCount;
+
+	return -(int32_t)seq;
+}
@@ -0,0 +1,65 @@
+/*
+ * sendQueue.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SENDQUEUE_H_
+#define SENDQUEUE_H_
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+/*
+ * Defines
+ */
+
+#define SEND_QUEUE_SIZE 2048	// Bytes buffered per link
+#define SEND_QUEUE_SEGMENTS 8	// Segments buffered per link
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	uint8_t data[SEND_QUEUE_SIZE];			 // Ring buffer of the segment data
+	uint16_t segLength[SEND_QUEUE_SEGMENTS]; // Segment lengths, indexed by segment id
+	uint16_t head;							 // Write position
+	uint16_t tail;							 // Read position, next byte to transmit
+	uint16_t used;							 // Bytes in the buffer including the segment being read
+	uint16_t reserved;						 // Length of the segment being read
+	uint8_t segCount;						 // Committed and not yet sent segments
+	uint32_t nextSeq;						 // Id of the next segment
+} sendQueue_t;
+
+/*
+ * Public functions
+ */
+
+sendQueue_t *sendQueueCreate();
+bool sendQueueBegin(sendQueue_t *queue, uint16_t length);
+void sendQueuePut(sendQueue_t *queue, uint8_t c);
+uint32_t sendQueueCommit(sendQueue_t *queue);
+int32_t sendQueueTransmit(sendQueue_t *queue, WiFiClient *cli);
+uint16_t sendQueueFree(const sendQueue_t *queue);
+uint32_t sendQueueNextSeq(const sendQueue_t *queue);
+uint32_t sendQueueSentSeq(const sendQueue_t *queue);
+uint8_t sendQueueSegments(const sendQueue_t *queue);
+
+#endif /* SENDQUEUE_H_ */
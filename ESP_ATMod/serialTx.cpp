@@ -0,0 +1,104 @@
+/*
+ * serialTx.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+
+#include "serialTx.h"
+
+/*
+ * Note: the UART of the ESP8266 has a 128 byte hardware FIFO and Serial.write() waits while it is full,
+ *       Serial.availableForWrite() is the free space of the FIFO.
+ */
+
+SerialTxBuffer SerialTx;
+
+/*
+ * Public functions
+ */
+
+/*
+ * Copies the data to the buffer, waits for the UART only until the data fit
+ */
+size_t SerialTxBuffer::write(const uint8_t *buffer, size_t size)
+{
+	if (size > (size_t)availableForWrite())
+	{
+		// Too large for the buffer, the order is kept when the buffer is empty
+		if (size > SERIAL_TX_BUFFER_SIZE)
+		{
+			drain(SERIAL_TX_BUFFER_SIZE);
+			return Serial.write(buffer, size);
+		}
+
+		drain(size);
+	}
+
+	size_t first = _min(size, (size_t)(SERIAL_TX_BUFFER_SIZE - _head));
+
+	memcpy(_buffer + _head, buffer, first);
+	memcpy(_buffer, buffer + first, size - first);
+
+	_head = (_head + size) % SERIAL_TX_BUFFER_SIZE;
+	_used += size;
+
+	// Fill the FIFO right away, the short responses leave without waiting for loop()
+	drain(0);
+
+	return size;
+}
+
+void SerialTxBuffer::flush()
+{
+	drain(SERIAL_TX_BUFFER_SIZE);
+	Serial.flush();
+}
+
+/*
+ * Private functions
+ */
+
+/*
+ * Writes the buffer to the UART as much as the FIFO takes, waits for the UART only until
+ * the buffer has the space free
+ */
+void SerialTxBuffer::drain(size_t space)
+{
+	while (_used > 0)
+	{
+		size_t n = _min((size_t)_used, (size_t)(SERIAL_TX_BUFFER_SIZE - _tail));
+		size_t room = Serial.availableForWrite();
+		size_t unused = SERIAL_TX_BUFFER_SIZE - _used;
+
+		// The bytes missing to the space are written even when the FIFO is full
+		if (space > unused)
+			room = _max(room, space - unused);
+
+		if (room == 0)
+			break;
+
+		n = _min(n, room);
+
+		Serial.write(_buffer + _tail, n);
+
+		_tail = (_tail + n) % SERIAL_TX_BUFFER_SIZE;
+		_used -= n;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * serialTx.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERIALTX_H_
+#define SERIALTX_H_
+
+#include "Arduino.h"
+
+/*
+ * Defines
+ */
+
+#define SERIAL_TX_BUFFER_SIZE 2048 // Bytes buffered for the serial port
+
+/*
+ * Output of the AT port through a ring buffer, all responses, messages and data go through it to keep their order.
+ * A write copies the data and moves to the UART only what the hardware FIFO takes, loop() drains the rest.
+ * Only when the buffer is full, the write waits for the UART until the data fit.
+ */
+
+class SerialTxBuffer : public Print
+{
+public:
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+
+	// Free space of the buffer
+	int availableForWrite() override { return SERIAL_TX_BUFFER_SIZE - _used; }
+
+	// Waits until the buffer and the UART are empty, e.g. before a reset or a baud rate change
+	void flush() override;
+
+	// Moves the buffered data to the UART without waiting, called from loop()
+	void process() { drain(0); }
+
+	uint16_t pending() const { return _used; }
+
+private:
+	void drain(size_t space);
+
+	uint8_t _buffer[SERIAL_TX_BUFFER_SIZE];
+	uint16_t _head = 0; // Write position
+	uint16_t _tail = 0; // Read position, next byte to the UART
+	uint16_t _used = 0;
+};
+
+extern SerialTxBuffer SerialTx;
+
+#endif /* SERIALTX_H_ */
@@ -26,137 +26,80 @@
 
 #include "ESP_ATMod.h"
 #include "settings.h"
+#include "fastJoin.h"
 #include "debug.h"
 
 /*
  * Class Settings
  */
 
+eepromData_t Settings::data;
+bool Settings::loaded = false;
+bool Settings::dirty = false;
+uint32_t Settings::changedMillis = 0;
+
 /*
- * Getters and setters
+ * Public functions
  */
 
-void Settings::setUartBaudRate(uint32_t baudRate)
-{
-	EEPROMData eeprom;
-
-	eeprom.setUartBaudRate(baudRate);
-}
-
-uint32_t Settings::getUartBaudRate()
-{
-	EEPROMData eeprom;
-
-	return eeprom.getUartBaudRate();
-}
-
-void Settings::setUartConfig(SerialConfig config)
-{
-	EEPROMData eeprom;
-
-	eeprom.setUartConfig(config);
-}
-
-SerialConfig Settings::getUartConfig()
-{
-	EEPROMData eeprom;
-
-	return eeprom.getUartConfig();
-}
-
-void Settings::setDhcpMode(uint8_t mode)
-{
-	EEPROMData eeprom;
-
-	eeprom.setDhcpMode(mode);
-}
-
-uint8_t Settings::getDhcpMode()
-{
-	EEPROMData eeprom;
-
-	return eeprom.getDhcpMode();
-}
-
-void Settings::setNetConfig(ipConfig_t netCfg)
-{
-	EEPROMData eeprom;
-
-	eeprom.setNetConfig(netCfg);
-}
-
-ipConfig_t Settings::getNetConfig()
-{
-	EEPROMData eeprom;
-
-	return eeprom.getNetConfig();
-}
-
-void Settings::setDnsConfig(dnsConfig_t dnsCfg)
-{
-	EEPROMData eeprom;
-
-	eeprom.setDnsConfig(dnsCfg);
-}
-
-dnsConfig_t Settings::getDnsConfig()
+void Settings::reset()
 {
-	EEPROMData eeprom;
-
-	return eeprom.getDnsConfig();
+	resetData(load());
+	changed();
 }
 
-void Settings::setApIpConfig(ipConfig_t apIpCfg)
+/*
+ * Writes the changed settings to the flash
+ */
+void Settings::save()
 {
-	EEPROMData eeprom;
+	if (!dirty)
+		return;
 
-	eeprom.setApIpConfig(apIpCfg);
-}
-
-void Settings::setEthIpConfig(ipConfig_t ethIpCfg)
-{
-	EEPROMData eeprom;
+	dirty = false;
 
-	eeprom.setEthIpConfig(ethIpCfg);
-}
+	AT_DEBUG_PRINT("\r\n--- EEPROM on\r\n");
 
-ipConfig_t Settings::getApIpConfig()
-{
-	EEPROMData eeprom;
+	EEPROM.begin(EEPROM_DATA_SIZE);
 
-	return eeprom.getApIpConfig();
-}
+	eepromHeader_t header;
+	header.magic = SETTINGS_MAGIC;
+	header.version = SETTINGS_VERSION;
+	header.length = sizeof(data);
+	header.crc32 = crc32(&data, sizeof(data));
 
-ipConfig_t Settings::getEthIpConfig()
-{
-	EEPROMData eeprom;
+	// Check for data update
+	const uint8_t *flash = EEPROM.getConstDataPtr();
+	if (memcmp(&header, flash, sizeof(header)) || memcmp(&data, flash + sizeof(header), sizeof(data)))
+	{
+		AT_DEBUG_PRINT("--- EEPROM write\r\n");
 
-	return eeprom.getEthIpConfig();
-}
+		EEPROM.put(0, header);
+		EEPROM.put(sizeof(header), data);
+	}
 
-void Settings::setMaximumCertificates(int maximumCertificates)
-{
-	EEPROMData eeprom;
+	EEPROM.end();
 
-	eeprom.setMaximumCertificates(maximumCertificates);
+	AT_DEBUG_PRINT("\r\n--- EEPROM off\r\n");
 }
 
-int Settings::getMaximumCertificates()
+/*
+ * Writes the settings after the quiet period, called from loop()
+ */
+void Settings::process()
 {
-	EEPROMData eeprom;
-
-	return eeprom.getMaximumCertificates();
+	if (dirty && millis() - changedMillis >= SETTINGS_COMMIT_DELAY)
+		save();
 }
 
 /*
  * Other functions
  */
 
-void Settings::reset()
+void Settings::changed()
 {
-	EEPROMData eeprom;
-
-	resetData(eeprom.getDataPtr());
+	dirty = true;
+	changedMillis = millis();
 }
 
 void Settings::resetData(eepromData_t *dataPtr)
@@ -169,43 +112,72 @@ void Settings::resetData(eepromData_t *dataPtr)
 	dataPtr->apIpConfig = ipConfig_t({0, 0, 0});
 	dataPtr->ethIpConfig = ipConfig_t({0, 0, 0});
 	dataPtr->maximumCertificates = 5;
+	dataPtr->uartFlowControl = 0;
+	dataPtr->uartRxBufferSize = UART_RX_BUFFER_DEFAULT;
+	dataPtr->fastJoinMode = FAST_JOIN_DIRECTED;
+	memset(&dataPtr->joinCache, 0, sizeof(dataPtr->joinCache));
+	dataPtr->ethSpiClock = ETH_SPI_CLOCK_DEFAULT;
+	dataPtr->ethIntPin = -1;
 }
 
 /*
- * Inner Class EEPROMData
+ * Reads the settings from the flash, the missing or invalid data get the default values
  */
-
-Settings::EEPROMData::EEPROMData()
+void Settings::read()
 {
-	AT_DEBUG_PRINT("\r\n--- EEPROM on\r\n");
+	AT_DEBUG_PRINT("\r\n--- EEPROM read\r\n");
 
-	EEPROM.begin(EEPROM_DATA_SIZE);
+	loaded = true;
+	resetData(&data);
 
-	EEPROM.get(0, data);
-
-	unsigned int crc = crc32(&data, sizeof(data) - 4);
+	EEPROM.begin(EEPROM_DATA_SIZE);
 
-	// Check the data is valid
+	const uint8_t *flash = EEPROM.getConstDataPtr();
+	eepromHeader_t header;
+	memcpy(&header, flash, sizeof(header));
 
-	if (crc != data.crc32)
+	if (header.magic == SETTINGS_MAGIC)
 	{
-		AT_DEBUG_PRINT("--- EEPROM reset\r\n");
-
-		Settings::resetData(&data);
+		// Versioned layout, the data may be shorter when written by an older firmware
+		const uint8_t *stored = flash + sizeof(header);
+
+		if (header.version == SETTINGS_VERSION && header.length <= EEPROM_DATA_SIZE - sizeof(header)
+			&& crc32(stored, header.length) == header.crc32)
+		{
+			memcpy(&data, stored, _min(sizeof(data), (size_t)header.length));
+
+			if (header.length != sizeof(data))
+				changed(); // Write the new layout
+		}
+		else
+		{
+			AT_DEBUG_PRINT("--- EEPROM reset\r\n");
+			changed();
+		}
 	}
-}
-
-Settings::EEPROMData::~EEPROMData()
-{
-	AT_DEBUG_PRINT("\r\n--- EEPROM off\r\n");
-
-	// Check for data update
-	if (memcmp(&data, EEPROM.getConstDataPtr(), sizeof(data)))
+	else
 	{
-		AT_DEBUG_PRINT("--- EEPROM write\r\n");
-
-		data.crc32 = crc32(&data, sizeof(data) - 4);
-		EEPROM.put(0, data);
+		// Unversioned layouts: the data followed by crc32, the version 0.5.5 added the UART fields
+		static const uint8_t legacySizes[] = {SETTINGS_LEGACY_SIZE, SETTINGS_LEGACY_UART_SIZE};
+		bool valid = false;
+
+		for (uint8_t size : legacySizes)
+		{
+			uint32_t crc;
+			memcpy(&crc, flash + size, sizeof(crc));
+
+			if (crc32(flash, size) == crc)
+			{
+				memcpy(&data, flash, size);
+				valid = true;
+				break;
+			}
+		}
+
+		if (!valid)
+			AT_DEBUG_PRINT("--- EEPROM reset\r\n");
+
+		changed(); // Write the new layout
 	}
 
 	EEPROM.end();
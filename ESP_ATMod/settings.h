@@ -30,12 +30,55 @@
  * Defines
  */
 
-#define EEPROM_DATA_SIZE 64
+#define EEPROM_DATA_SIZE 128
+
+#define SETTINGS_MAGIC 0x4154	   // "AT" marks the versioned layout
+#define SETTINGS_VERSION 1		   // Incremented only on incompatible changes, the appended fields keep the version
+#define SETTINGS_LEGACY_SIZE 56	   // Size of the data of the unversioned layout (followed by crc32)
+#define SETTINGS_LEGACY_UART_SIZE 60 // The same with the UART fields of version 0.5.5
+#define SETTINGS_COMMIT_DELAY 1000 // Quiet period [ms] after the last change before the settings are written
 
 /*
  * Types
  */
 
+/*
+ * The station join remembered for the fast rejoin (AT+CWFASTJOIN)
+ */
+typedef struct
+{
+	uint32_t ssidCrc;	// crc32 of the SSID the cache belongs to
+	uint8_t bssid[6];	// BSSID of the last successful join
+	uint8_t channel;	// Channel of the last successful join, 0 = cache invalid
+	ipConfig_t lease;	// Last DHCP lease, ip = 0 if none
+	uint32_t dns;		// DNS server of the last DHCP lease
+} joinCache_t;
+
+/*
+ * Note: New fields must be added to the end of the structure. The data written by an older
+ *       firmware are shorter, the missing fields get the default values.
+ */
+typedef struct
+{
+	uint32_t uartBaudRate;
+	uint16_t uartConfig;
+	uint8_t dhcpMode;
+	ipConfig_t netConfig;
+	dnsConfig_t dnsConfig;
+	ipConfig_t apIpConfig;
+	ipConfig_t ethIpConfig;
+	int maximumCertificates;
+	uint8_t uartFlowControl;
+	uint16_t uartRxBufferSize;
+	uint8_t fastJoinMode;
+	joinCache_t joinCache;
+	uint8_t ethSpiClock;
+	int8_t ethIntPin;
+} eepromData_t;
+
+/*
+ * The unversioned layout of version 0.5.0, only for the migration
+ */
 typedef struct
 {
 	uint32_t uartBaudRate;
@@ -48,68 +91,84 @@ typedef struct
 	int maximumCertificates;
 
 	uint32_t crc32;
-} eepromData_t;
+} eepromLegacyData_t;
+
+typedef struct
+{
+	uint16_t magic;	  // SETTINGS_MAGIC
+	uint8_t version;  // SETTINGS_VERSION
+	uint8_t length;	  // Length of the data following the header
+	uint32_t crc32;	  // crc32 of the data
+} eepromHeader_t;
+
+static_assert(sizeof(eepromHeader_t) + sizeof(eepromData_t) <= EEPROM_DATA_SIZE, "EEPROM data too large");
+static_assert(offsetof(eepromLegacyData_t, crc32) == SETTINGS_LEGACY_SIZE, "Wrong size of the unversioned layout");
+static_assert(offsetof(eepromData_t, uartFlowControl) == SETTINGS_LEGACY_SIZE, "Unversioned layout must be a prefix of the data");
+static_assert(offsetof(eepromData_t, fastJoinMode) == SETTINGS_LEGACY_UART_SIZE, "Unversioned layout must be a prefix of the data");
 
 /*
  * Class for settings
+ *
+ * The settings are read from the flash on the first use and kept in RAM. The changes are written
+ * in one flash commit after SETTINGS_COMMIT_DELAY or immediately by save().
  */
 
 class Settings
 {
 public:
-	static uint32_t getUartBaudRate();
-	static SerialConfig getUartConfig();
-	static uint8_t getDhcpMode();
-	static ipConfig_t getNetConfig();
-	static ipConfig_t getApIpConfig();
-	static ipConfig_t getEthIpConfig();
-	static dnsConfig_t getDnsConfig();
-	static int getMaximumCertificates();
-
-	static void setUartBaudRate(uint32_t baudRate);
-	static void setUartConfig(SerialConfig config);
-	static void setDhcpMode(uint8_t mode);
-	static void setNetConfig(ipConfig_t netCfg);
-	static void setApIpConfig(ipConfig_t apIpCfg);
-	static void setEthIpConfig(ipConfig_t ethIpCfg);
-	static void setDnsConfig(dnsConfig_t dnsCfg);
-	static void setMaximumCertificates(int maximumCertificates);
+	static uint32_t getUartBaudRate() { return load()->uartBaudRate; }
+	static SerialConfig getUartConfig() { return (SerialConfig)(load()->uartConfig); }
+	static uint8_t getDhcpMode() { return load()->dhcpMode; }
+	static ipConfig_t getNetConfig() { return load()->netConfig; }
+	static ipConfig_t getApIpConfig() { return load()->apIpConfig; }
+	static ipConfig_t getEthIpConfig() { return load()->ethIpConfig; }
+	static dnsConfig_t getDnsConfig() { return load()->dnsConfig; }
+	static int getMaximumCertificates() { return load()->maximumCertificates; }
+	static uint8_t getUartFlowControl() { return load()->uartFlowControl; }
+	static uint16_t getUartRxBufferSize() { return load()->uartRxBufferSize; }
+	static uint8_t getFastJoinMode() { return load()->fastJoinMode; }
+	static joinCache_t getJoinCache() { return load()->joinCache; }
+	static uint8_t getEthSpiClock() { return load()->ethSpiClock; }
+	static int8_t getEthIntPin() { return load()->ethIntPin; }
+
+	static void setUartBaudRate(uint32_t baudRate) { load()->uartBaudRate = baudRate; changed(); }
+	static void setUartConfig(SerialConfig config) { load()->uartConfig = config; changed(); }
+	static void setDhcpMode(uint8_t mode) { load()->dhcpMode = mode; changed(); }
+	static void setNetConfig(ipConfig_t netCfg) { load()->netConfig = netCfg; changed(); }
+	static void setApIpConfig(ipConfig_t apIpCfg) { load()->apIpConfig = apIpCfg; changed(); }
+	static void setEthIpConfig(ipConfig_t ethIpCfg) { load()->ethIpConfig = ethIpCfg; changed(); }
+	static void setDnsConfig(dnsConfig_t dnsCfg) { load()->dnsConfig = dnsCfg; changed(); }
+	static void setMaximumCertificates(int maximumCertificates) { load()->maximumCertificates = maximumCertificates; changed(); }
+	static void setUartFlowControl(uint8_t flow) { load()->uartFlowControl = flow; changed(); }
+	static void setUartRxBufferSize(uint16_t size) { load()->uartRxBufferSize = size; changed(); }
+	static void setFastJoinMode(uint8_t mode) { load()->fastJoinMode = mode; changed(); }
+	static void setJoinCache(joinCache_t cache) { load()->joinCache = cache; changed(); }
+	static void setEthSpiClock(uint8_t clock) { load()->ethSpiClock = clock; changed(); }
+	static void setEthIntPin(int8_t pin) { load()->ethIntPin = pin; changed(); }
 
 	static void reset();
+	static void save();
+	static void process();
+	static bool isPending() { return dirty; }
 
 protected:
 	static void resetData(eepromData_t *dataPtr);
+	static void changed();
 
-protected:
-	class EEPROMData
+	static eepromData_t *load()
 	{
-	private:
-		eepromData_t data;
-
-	public:
-		EEPROMData();
-		~EEPROMData();
-
-		uint32_t getUartBaudRate() { return data.uartBaudRate; }
-		SerialConfig getUartConfig() { return (SerialConfig)(data.uartConfig); }
-		uint8_t getDhcpMode() { return data.dhcpMode; }
-		ipConfig_t getNetConfig() { return data.netConfig; }
-		ipConfig_t getApIpConfig() { return data.apIpConfig; }
-		ipConfig_t getEthIpConfig() { return data.ethIpConfig; }
-		dnsConfig_t getDnsConfig() { return data.dnsConfig; }
-		int getMaximumCertificates() { return data.maximumCertificates; }
-
-		void setUartBaudRate(uint32_t baudRate) { data.uartBaudRate = baudRate; }
-		void setUartConfig(SerialConfig config) { data.uartConfig = config; }
-		void setDhcpMode(uint8_t mode) { data.dhcpMode = mode; }
-		void setNetConfig(ipConfig_t netCfg) { data.netConfig = netCfg; }
-		void setApIpConfig(ipConfig_t apIpCfg) { data.apIpConfig = apIpCfg; }
-		void setEthIpConfig(ipConfig_t ethIpCfg) { data.ethIpConfig = ethIpCfg; }
-		void setDnsConfig(dnsConfig_t dnsCfg) { data.dnsConfig = dnsCfg; }
-		void setMaximumCertificates(int maximumCertificates) { data.maximumCertificates = maximumCertificates; }
-
-		eepromData_t *getDataPtr() { return &data; }
-	};
+		if (!loaded)
+			read();
+		return &data;
+	}
+
+	static void read();
+
+private:
+	static eepromData_t data;
+	static bool loaded;
+	static bool dirty;
+	static uint32_t changedMillis;
 };
 
 #endif /* SETTINGS_H_ */
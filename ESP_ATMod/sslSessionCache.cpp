@@ -0,0 +1,175 @@
+/*
+ * sslSessionCache.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include "sslSessionCache.h"
+#include "debug.h"
+
+/*
+ * Note: the cache keeps TLS sessions for abbreviated handshakes (session resumption).
+ *       The entries are allocated only when the cache is enabled (AT+CIPSSLSESS).
+ *       When full, the least recently used entry is replaced.
+ *       A client holds its session only during the connect, so the cache can be resized at any time.
+ */
+
+/*
+ * Variables
+ */
+
+static sslSessionCacheEntry_t *sessionCache = nullptr;
+static uint8_t sessionCacheSize = 0;
+
+/*
+ * Static functions
+ */
+
+static sslSessionCacheEntry_t *findEntry(const char *host, uint16_t port);
+
+/*
+ * Public functions
+ */
+
+/*
+ * Sets the number of cached sessions, 0 disables the cache
+ * The cached sessions are dropped. Returns false when out of memory.
+ */
+bool sslSessionCacheSetSize(uint8_t size)
+{
+	if (size > SSL_SESSION_CACHE_MAX)
+		return false;
+
+	delete[] sessionCache;
+	sessionCache = nullptr;
+	sessionCacheSize = 0;
+
+	if (size == 0)
+		return true;
+
+	sessionCache = new sslSessionCacheEntry_t[size];
+
+	if (sessionCache == nullptr)
+		return false;
+
+	sessionCacheSize = size;
+
+	for (uint8_t i = 0; i < sessionCacheSize; ++i)
+		sessionCache[i].port = 0;
+
+	return true;
+}
+
+uint8_t sslSessionCacheGetSize()
+{
+	return sessionCacheSize;
+}
+
+/*
+ * Returns the session for the host and port. If not cached, the least recently used
+ * entry is reset and assigned to the host. Returns nullptr if the cache is disabled.
+ */
+BearSSL::Session *sslSessionCacheGet(const char *host, uint16_t port)
+{
+	if (sessionCacheSize == 0)
+		return nullptr;
+
+	sslSessionCacheEntry_t *entry = findEntry(host, port);
+
+	if (entry == nullptr)
+	{
+		entry = &sessionCache[0];
+
+		for (uint8_t i = 0; i < sessionCacheSize; ++i)
+		{
+			if (sessionCache[i].port == 0)
+			{
+				entry = &sessionCache[i];
+				break;
+			}
+
+			if ((int32_t)(sessionCache[i].lastUsedMillis - entry->lastUsedMillis) < 0)
+				entry = &sessionCache[i];
+		}
+
+		entry->host = host;
+		entry->port = port;
+		entry->session = BearSSL::Session();
+
+		AT_DEBUG_PRINTF("--- new ssl session: %s:%d\r\n", host, port);
+	}
+
+	entry->lastUsedMillis = millis();
+
+	return &(entry->session);
+}
+
+/*
+ * Removes the session, e.g. after an unsuccessful connection
+ */
+void sslSessionCacheRemove(const char *host, uint16_t port)
+{
+	sslSessionCacheEntry_t *entry = findEntry(host, port);
+
+	if (entry != nullptr)
+	{
+		entry->host = "";
+		entry->port = 0;
+	}
+}
+
+/*
+ * Removes all sessions
+ */
+void sslSessionCacheClear()
+{
+	for (uint8_t i = 0; i < sessionCacheSize; ++i)
+	{
+		sessionCache[i].host = "";
+		sessionCache[i].port = 0;
+	}
+}
+
+/*
+ * Returns the used cache entry at the index or nullptr
+ */
+const sslSessionCacheEntry_t *sslSessionCacheEntry(uint8_t index)
+{
+	if (index >= sessionCacheSize || sessionCache[index].port == 0)
+		return nullptr;
+
+	return &sessionCache[index];
+}
+
+/*
+ * Static functions
+ */
+
+static sslSessionCacheEntry_t *findEntry(const char *host, uint16_t port)
+{
+	for (uint8_t i = 0; i < sessionCacheSize; ++i)
+	{
+		if (sessionCache[i].port == port && sessionCache[i].host.equalsIgnoreCase(host))
+			return &sessionCache[i];
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,57 @@
+/*
+ * sslSessionCache.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SSLSESSIONCACHE_H_
+#define SSLSESSIONCACHE_H_
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+/*
+ * Defines
+ */
+
+#define SSL_SESSION_CACHE_MAX 8
+
+/*
+ * Types
+ */
+
+typedef struct
+{
+	String host;
+	uint16_t port;
+	uint32_t lastUsedMillis;
+	BearSSL::Session session;
+} sslSessionCacheEntry_t;
+
+/*
+ * Public functions
+ */
+
+bool sslSessionCacheSetSize(uint8_t size);
+uint8_t sslSessionCacheGetSize();
+BearSSL::Session *sslSessionCacheGet(const char *host, uint16_t port);
+void sslSessionCacheRemove(const char *host, uint16_t port);
+void sslSessionCacheClear();
+const sslSessionCacheEntry_t *sslSessionCacheEntry(uint8_t index);
+
+#endif /* SSLSESSIONCACHE_H_ */
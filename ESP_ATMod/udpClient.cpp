@@ -0,0 +1,144 @@
+/*
+ * udpClient.cpp
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include "WiFiUdp.h"
+
+#include "udpClient.h"
+#include "debug.h"
+
+/*
+ * Class UdpClient
+ */
+
+UdpClient::UdpClient(uint16_t localPort, uint8_t mode) :
+	_remotePort(0), _nextPort(0), _localPort(localPort), _mode(mode), _open(false)
+{
+}
+
+int UdpClient::connect(IPAddress ip, uint16_t port)
+{
+	// Local port 0 = any free port
+	if (!_udp.begin(_localPort))
+		return 0;
+
+	_remoteIP = ip;
+	_remotePort = port;
+	_open = true;
+
+	AT_DEBUG_PRINTF("--- udp open, local port %d\r\n", _udp.localPort());
+
+	return 1;
+}
+
+/*
+ * Returns the rest of the current datagram, the next datagram is fetched when the current one is read
+ */
+int UdpClient::available()
+{
+	if (!_open)
+		return 0;
+
+	int avail = _udp.available();
+
+	if (avail == 0 && _udp.parsePacket() > 0)
+	{
+		avail = _udp.available();
+
+		// Follow the sender
+		if (_mode != 0)
+		{
+			_remoteIP = _udp.remoteIP();
+			_remotePort = _udp.remotePort();
+
+			if (_mode == 1)
+				_mode = 0; // Changed once
+		}
+	}
+
+	return avail;
+}
+
+int UdpClient::read()
+{
+	if (available() == 0)
+		return -1;
+
+	return _udp.read();
+}
+
+int UdpClient::read(uint8_t *buf, size_t size)
+{
+	if (available() == 0)
+		return 0;
+
+	return _udp.read(buf, size);
+}
+
+int UdpClient::peek()
+{
+	if (available() == 0)
+		return -1;
+
+	return _udp.peek();
+}
+
+/*
+ * Sends the data in one datagram
+ */
+size_t UdpClient::write(const uint8_t *buf, size_t size)
+{
+	IPAddress ip = _remoteIP;
+	uint16_t port = _remotePort;
+
+	if (_nextPort != 0)
+	{
+		ip = _nextIP;
+		port = _nextPort;
+		_nextPort = 0;
+	}
+
+	if (!_open || (uint32_t)ip == 0 || port == 0)
+		return 0;
+
+	if (!_udp.beginPacket(ip, port))
+		return 0;
+
+	size_t written = _udp.write(buf, size);
+
+	if (!_udp.endPacket())
+		return 0;
+
+	return written;
+}
+
+void UdpClient::stop()
+{
+	_udp.stop();
+	_open = false;
+}
+
+void UdpClient::setNextDestination(IPAddress ip, uint16_t port)
+{
+	_nextIP = ip;
+	_nextPort = port;
+}
@@ -0,0 +1,80 @@
+/*
+ * udpClient.h
+ *
+ * Part of ESP_ATMod: modified AT command processor for ESP8266
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UDPCLIENT_H_
+#define UDPCLIENT_H_
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include "WiFiUdp.h"
+
+/*
+ * UDP link (AT+CIPSTART="UDP") with the WiFiClient interface, so it can be kept in clients[]
+ * The datagrams are read one by one, available() returns the rest of the current datagram.
+ * Each write() sends one datagram.
+ */
+
+class UdpClient : public WiFiClient
+{
+public:
+	/*
+	 * Mode (AT+CIPSTART <UDP mode>): 0 = the remote host is fixed, 1 = the remote host changes
+	 * once to the sender of the first datagram, 2 = the remote host changes with every datagram
+	 */
+	UdpClient(uint16_t localPort, uint8_t mode);
+
+	// Opens the link, the remote IP 0.0.0.0 makes a listen-only link
+	int connect(IPAddress ip, uint16_t port) override;
+
+	uint8_t connected() override { return _open; }
+	int available() override;
+	int read() override;
+	int read(uint8_t *buf, size_t size) override;
+	int peek() override;
+	size_t write(uint8_t b) override { return write(&b, 1); }
+	size_t write(const uint8_t *buf, size_t size) override;
+	int availableForWrite() override { return _open ? 2048 : 0; }
+	void flush() override {}
+	void stop() override;
+
+	// Destination of the next datagram only (AT+CIPSEND with the remote host)
+	void setNextDestination(IPAddress ip, uint16_t port);
+
+	IPAddress udpRemoteIP() { return _remoteIP; }
+	uint16_t udpRemotePort() { return _remotePort; }
+	uint16_t udpLocalPort() { return _udp.localPort(); }
+
+	// Sender of the current datagram (+IPD with AT+CIPDINFO=1)
+	IPAddress packetRemoteIP() { return _udp.remoteIP(); }
+	uint16_t packetRemotePort() { return _udp.remotePort(); }
+
+private:
+	WiFiUDP _udp;
+	IPAddress _remoteIP;
+	uint16_t _remotePort;
+	IPAddress _nextIP;
+	uint16_t _nextPort;
+	uint16_t _localPort;
+	uint8_t _mode;
+	bool _open;
+};
+
+#endif /* UDPCLIENT_H_ */
@@ -0,0 +1,359 @@
+/*
+ * Arduino.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ARDUINO_H_
+#define FAKE_ARDUINO_H_
+
+/*
+ * Note: a minimal subset of the ESP8266 Arduino core for the native build (env:native).
+ *       Only what the firmware uses is declared, the behaviour is implemented in fakes.cpp.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+#include <functional>
+#include <string>
+#include <deque>
+
+/*
+ * Defines
+ */
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(p) (p)
+#define __STR(x) #x
+#define ARDUINO_ESP8266_GIT_VER 0
+
+#define memcmp_P memcmp
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strcmp_P strcmp
+#define strlen_P strlen
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+
+#define F_CPU 80000000L
+
+#define _min(a, b) ((a) < (b) ? (a) : (b))
+#define _max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+
+template <typename T> const T &min(const T &a, const T &b) { return a < b ? a : b; }
+template <typename T> const T &max(const T &a, const T &b) { return a > b ? a : b; }
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+/*
+ * UART registers (flow control)
+ */
+
+#define UART0 0
+#define UART1 1
+#define UCBN 2
+#define UCSBN 4
+#define UCTXHFE 15
+#define UCRXHFE 23
+#define UCRXHFT 16
+#define UCRXHFCEN 23
+#define UCTXHFCEN 15
+#define PERIPHS_IO_MUX_MTDO_U 0
+#define PERIPHS_IO_MUX_MTCK_U 1
+#define FUNC_U0RTS 4
+#define FUNC_U0CTS 4
+#define FUNC_GPIO13 3
+#define FUNC_GPIO15 3
+
+extern volatile uint32_t fakeUartRegisters[2][2];
+#define USC0(u) fakeUartRegisters[u][0]
+#define USC1(u) fakeUartRegisters[u][1]
+
+inline void PIN_FUNC_SELECT(int, int) {}
+
+/*
+ * Time and GPIO
+ */
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+uint32_t crc32(const void *data, size_t length, uint32_t crc = 0xffffffff);
+void configTime(int timezone, int daylightOffset, const char *server1, const char *server2, const char *server3);
+void enableWiFiAtBootTime();
+
+// Not in every host C library
+inline size_t fakeStrlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size > 0)
+	{
+		size_t n = len < size - 1 ? len : size - 1;
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+
+	return len;
+}
+#define strlcpy fakeStrlcpy
+
+inline bool isAlpha(int c) { return isalpha(c); }
+inline bool isAlphaNumeric(int c) { return isalnum(c); }
+
+/*
+ * String
+ */
+
+class __FlashStringHelper;
+
+class String
+{
+public:
+	String() {}
+	String(const char *s) : _s(s != nullptr ? s : "") {}
+	String(const std::string &s) : _s(s) {}
+	String(char c) : _s(1, c) {}
+	String(int v) : _s(std::to_string(v)) {}
+	String(unsigned int v) : _s(std::to_string(v)) {}
+	String(long v) : _s(std::to_string(v)) {}
+	String(unsigned long v) : _s(std::to_string(v)) {}
+
+	const char *c_str() const { return _s.c_str(); }
+	unsigned int length() const { return _s.length(); }
+	bool isEmpty() const { return _s.empty(); }
+	void reserve(unsigned int size) { _s.reserve(size); }
+	bool concat(const char *s, unsigned int len) { _s.append(s, len); return true; }
+
+	String &operator+=(const String &s) { _s += s._s; return *this; }
+	String &operator+=(const char *s) { _s += s; return *this; }
+	String &operator+=(char c) { _s += c; return *this; }
+	String &operator+=(int v) { _s += std::to_string(v); return *this; }
+	String &operator+=(unsigned int v) { _s += std::to_string(v); return *this; }
+	String &operator+=(long v) { _s += std::to_string(v); return *this; }
+	String &operator+=(unsigned long v) { _s += std::to_string(v); return *this; }
+	friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+
+	char operator[](unsigned int i) const { return i < _s.length() ? _s[i] : 0; }
+	bool operator==(const String &s) const { return _s == s._s; }
+	bool operator!=(const String &s) const { return _s != s._s; }
+	bool equals(const String &s) const { return _s == s._s; }
+	bool equalsIgnoreCase(const String &s) const { return strcasecmp(c_str(), s.c_str()) == 0; }
+	bool startsWith(const String &s) const { return _s.compare(0, s._s.length(), s._s) == 0; }
+	bool endsWith(const String &s) const;
+
+	int indexOf(char c) const;
+	int lastIndexOf(char c) const;
+	String substring(unsigned int from, unsigned int to) const;
+	void remove(unsigned int index) { if (index < _s.length()) _s.erase(index); }
+	void toLowerCase();
+
+private:
+	std::string _s;
+};
+
+/*
+ * Print and Stream
+ */
+
+class Printable;
+
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *s) { return s == nullptr ? 0 : write((const uint8_t *)s, strlen(s)); }
+	size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+	virtual int availableForWrite() { return 0; }
+	virtual void flush() {}
+
+	size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+	size_t printf_P(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+	size_t print(const char *s) { return write(s); }
+	size_t print(const String &s) { return write(s.c_str()); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(int v, int base = 10) { return print((long)v, base); }
+	size_t print(unsigned int v, int base = 10) { return print((unsigned long)v, base); }
+	size_t print(long v, int base = 10);
+	size_t print(unsigned long v, int base = 10);
+	size_t print(double v, int digits = 2);
+	size_t print(const Printable &p);
+
+	size_t println() { return write("\r\n"); }
+	template <typename T> size_t println(const T &v) { size_t n = print(v); return n + println(); }
+};
+
+class Printable
+{
+public:
+	virtual ~Printable() {}
+	virtual size_t printTo(Print &p) const = 0;
+};
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	virtual int read(uint8_t *buffer, size_t size);
+
+	size_t readBytes(uint8_t *buffer, size_t length);
+	size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+	void setTimeout(unsigned long timeout) { _timeout = timeout; }
+	unsigned long getTimeout() const { return _timeout; }
+
+protected:
+	unsigned long _timeout = 1000;
+};
+
+/*
+ * HardwareSerial: the input is queued by the test, the output is collected in a string
+ */
+
+enum SerialConfig
+{
+	SERIAL_8N1 = 0x1c
+};
+
+enum SerialMode
+{
+	SERIAL_FULL,
+	SERIAL_RX_ONLY,
+	SERIAL_TX_ONLY
+};
+
+class HardwareSerial : public Stream
+{
+public:
+	HardwareSerial(int uart) : _uart(uart) {}
+
+	void begin(unsigned long baud) { _baud = baud; }
+	void begin(unsigned long baud, SerialConfig, SerialMode = SERIAL_FULL, uint8_t = 1, bool = false) { _baud = baud; }
+	void end() {}
+	unsigned long baudRate() { return _baud; }
+	size_t setRxBufferSize(size_t size) { _rxBufferSize = size; return size; }
+	size_t getRxBufferSize() { return _rxBufferSize; }
+	void swap() {}
+	void swap(uint8_t) {}
+	void setDebugOutput(bool) {}
+	bool hasOverrun() { return false; }
+	bool hasRxError() { return false; }
+	operator bool() const { return true; }
+
+	int available() override { return _rx.size(); }
+	int read() override;
+	int read(uint8_t *buffer, size_t size) override;
+	int peek() override { return _rx.empty() ? -1 : _rx.front(); }
+
+	size_t write(uint8_t c) override { _tx += (char)c; return 1; }
+	size_t write(const uint8_t *buffer, size_t size) override { _tx.append((const char *)buffer, size); return size; }
+	using Print::write;
+	int availableForWrite() override { return fifoFree; } // The UART FIFO, the fake sends at once
+	void flush() override {}
+
+	// Test interface
+	void inject(const char *data, size_t size) { _rx.insert(_rx.end(), data, data + size); }
+	void inject(const char *data) { inject(data, strlen(data)); }
+	std::string &output() { return _tx; }
+	int fifoFree = 128; // 0 models a busy UART
+
+private:
+	int _uart;
+	unsigned long _baud = 115200;
+	size_t _rxBufferSize = 256;
+	std::deque<uint8_t> _rx;
+	std::string _tx;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+/*
+ * EspClass
+ */
+
+class EspClass
+{
+public:
+	uint32_t getFreeHeap();
+	uint32_t getMaxFreeBlockSize();
+	uint8_t getHeapFragmentation() { return 0; }
+	void getHeapStats(uint32_t *hfree, uint32_t *hmax, uint8_t *hfrag);
+	uint32_t getFreeContStack() { return 4096; }
+	uint32_t getCycleCount();
+	uint8_t getCpuFreqMHz();
+	void reset();
+	void restart() { reset(); }
+	bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+	bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+};
+
+extern EspClass ESP;
+
+/*
+ * Test interface
+ */
+
+extern uint32_t fakeAllocations; // Calls of operator new
+extern uint32_t fakeResets;		 // Calls of ESP.reset()
+
+#endif /* FAKE_ARDUINO_H_ */
@@ -0,0 +1,37 @@
+/*
+ * CertStoreBearSSL.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_CERTSTOREBEARSSL_H_
+#define FAKE_CERTSTOREBEARSSL_H_
+
+#include "ESP8266WiFi.h"
+#include "LittleFS.h"
+
+namespace BearSSL
+{
+	class CertStore : public CertStoreBase
+	{
+	public:
+		int initCertStore(FS &, const char *, const char *) { return 0; }
+	};
+} // namespace BearSSL
+
+#endif /* FAKE_CERTSTOREBEARSSL_H_ */
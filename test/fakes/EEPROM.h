@@ -0,0 +1,70 @@
+/*
+ * EEPROM.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_EEPROM_H_
+#define FAKE_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * The emulated flash sector keeps its content for the whole test run, erased it is 0xFF
+ */
+
+class EEPROMClass
+{
+public:
+	void begin(size_t size);
+	bool end() { return commit(); }
+	bool commit() { ++_commits; return true; }
+
+	template <typename T> T &get(int address, T &t)
+	{
+		memcpy((void *)&t, _data + address, sizeof(T));
+		return t;
+	}
+
+	template <typename T> const T &put(int address, const T &t)
+	{
+		memcpy(_data + address, (const void *)&t, sizeof(T));
+		return t;
+	}
+
+	uint8_t read(int address) { return _data[address]; }
+	void write(int address, uint8_t value) { _data[address] = value; }
+	const uint8_t *getConstDataPtr() const { return _data; }
+	uint8_t *getDataPtr() { return _data; }
+	size_t length() { return _size; }
+
+	// Test interface
+	void erase() { memset(_data, 0xFF, sizeof(_data)); }
+	uint32_t commits() const { return _commits; }
+
+private:
+	uint8_t _data[4096];
+	size_t _size = 0;
+	uint32_t _commits = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif /* FAKE_EEPROM_H_ */
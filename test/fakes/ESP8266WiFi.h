@@ -0,0 +1,463 @@
+/*
+ * ESP8266WiFi.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_ESP8266WIFI_H_
+#define FAKE_ESP8266WIFI_H_
+
+#include <memory>
+#include <vector>
+
+#include "Arduino.h"
+#include "user_interface.h"
+#include "lwip/dns.h"
+
+/*
+ * Note: the station is always connected, the links are connected to in-memory peers.
+ *       The test reaches the peers through fakeNet (see the end of the file).
+ */
+
+/*
+ * IPAddress
+ */
+
+class IPAddress : public Printable
+{
+public:
+	IPAddress() : _addr(0) {}
+	IPAddress(uint32_t addr) : _addr(addr) {}
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+
+	operator uint32_t() const { return _addr; }
+	operator const ip_addr_t *() const { return (const ip_addr_t *)&_addr; }
+	uint8_t operator[](int i) const { return (_addr >> (8 * i)) & 0xFF; }
+	bool operator==(const IPAddress &ip) const { return _addr == ip._addr; }
+	bool operator!=(const IPAddress &ip) const { return _addr != ip._addr; }
+	bool operator==(uint32_t addr) const { return _addr == addr; }
+
+	bool isSet() const { return _addr != 0; }
+	uint32_t v4() const { return _addr; }
+	bool fromString(const char *address);
+	static bool isValid(const char *address);
+	String toString() const;
+	size_t printTo(Print &p) const override { return p.print(toString()); }
+
+private:
+	uint32_t _addr;
+};
+
+extern const IPAddress INADDR_ANY_;
+#define IPADDR_ANY 0
+
+/*
+ * Enums and events
+ */
+
+typedef enum
+{
+	WIFI_OFF = 0,
+	WIFI_STA = 1,
+	WIFI_AP = 2,
+	WIFI_AP_STA = 3
+} WiFiMode_t;
+typedef WiFiMode_t WiFiMode;
+
+typedef enum
+{
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL,
+	WL_SCAN_COMPLETED,
+	WL_CONNECTED,
+	WL_CONNECT_FAILED,
+	WL_CONNECTION_LOST,
+	WL_WRONG_PASSWORD,
+	WL_DISCONNECTED
+} wl_status_t;
+
+enum tcp_state
+{
+	CLOSED = 0,
+	LISTEN,
+	SYN_SENT,
+	SYN_RCVD,
+	ESTABLISHED
+};
+
+struct WiFiEventStationModeConnected
+{
+	String ssid;
+	uint8_t bssid[6];
+	uint8_t channel;
+};
+
+struct WiFiEventStationModeGotIP
+{
+	IPAddress ip, mask, gw;
+};
+
+struct WiFiEventStationModeDisconnected
+{
+	String ssid;
+	uint8_t bssid[6];
+	int reason;
+};
+
+typedef void *WiFiEventHandler;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+/*
+ * In-memory connection shared by the copies of a WiFiClient, like the ClientContext of the core
+ */
+
+struct FakeConnection
+{
+	std::deque<uint8_t> rx; // From the peer to the firmware
+	std::string tx;			// From the firmware to the peer
+	bool open = true;
+	uint16_t window = 2920; // Free space of the TCP send buffer
+	IPAddress remoteIP;
+	uint16_t remotePort = 0;
+	uint16_t localPort = 0;
+};
+
+/*
+ * WiFiClient
+ */
+
+class WiFiClient : public Stream
+{
+public:
+	WiFiClient() {}
+	WiFiClient(std::shared_ptr<FakeConnection> connection) : _connection(connection) {}
+	virtual ~WiFiClient() {}
+
+	virtual int connect(IPAddress ip, uint16_t port);
+	virtual int connect(const char *host, uint16_t port);
+	virtual int connect(const String &host, uint16_t port) { return connect(host.c_str(), port); }
+
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+	int available() override;
+	int read() override;
+	int read(uint8_t *buffer, size_t size) override;
+	int peek() override;
+	virtual size_t peekBytes(uint8_t *buffer, size_t size);
+	void flush() override {}
+	int availableForWrite() override { return connected() ? _connection->window : 0; }
+
+	virtual void stop();
+	virtual bool stop(unsigned int) { stop(); return true; }
+	virtual uint8_t connected();
+	virtual uint8_t status() { return connected() ? ESTABLISHED : CLOSED; }
+	operator bool() { return connected(); }
+
+	IPAddress remoteIP() { return _connection ? _connection->remoteIP : IPAddress(); }
+	uint16_t remotePort() { return _connection ? _connection->remotePort : 0; }
+	IPAddress localIP();
+	uint16_t localPort() { return _connection ? _connection->localPort : 0; }
+
+	void setNoDelay(bool noDelay) { _noDelay = noDelay; }
+	bool getNoDelay() const { return _noDelay; }
+	void setSync(bool sync) { _sync = sync; }
+	bool getSync() const { return _sync; }
+	void keepAlive(uint16_t idle_sec = 7200, uint16_t intv_sec = 75, uint8_t count = 9)
+	{
+		_keepAliveIdle = idle_sec;
+		_keepAliveInterval = intv_sec;
+		_keepAliveCount = count;
+	}
+	bool isKeepAliveEnabled() const { return _keepAliveIdle != 0; }
+	uint16_t getKeepAliveIdle() const { return _keepAliveIdle; }
+	uint16_t getKeepAliveInterval() const { return _keepAliveInterval; }
+	uint8_t getKeepAliveCount() const { return _keepAliveCount; }
+	void disableKeepAlive() { _keepAliveIdle = 0; }
+
+	virtual bool hasPeekBufferAPI() const { return false; }
+	virtual size_t peekAvailable() { return 0; }
+	virtual const char *peekBuffer() { return nullptr; }
+	virtual void peekConsume(size_t) {}
+
+	static void setDefaultNoDelay(bool) {}
+	static void setDefaultSync(bool) {}
+
+protected:
+	std::shared_ptr<FakeConnection> _connection;
+	bool _noDelay = false;
+	bool _sync = false;
+	uint16_t _keepAliveIdle = 0;
+	uint16_t _keepAliveInterval = 0;
+	uint8_t _keepAliveCount = 0;
+};
+
+/*
+ * WiFiServer
+ */
+
+class WiFiServer
+{
+public:
+	WiFiServer(uint16_t port) : _port(port) {}
+
+	void begin() { _listening = true; }
+	void begin(uint16_t port) { _port = port; _listening = true; }
+	void begin(uint16_t port, uint8_t) { begin(port); }
+	void close() { _listening = false; }
+	void stop() { close(); }
+	uint8_t status() { return _listening ? LISTEN : CLOSED; }
+	uint16_t port() const { return _port; }
+	bool hasClient();
+	WiFiClient accept();
+	WiFiClient available(uint8_t * = nullptr) { return accept(); }
+	void setNoDelay(bool) {}
+
+private:
+	uint16_t _port;
+	bool _listening = false;
+};
+
+/*
+ * WiFiUDP
+ */
+
+class WiFiUDP : public Stream
+{
+public:
+	uint8_t begin(uint16_t port);
+	void stop();
+	int beginPacket(IPAddress ip, uint16_t port);
+	int beginPacket(const char *host, uint16_t port);
+	int endPacket();
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+	int parsePacket();
+	int available() override;
+	int read() override;
+	int read(uint8_t *buffer, size_t size) override;
+	int read(char *buffer, size_t size) { return read((uint8_t *)buffer, size); }
+	int peek() override;
+	void flush() override {}
+	IPAddress remoteIP() { return _packetIP; }
+	uint16_t remotePort() { return _packetPort; }
+	IPAddress destinationIP() const { return IPAddress(); }
+	uint16_t localPort() const { return _port; }
+	operator bool() const { return _port != 0; }
+
+private:
+	uint16_t _port = 0;
+	std::string _packet;
+	size_t _packetPos = 0;
+	IPAddress _packetIP;
+	uint16_t _packetPort = 0;
+	std::string _out;
+	IPAddress _outIP;
+	uint16_t _outPort = 0;
+};
+
+/*
+ * ESP8266WiFiClass
+ */
+
+typedef std::function<void(int)> ScanCb;
+
+class ESP8266WiFiClass
+{
+public:
+	WiFiMode_t getMode() { return _mode; }
+	bool mode(WiFiMode_t m) { _mode = m; return true; }
+	wl_status_t status() { return WL_CONNECTED; }
+	bool isConnected() { return true; }
+	void persistent(bool) {}
+	bool setAutoReconnect(bool) { return true; }
+	bool getAutoConnect() { return _autoConnect; }
+	bool setAutoConnect(bool autoConnect) { _autoConnect = autoConnect; return true; }
+	bool disconnect(bool = false) { return true; }
+
+	wl_status_t begin(const char *, const char * = nullptr, int32_t = 0, const uint8_t * = nullptr, bool = true) { return WL_CONNECTED; }
+	wl_status_t begin(const String &ssid, const String &pwd = String(), int32_t ch = 0, const uint8_t *bssid = nullptr, bool connect = true)
+	{
+		return begin(ssid.c_str(), pwd.c_str(), ch, bssid, connect);
+	}
+	wl_status_t begin() { return WL_CONNECTED; }
+
+	bool config(IPAddress, IPAddress, IPAddress, IPAddress = (uint32_t)0, IPAddress = (uint32_t)0) { return true; }
+	IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+	IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+	IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+	IPAddress dnsIP(uint8_t = 0) { return IPAddress(192, 168, 1, 1); }
+	String macAddress() { return "5c:cf:7f:00:00:01"; }
+	String softAPmacAddress() { return "5e:cf:7f:00:00:01"; }
+	uint8_t *BSSID() { return _bssid; }
+	String BSSIDstr() { return "00:11:22:33:44:55"; }
+	int32_t channel() { return 6; }
+	int32_t RSSI() { return -50; }
+	String SSID() const { return "fake"; }
+	String psk() const { return ""; }
+
+	int hostByName(const char *host, IPAddress &ip);
+	int hostByName(const char *host, IPAddress &ip, uint32_t) { return hostByName(host, ip); }
+	String hostname() { return _hostname; }
+	bool hostname(const String &name) { _hostname = name; return true; }
+	bool hostname(const char *name) { _hostname = name; return true; }
+
+	void scanNetworksAsync(ScanCb cb, bool = false) { cb(0); }
+	int8_t scanNetworks(bool = false, bool = false, uint8_t = 0, uint8_t * = nullptr) { return 0; }
+	int8_t scanComplete() { return 0; }
+	void scanDelete() {}
+	uint8_t encryptionType(uint8_t) { return 0; }
+	int32_t RSSI(uint8_t) { return 0; }
+	String SSID(uint8_t) { return ""; }
+	uint8_t *BSSID(uint8_t) { return _bssid; }
+	String BSSIDstr(uint8_t) { return ""; }
+	int32_t channel(uint8_t) { return 0; }
+	bool isHidden(uint8_t) { return false; }
+
+	bool softAP(const char *, const char * = nullptr, int = 1, int = 0, int = 4) { return true; }
+	bool softAPConfig(IPAddress, IPAddress, IPAddress) { return true; }
+
+	WiFiEventHandler onStationModeConnected(void (*)(const WiFiEventStationModeConnected &)) { return nullptr; }
+	WiFiEventHandler onStationModeGotIP(void (*)(const WiFiEventStationModeGotIP &)) { return nullptr; }
+	WiFiEventHandler onStationModeDisconnected(void (*)(const WiFiEventStationModeDisconnected &)) { return nullptr; }
+
+private:
+	WiFiMode_t _mode = WIFI_STA;
+	bool _autoConnect = true;
+	String _hostname = "esp-fake";
+	uint8_t _bssid[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+};
+
+extern ESP8266WiFiClass WiFi;
+
+/*
+ * BearSSL: the TLS links behave like plain TCP links
+ */
+
+typedef struct
+{
+	unsigned char session_id[32];
+	unsigned char session_id_len;
+	uint16_t version;
+	uint16_t cipher_suite;
+	unsigned char master_secret[48];
+} br_ssl_session_parameters;
+
+namespace BearSSL
+{
+	struct br_x509_certificate_
+	{
+		unsigned char *data;
+		size_t data_len;
+	};
+
+	class X509List
+	{
+	public:
+		X509List() {}
+		X509List(const char *) { _count = 1; }
+		X509List(const uint8_t *, size_t) { _count = 1; }
+		bool append(const char *) { ++_count; return true; }
+		bool append(const uint8_t *, size_t) { ++_count; return true; }
+		size_t getCount() const { return _count; }
+		const br_x509_certificate_ *getX509Certs() const { return nullptr; }
+		const void *getTrustAnchors() const { return nullptr; }
+
+	private:
+		size_t _count = 0;
+	};
+
+	class Session
+	{
+	public:
+		Session() { memset(&_session, 0, sizeof(_session)); }
+		br_ssl_session_parameters *getSession() { return &_session; }
+
+	private:
+		br_ssl_session_parameters _session;
+	};
+
+	class CertStoreBase
+	{
+	public:
+		virtual ~CertStoreBase() {}
+	};
+
+	class WiFiClientSecure : public WiFiClient
+	{
+	public:
+		int connect(IPAddress ip, uint16_t port) override { return WiFiClient::connect(ip, port); }
+		int connect(const char *host, uint16_t port) override { return WiFiClient::connect(host, port); }
+		int connect(const String &host, uint16_t port) override { return WiFiClient::connect(host, port); }
+
+		void setBufferSizes(int, int) {}
+		void setInsecure() {}
+		bool setFingerprint(const uint8_t *) { return true; }
+		bool setFingerprint(const char *) { return true; }
+		void setTrustAnchors(const X509List *) {}
+		void setSession(Session *session) { _session = session; }
+		void setCertStore(CertStoreBase *) {}
+		void setX509Time(time_t) {}
+		void setSSLVersion(uint32_t, uint32_t) {}
+		bool getMFLNStatus() { return true; }
+		int getLastSSLError(char *dest = nullptr, size_t len = 0)
+		{
+			if (dest != nullptr && len > 0)
+				dest[0] = '\0';
+			return 0;
+		}
+
+		static bool probeMaxFragmentLength(IPAddress, uint16_t, uint16_t) { return true; }
+		static bool probeMaxFragmentLength(const char *, uint16_t, uint16_t) { return true; }
+		static bool probeMaxFragmentLength(const String &, uint16_t, uint16_t) { return true; }
+
+	private:
+		Session *_session = nullptr;
+	};
+} // namespace BearSSL
+
+typedef struct BearSSL::br_x509_certificate_ br_x509_certificate;
+using BearSSL::WiFiClientSecure;
+
+void dhcp_stop(struct netif *netif);
+
+/*
+ * Test interface of the fake network
+ */
+
+namespace fakeNet
+{
+	// Connections made by WiFiClient::connect(), the newest last
+	extern std::vector<std::shared_ptr<FakeConnection>> outgoing;
+
+	// Queues an incoming connection for the server on the port, returns the connection
+	std::shared_ptr<FakeConnection> accept(uint16_t port, IPAddress remoteIP, uint16_t remotePort);
+
+	// Queues a datagram for the UDP socket on the port
+	void datagram(uint16_t port, IPAddress remoteIP, uint16_t remotePort, const std::string &data);
+
+	// Datagrams sent by the firmware
+	extern std::vector<std::string> sentDatagrams;
+
+	void reset();
+} // namespace fakeNet
+
+#endif /* FAKE_ESP8266WIFI_H_ */
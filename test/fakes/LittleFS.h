@@ -0,0 +1,73 @@
+/*
+ * LittleFS.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_LITTLEFS_H_
+#define FAKE_LITTLEFS_H_
+
+#include "Arduino.h"
+
+/*
+ * The file system is empty and read-only
+ */
+
+class File : public Stream
+{
+public:
+	operator bool() const { return false; }
+	void close() {}
+	int available() override { return 0; }
+	int read() override { return -1; }
+	using Stream::read;
+	int peek() override { return -1; }
+	size_t write(uint8_t) override { return 0; }
+	using Print::write;
+	size_t size() const { return 0; }
+	size_t position() const { return 0; }
+	bool seek(uint32_t) { return false; }
+	const char *name() const { return ""; }
+};
+
+class Dir
+{
+public:
+	bool next() { return false; }
+	String fileName() { return String(); }
+	size_t fileSize() { return 0; }
+	File openFile(const char *) { return File(); }
+};
+
+class FS
+{
+public:
+	bool begin() { return true; }
+	File open(const char *, const char *) { return File(); }
+	File open(const String &, const char *) { return File(); }
+	Dir openDir(const char *) { return Dir(); }
+	bool remove(const char *) { return false; }
+	bool remove(const String &) { return false; }
+	bool exists(const char *) { return false; }
+	bool exists(const String &) { return false; }
+	bool rename(const char *, const char *) { return false; }
+};
+
+extern FS LittleFS;
+
+#endif /* FAKE_LITTLEFS_H_ */
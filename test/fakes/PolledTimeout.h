@@ -0,0 +1,60 @@
+/*
+ * PolledTimeout.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_POLLEDTIMEOUT_H_
+#define FAKE_POLLEDTIMEOUT_H_
+
+#include "Arduino.h"
+
+namespace esp8266
+{
+	namespace polledTimeout
+	{
+		class oneShot
+		{
+		public:
+			oneShot(unsigned long timeout) : _timeout(timeout), _start(millis()) {}
+			operator bool() { return expired(); }
+			bool expired() { return millis() - _start >= _timeout; }
+			void reset() { _start = millis(); }
+			void reset(unsigned long timeout) { _timeout = timeout; reset(); }
+
+		protected:
+			unsigned long _timeout;
+			unsigned long _start;
+		};
+
+		class periodicMs : public oneShot
+		{
+		public:
+			periodicMs(unsigned long timeout) : oneShot(timeout) {}
+			operator bool()
+			{
+				if (!expired())
+					return false;
+				reset();
+				return true;
+			}
+		};
+	} // namespace polledTimeout
+} // namespace esp8266
+
+#endif /* FAKE_POLLEDTIMEOUT_H_ */
@@ -0,0 +1,39 @@
+/*
+ * bearssl.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_BEARSSL_BEARSSL_H_
+#define FAKE_BEARSSL_BEARSSL_H_
+
+#include "bearssl_hash.h"
+
+#define BR_ERR_TOO_LARGE 18 // The record is larger than the input buffer
+
+typedef struct
+{
+	unsigned char opaque[3600];
+} br_ssl_client_context;
+
+typedef struct
+{
+	unsigned char opaque[700];
+} br_x509_minimal_context;
+
+#endif /* FAKE_BEARSSL_BEARSSL_H_ */
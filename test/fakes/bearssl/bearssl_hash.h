@@ -0,0 +1,41 @@
+/*
+ * bearssl_hash.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_BEARSSL_BEARSSL_HASH_H_
+#define FAKE_BEARSSL_BEARSSL_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+	unsigned char buf[64];
+	uint64_t count;
+	uint32_t val[8];
+} br_sha256_context;
+
+#define br_sha256_SIZE 32
+
+void br_sha256_init(br_sha256_context *ctx);
+void br_sha256_update(br_sha256_context *ctx, const void *data, size_t len);
+void br_sha256_out(const br_sha256_context *ctx, void *out);
+
+#endif /* FAKE_BEARSSL_BEARSSL_HASH_H_ */
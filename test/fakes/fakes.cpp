@@ -0,0 +1,966 @@
+/*
+ * fakes.cpp
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <map>
+#include <new>
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include "EEPROM.h"
+#include "LittleFS.h"
+#include "sntp.h"
+#include "bearssl/bearssl_hash.h"
+
+/*
+ * Note: the time runs with the host clock, delay() only moves the clock forward.
+ *       operator new is counted for the allocations per operation of the benchmarks.
+ */
+
+/*
+ * Variables
+ */
+
+HardwareSerial Serial(UART0);
+HardwareSerial Serial1(UART1);
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+EEPROMClass EEPROM;
+FS LittleFS;
+const IPAddress INADDR_ANY_;
+
+volatile uint32_t fakeUartRegisters[2][2];
+
+uint32_t fakeAllocations = 0;
+uint32_t fakeResets = 0;
+
+static uint64_t delayOffsetUs = 0;
+
+namespace fakeNet
+{
+	std::vector<std::shared_ptr<FakeConnection>> outgoing;
+	std::vector<std::string> sentDatagrams;
+
+	static std::map<uint16_t, std::deque<std::shared_ptr<FakeConnection>>> pendingAccepts;
+
+	struct Datagram
+	{
+		IPAddress remoteIP;
+		uint16_t remotePort;
+		std::string data;
+	};
+
+	static std::map<uint16_t, std::deque<Datagram>> pendingDatagrams;
+} // namespace fakeNet
+
+/*
+ * Allocation counter
+ */
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // The replaced operators pair malloc() and free()
+
+void *operator new(size_t size)
+{
+	++fakeAllocations;
+
+	void *p = malloc(size > 0 ? size : 1);
+
+	if (p == nullptr)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+/*
+ * Time and GPIO
+ */
+
+unsigned long micros()
+{
+	static const auto start = std::chrono::steady_clock::now();
+
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	return (unsigned long)(us + delayOffsetUs);
+}
+
+unsigned long millis()
+{
+	return micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+	delayOffsetUs += (uint64_t)ms * 1000;
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+int digitalRead(uint8_t)
+{
+	return HIGH;
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
+
+void attachInterrupt(uint8_t, void (*)(), int)
+{
+}
+
+void detachInterrupt(uint8_t)
+{
+}
+
+void configTime(int, int, const char *, const char *, const char *)
+{
+}
+
+void enableWiFiAtBootTime()
+{
+}
+
+/*
+ * CRC-32 (the polynomial of the core, without the final inversion)
+ */
+uint32_t crc32(const void *data, size_t length, uint32_t crc)
+{
+	const uint8_t *p = (const uint8_t *)data;
+
+	while (length--)
+	{
+		crc ^= *p++;
+
+		for (uint8_t i = 0; i < 8; ++i)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+	}
+
+	return crc;
+}
+
+/*
+ * String
+ */
+
+bool String::endsWith(const String &s) const
+{
+	return _s.length() >= s._s.length() && _s.compare(_s.length() - s._s.length(), s._s.length(), s._s) == 0;
+}
+
+int String::indexOf(char c) const
+{
+	size_t pos = _s.find(c);
+
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const
+{
+	size_t pos = _s.rfind(c);
+
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+	if (from > _s.length())
+		return String();
+
+	return String(_s.substr(from, to > from ? to - from : 0));
+}
+
+void String::toLowerCase()
+{
+	for (char &c : _s)
+		c = tolower(c);
+}
+
+/*
+ * Print and Stream
+ */
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+
+	while (size--)
+		n += write(*buffer++);
+
+	return n;
+}
+
+static size_t printfTo(Print &p, const char *format, va_list args)
+{
+	char buffer[256];
+	va_list copy;
+
+	va_copy(copy, args);
+	int len = vsnprintf(buffer, sizeof(buffer), format, copy);
+	va_end(copy);
+
+	if (len < 0)
+		return 0;
+
+	if ((size_t)len < sizeof(buffer))
+		return p.write((const uint8_t *)buffer, len);
+
+	std::string large(len + 1, '\0');
+	vsnprintf(&large[0], len + 1, format, args);
+
+	return p.write((const uint8_t *)large.data(), len);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	size_t n = printfTo(*this, format, args);
+	va_end(args);
+
+	return n;
+}
+
+size_t Print::printf_P(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	size_t n = printfTo(*this, format, args);
+	va_end(args);
+
+	return n;
+}
+
+size_t Print::print(long v, int base)
+{
+	char buffer[34];
+
+	if (base == 16)
+		snprintf(buffer, sizeof(buffer), "%lx", v);
+	else
+		snprintf(buffer, sizeof(buffer), "%ld", v);
+
+	return write(buffer);
+}
+
+size_t Print::print(unsigned long v, int base)
+{
+	char buffer[34];
+
+	if (base == 16)
+		snprintf(buffer, sizeof(buffer), "%lx", v);
+	else
+		snprintf(buffer, sizeof(buffer), "%lu", v);
+
+	return write(buffer);
+}
+
+size_t Print::print(double v, int digits)
+{
+	char buffer[40];
+
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, v);
+
+	return write(buffer);
+}
+
+size_t Print::print(const Printable &p)
+{
+	return p.printTo(*this);
+}
+
+int Stream::read(uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+
+	while (n < size && available() > 0)
+		buffer[n++] = read();
+
+	return n;
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length)
+{
+	size_t n = 0;
+	unsigned long start = millis();
+
+	while (n < length)
+	{
+		int c = read();
+
+		if (c >= 0)
+			buffer[n++] = c;
+		else if (millis() - start >= _timeout || available() <= 0)
+			break; // Nothing more comes in the fake
+	}
+
+	return n;
+}
+
+/*
+ * HardwareSerial
+ */
+
+int HardwareSerial::read()
+{
+	if (_rx.empty())
+		return -1;
+
+	uint8_t c = _rx.front();
+	_rx.pop_front();
+
+	return c;
+}
+
+int HardwareSerial::read(uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+
+	while (n < size && !_rx.empty())
+	{
+		buffer[n++] = _rx.front();
+		_rx.pop_front();
+	}
+
+	return n;
+}
+
+/*
+ * EspClass
+ */
+
+uint32_t EspClass::getFreeHeap()
+{
+	return 40000;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize()
+{
+	return 30000;
+}
+
+void EspClass::getHeapStats(uint32_t *hfree, uint32_t *hmax, uint8_t *hfrag)
+{
+	if (hfree != nullptr)
+		*hfree = getFreeHeap();
+	if (hmax != nullptr)
+		*hmax = getMaxFreeBlockSize();
+	if (hfrag != nullptr)
+		*hfrag = 0;
+}
+
+uint32_t EspClass::getCycleCount()
+{
+	return micros() * getCpuFreqMHz();
+}
+
+uint8_t EspClass::getCpuFreqMHz()
+{
+	return system_get_cpu_freq();
+}
+
+void EspClass::reset()
+{
+	++fakeResets;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t, uint32_t *data, size_t size)
+{
+	memset(data, 0, size);
+	return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t, uint32_t *, size_t)
+{
+	return true;
+}
+
+/*
+ * EEPROM
+ */
+
+void EEPROMClass::begin(size_t size)
+{
+	static bool erased = false;
+
+	if (!erased)
+	{
+		erase();
+		erased = true;
+	}
+
+	_size = size;
+}
+
+/*
+ * IPAddress
+ */
+
+bool IPAddress::fromString(const char *address)
+{
+	unsigned int a, b, c, d;
+	char end;
+
+	if (sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &end) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+		return false;
+
+	_addr = IPAddress(a, b, c, d)._addr;
+
+	return true;
+}
+
+bool IPAddress::isValid(const char *address)
+{
+	IPAddress ip;
+
+	return ip.fromString(address);
+}
+
+String IPAddress::toString() const
+{
+	char buffer[16];
+
+	snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+
+	return String(buffer);
+}
+
+/*
+ * WiFiClient: connects to an in-memory peer which accepts everything
+ */
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+	static uint16_t localPort = 49152;
+
+	_connection = std::make_shared<FakeConnection>();
+	_connection->remoteIP = ip;
+	_connection->remotePort = port;
+	_connection->localPort = localPort++;
+
+	fakeNet::outgoing.push_back(_connection);
+
+	return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+	IPAddress ip;
+
+	if (!WiFi.hostByName(host, ip))
+		return 0;
+
+	return connect(ip, port);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+	if (!connected())
+		return 0;
+
+	_connection->tx.append((const char *)buffer, size);
+
+	return size;
+}
+
+int WiFiClient::available()
+{
+	return _connection ? _connection->rx.size() : 0;
+}
+
+int WiFiClient::read()
+{
+	if (!_connection || _connection->rx.empty())
+		return -1;
+
+	uint8_t c = _connection->rx.front();
+	_connection->rx.pop_front();
+
+	return c;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+
+	while (n < size && _connection && !_connection->rx.empty())
+	{
+		buffer[n++] = _connection->rx.front();
+		_connection->rx.pop_front();
+	}
+
+	return n;
+}
+
+int WiFiClient::peek()
+{
+	return (!_connection || _connection->rx.empty()) ? -1 : _connection->rx.front();
+}
+
+size_t WiFiClient::peekBytes(uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+
+	while (_connection && n < size && n < _connection->rx.size())
+	{
+		buffer[n] = _connection->rx[n];
+		++n;
+	}
+
+	return n;
+}
+
+void WiFiClient::stop()
+{
+	if (_connection)
+		_connection->open = false;
+}
+
+uint8_t WiFiClient::connected()
+{
+	// Like the core: connected while open or unread data are left
+	return _connection && (_connection->open || !_connection->rx.empty());
+}
+
+IPAddress WiFiClient::localIP()
+{
+	return WiFi.localIP();
+}
+
+/*
+ * WiFiServer
+ */
+
+bool WiFiServer::hasClient()
+{
+	return _listening && !fakeNet::pendingAccepts[_port].empty();
+}
+
+WiFiClient WiFiServer::accept()
+{
+	if (!hasClient())
+		return WiFiClient();
+
+	std::shared_ptr<FakeConnection> connection = fakeNet::pendingAccepts[_port].front();
+	fakeNet::pendingAccepts[_port].pop_front();
+
+	return WiFiClient(connection);
+}
+
+/*
+ * WiFiUDP
+ */
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+	static uint16_t ephemeralPort = 50000;
+
+	_port = port != 0 ? port : ephemeralPort++;
+
+	return 1;
+}
+
+void WiFiUDP::stop()
+{
+	_port = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+	_out.clear();
+	_outIP = ip;
+	_outPort = port;
+
+	return 1;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port)
+{
+	IPAddress ip;
+
+	if (!WiFi.hostByName(host, ip))
+		return 0;
+
+	return beginPacket(ip, port);
+}
+
+int WiFiUDP::endPacket()
+{
+	fakeNet::sentDatagrams.push_back(_out);
+	_out.clear();
+
+	return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
+{
+	_out.append((const char *)buffer, size);
+
+	return size;
+}
+
+int WiFiUDP::parsePacket()
+{
+	std::deque<fakeNet::Datagram> &queue = fakeNet::pendingDatagrams[_port];
+
+	if (_port == 0 || queue.empty())
+		return 0;
+
+	_packet = queue.front().data;
+	_packetIP = queue.front().remoteIP;
+	_packetPort = queue.front().remotePort;
+	_packetPos = 0;
+	queue.pop_front();
+
+	return _packet.size();
+}
+
+int WiFiUDP::available()
+{
+	return _packet.size() - _packetPos;
+}
+
+int WiFiUDP::read()
+{
+	return _packetPos < _packet.size() ? (uint8_t)_packet[_packetPos++] : -1;
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size)
+{
+	size_t n = _min(size, _packet.size() - _packetPos);
+
+	memcpy(buffer, _packet.data() + _packetPos, n);
+	_packetPos += n;
+
+	return n;
+}
+
+int WiFiUDP::peek()
+{
+	return _packetPos < _packet.size() ? (uint8_t)_packet[_packetPos] : -1;
+}
+
+/*
+ * ESP8266WiFiClass
+ */
+
+int ESP8266WiFiClass::hostByName(const char *host, IPAddress &ip)
+{
+	ip_addr_t addr;
+
+	if (dns_gethostbyname(host, &addr, nullptr, nullptr) != ERR_OK)
+		return 0;
+
+	ip = addr.addr;
+
+	return 1;
+}
+
+void dhcp_stop(struct netif *)
+{
+}
+
+/*
+ * Test interface of the fake network
+ */
+
+std::shared_ptr<FakeConnection> fakeNet::accept(uint16_t port, IPAddress remoteIP, uint16_t remotePort)
+{
+	std::shared_ptr<FakeConnection> connection = std::make_shared<FakeConnection>();
+
+	connection->remoteIP = remoteIP;
+	connection->remotePort = remotePort;
+	connection->localPort = port;
+
+	pendingAccepts[port].push_back(connection);
+
+	return connection;
+}
+
+void fakeNet::datagram(uint16_t port, IPAddress remoteIP, uint16_t remotePort, const std::string &data)
+{
+	pendingDatagrams[port].push_back({remoteIP, remotePort, data});
+}
+
+void fakeNet::reset()
+{
+	outgoing.clear();
+	sentDatagrams.clear();
+	pendingAccepts.clear();
+	pendingDatagrams.clear();
+}
+
+/*
+ * lwIP: every name resolves at once, the address is derived from the name
+ */
+
+err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback, void *)
+{
+	IPAddress ip;
+
+	if (!ip.fromString(hostname))
+	{
+		if (hostname[0] == '\0' || strlen(hostname) >= DNS_MAX_NAME_LENGTH)
+			return ERR_ARG;
+
+		ip = IPAddress(10, 0, 0, 1 + crc32(hostname, strlen(hostname)) % 250);
+	}
+
+	addr->addr = ip;
+
+	return ERR_OK;
+}
+
+void dns_setserver(uint8_t, const ip_addr_t *)
+{
+}
+
+const char *sntp_getservername(unsigned char)
+{
+	return "";
+}
+
+/*
+ * SDK
+ */
+
+static uint8_t cpuFreq = 80;
+
+station_status_t wifi_station_get_connect_status()
+{
+	return STATION_GOT_IP;
+}
+
+bool wifi_get_ip_info(uint8_t, struct ip_info *info)
+{
+	info->ip.addr = WiFi.localIP();
+	info->netmask.addr = WiFi.subnetMask();
+	info->gw.addr = WiFi.gatewayIP();
+
+	return true;
+}
+
+bool wifi_station_dhcpc_stop()
+{
+	return true;
+}
+
+bool wifi_station_get_config(struct station_config *config)
+{
+	memset(config, 0, sizeof(*config));
+	strcpy((char *)config->ssid, "fake");
+
+	return true;
+}
+
+bool wifi_station_get_config_default(struct station_config *config)
+{
+	return wifi_station_get_config(config);
+}
+
+bool wifi_station_set_config_current(struct station_config *)
+{
+	return true;
+}
+
+bool wifi_softap_get_config(struct softap_config *config)
+{
+	memset(config, 0, sizeof(*config));
+	strcpy((char *)config->ssid, "ESP_FAKE");
+	config->ssid_len = 8;
+	config->channel = 1;
+	config->max_connection = 4;
+	config->beacon_interval = 100;
+
+	return true;
+}
+
+bool wifi_softap_get_config_default(struct softap_config *config)
+{
+	return wifi_softap_get_config(config);
+}
+
+phy_mode_t wifi_get_phy_mode()
+{
+	return PHY_MODE_11N;
+}
+
+bool wifi_set_phy_mode(phy_mode_t)
+{
+	return true;
+}
+
+const char *system_get_sdk_version()
+{
+	return "fake";
+}
+
+uint8_t system_get_cpu_freq()
+{
+	return cpuFreq;
+}
+
+bool system_update_cpu_freq(uint8_t freq)
+{
+	cpuFreq = freq;
+
+	return true;
+}
+
+/*
+ * SHA-256 (FIPS 180-4) for the certificate fingerprints
+ */
+
+static const uint32_t SHA256_K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static inline uint32_t rotr(uint32_t x, uint8_t n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static void sha256Block(uint32_t *val, const unsigned char *block)
+{
+	uint32_t w[64];
+
+	for (uint8_t i = 0; i < 16; ++i)
+		w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+
+	for (uint8_t i = 16; i < 64; ++i)
+	{
+		uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32_t a = val[0], b = val[1], c = val[2], d = val[3], e = val[4], f = val[5], g = val[6], h = val[7];
+
+	for (uint8_t i = 0; i < 64; ++i)
+	{
+		uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+		uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	val[0] += a;
+	val[1] += b;
+	val[2] += c;
+	val[3] += d;
+	val[4] += e;
+	val[5] += f;
+	val[6] += g;
+	val[7] += h;
+}
+
+void br_sha256_init(br_sha256_context *ctx)
+{
+	static const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+	memcpy(ctx->val, init, sizeof(init));
+	ctx->count = 0;
+}
+
+void br_sha256_update(br_sha256_context *ctx, const void *data, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)data;
+
+	while (len--)
+	{
+		ctx->buf[ctx->count++ % 64] = *p++;
+
+		if (ctx->count % 64 == 0)
+			sha256Block(ctx->val, ctx->buf);
+	}
+}
+
+void br_sha256_out(const br_sha256_context *ctx, void *out)
+{
+	br_sha256_context c = *ctx;
+	uint64_t bits = ctx->count * 8;
+	unsigned char pad = 0x80;
+
+	br_sha256_update(&c, &pad, 1);
+
+	pad = 0;
+	while (c.count % 64 != 56)
+		br_sha256_update(&c, &pad, 1);
+
+	for (int8_t i = 7; i >= 0; --i)
+	{
+		unsigned char b = bits >> (8 * i);
+		br_sha256_update(&c, &b, 1);
+	}
+
+	for (uint8_t i = 0; i < 8; ++i)
+	{
+		((unsigned char *)out)[4 * i] = c.val[i] >> 24;
+		((unsigned char *)out)[4 * i + 1] = c.val[i] >> 16;
+		((unsigned char *)out)[4 * i + 2] = c.val[i] >> 8;
+		((unsigned char *)out)[4 * i + 3] = c.val[i];
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * host.cpp
+ *
+ * Part of ESP_ATMod: host side driver of the firmware for the native tests
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "host.h"
+
+/*
+ * Firmware entry points
+ */
+
+void setup();
+void loop();
+
+/*
+ * Public functions
+ */
+
+/*
+ * Starts the firmware once and switches the echo off
+ */
+void hostBegin()
+{
+	static bool started = false;
+
+	if (!started)
+	{
+		Serial.output().reserve(65536);
+		setup();
+		started = true;
+	}
+
+	// No echo, the output is the response only
+	hostSend("ATE0\r\n");
+}
+
+/*
+ * Runs loop() until the serial input is consumed and three passes produce no output
+ */
+void hostRun(uint32_t maxPasses)
+{
+	uint8_t idlePasses = 0;
+
+	for (uint32_t i = 0; i < maxPasses && idlePasses < 3; ++i)
+	{
+		size_t outputLength = Serial.output().length();
+
+		loop();
+
+		if (Serial.available() > 0 || Serial.output().length() != outputLength)
+			idlePasses = 0;
+		else
+			++idlePasses;
+	}
+}
+
+std::string hostTakeOutput()
+{
+	// The capacity of the buffer stays, it does not allocate while the firmware runs
+	std::string output = Serial.output();
+
+	Serial.output().clear();
+
+	return output;
+}
+
+std::string hostSend(const char *text, size_t length)
+{
+	Serial.inject(text, length);
+	hostRun();
+
+	return hostTakeOutput();
+}
+
+std::string hostSend(const std::string &text)
+{
+	return hostSend(text.data(), text.length());
+}
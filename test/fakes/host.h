@@ -0,0 +1,43 @@
+/*
+ * host.h
+ *
+ * Part of ESP_ATMod: host side driver of the firmware for the native tests
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_HOST_H_
+#define FAKE_HOST_H_
+
+#include <string>
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+/*
+ * Runs the firmware on the host: setup() once, then loop() until the input is processed
+ * and the output does not change any more
+ */
+
+void hostBegin();
+void hostRun(uint32_t maxPasses = 1000);
+std::string hostTakeOutput();
+
+// Sends the text on the serial port, runs the firmware and returns the output
+std::string hostSend(const char *text, size_t length);
+std::string hostSend(const std::string &text);
+
+#endif /* FAKE_HOST_H_ */
@@ -0,0 +1,48 @@
+/*
+ * dns.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_LWIP_DNS_H_
+#define FAKE_LWIP_DNS_H_
+
+#include <stdint.h>
+
+typedef struct ip_addr
+{
+	uint32_t addr;
+} ip_addr_t;
+
+typedef int8_t err_t;
+
+#define ERR_OK 0
+#define ERR_INPROGRESS -5
+#define ERR_ARG -16
+
+#define DNS_MAX_NAME_LENGTH 256
+
+#define ip_addr_get_ip4_u32(a) ((a)->addr)
+
+typedef void (*dns_found_callback)(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
+
+// The fake resolves IP literals and the names in fakeDnsHosts at once
+err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg);
+void dns_setserver(uint8_t index, const ip_addr_t *server);
+
+#endif /* FAKE_LWIP_DNS_H_ */
@@ -0,0 +1,110 @@
+/*
+ * user_interface.h
+ *
+ * Part of ESP_ATMod: host build fakes of the ESP8266 Arduino core
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAKE_USER_INTERFACE_H_
+#define FAKE_USER_INTERFACE_H_
+
+#include <stdint.h>
+
+#define STATION_IF 0
+#define SOFTAP_IF 1
+
+typedef enum
+{
+	STATION_IDLE = 0,
+	STATION_CONNECTING,
+	STATION_WRONG_PASSWORD,
+	STATION_NO_AP_FOUND,
+	STATION_CONNECT_FAIL,
+	STATION_GOT_IP
+} station_status_t;
+
+typedef enum
+{
+	PHY_MODE_11B = 1,
+	PHY_MODE_11G,
+	PHY_MODE_11N
+} phy_mode_t;
+
+enum
+{
+	AUTH_OPEN = 0,
+	AUTH_WEP,
+	AUTH_WPA_PSK,
+	AUTH_WPA2_PSK,
+	AUTH_WPA_WPA2_PSK,
+	AUTH_MAX
+};
+
+struct ip4_addr_s
+{
+	uint32_t addr;
+};
+
+struct ip_info
+{
+	struct ip4_addr_s ip, netmask, gw;
+};
+
+struct station_config
+{
+	uint8_t ssid[32];
+	uint8_t password[64];
+	uint8_t bssid_set;
+	uint8_t bssid[6];
+};
+
+struct softap_config
+{
+	uint8_t ssid[32];
+	uint8_t password[64];
+	uint8_t ssid_len;
+	uint8_t channel;
+	int authmode;
+	uint8_t ssid_hidden;
+	uint8_t max_connection;
+	uint16_t beacon_interval;
+};
+
+struct scan_config
+{
+	uint8_t *ssid;
+	uint8_t *bssid;
+	uint8_t channel;
+	uint8_t show_hidden;
+};
+
+station_status_t wifi_station_get_connect_status();
+bool wifi_get_ip_info(uint8_t interface, struct ip_info *info);
+bool wifi_station_dhcpc_stop();
+bool wifi_station_get_config(struct station_config *config);
+bool wifi_station_get_config_default(struct station_config *config);
+bool wifi_station_set_config_current(struct station_config *config);
+bool wifi_softap_get_config(struct softap_config *config);
+bool wifi_softap_get_config_default(struct softap_config *config);
+phy_mode_t wifi_get_phy_mode();
+bool wifi_set_phy_mode(phy_mode_t mode);
+
+const char *system_get_sdk_version();
+uint8_t system_get_cpu_freq();
+bool system_update_cpu_freq(uint8_t freq);
+
+#endif /* FAKE_USER_INTERFACE_H_ */
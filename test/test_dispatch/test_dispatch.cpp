@@ -0,0 +1,296 @@
+/*
+ * test_dispatch.cpp
+ *
+ * Part of ESP_ATMod: native benchmark of the command dispatch
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+
+#include <unity.h>
+
+#include "ESP_ATMod.h"
+#include "command.h"
+
+/*
+ * Note: compares the hashed command index of findCommand() with the linear lookup of version 0.5.0.
+ *       The 0.5.0 lookup is kept here as it was: memcmp() over the command list with strlen() of
+ *       each entry, then the if/else chain of processCommandBuffer() over the command codes.
+ */
+
+commands_t findCommand(uint8_t *input, uint16_t inpLen);
+
+/*
+ * The lookup of version 0.5.0
+ */
+
+enum baselineMode_t
+{
+	MODE_NO_CHECKING,
+	MODE_EXACT_MATCH,
+	MODE_QUERY_SET
+};
+
+typedef struct
+{
+	const char *text;
+	const baselineMode_t mode;
+	const commands_t cmd;
+} baselineDef_t;
+
+static const baselineDef_t BASELINE_LIST[] = {
+	{"+RST", MODE_EXACT_MATCH, CMD_AT_RST},
+	{"+GMR", MODE_EXACT_MATCH, CMD_AT_GMR},
+	{"E", MODE_NO_CHECKING, CMD_ATE},
+	{"+RESTORE", MODE_EXACT_MATCH, CMD_AT_RESTORE},
+	{"+UART", MODE_QUERY_SET, CMD_AT_UART},
+	{"+UART_CUR", MODE_QUERY_SET, CMD_AT_UART_CUR},
+	{"+UART_DEF", MODE_QUERY_SET, CMD_AT_UART_DEF},
+	{"+SYSRAM?", MODE_EXACT_MATCH, CMD_AT_SYSRAM},
+
+	{"+CWMODE", MODE_QUERY_SET, CMD_AT_CWMODE},
+	{"+CWMODE_CUR", MODE_QUERY_SET, CMD_AT_CWMODE_CUR},
+	{"+CWMODE_DEF", MODE_QUERY_SET, CMD_AT_CWMODE_DEF},
+	{"+CWJAP", MODE_QUERY_SET, CMD_AT_CWJAP},
+	{"+CWJAP_CUR", MODE_QUERY_SET, CMD_AT_CWJAP_CUR},
+	{"+CWJAP_DEF", MODE_QUERY_SET, CMD_AT_CWJAP_DEF},
+	{"+CWLAPOPT", MODE_QUERY_SET, CMD_AT_CWLAPOPT},
+	{"+CWLAP", MODE_EXACT_MATCH, CMD_AT_CWLAP},
+	{"+CWQAP", MODE_EXACT_MATCH, CMD_AT_CWQAP},
+	{"+CWSAP", MODE_QUERY_SET, CMD_AT_CWSAP},
+	{"+CWSAP_CUR", MODE_QUERY_SET, CMD_AT_CWSAP_CUR},
+	{"+CWSAP_DEF", MODE_QUERY_SET, CMD_AT_CWSAP_DEF},
+	{"+CWDHCP", MODE_QUERY_SET, CMD_AT_CWDHCP},
+	{"+CWDHCP_CUR", MODE_QUERY_SET, CMD_AT_CWDHCP_CUR},
+	{"+CWDHCP_DEF", MODE_QUERY_SET, CMD_AT_CWDHCP_DEF},
+	{"+CWAUTOCONN", MODE_QUERY_SET, CMD_AT_CWAUTOCONN},
+	{"+CIPSTAMAC", MODE_QUERY_SET, CMD_AT_CIPSTAMAC},
+	{"+CIPSTAMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPSTAMAC_CUR},
+	{"+CIPSTAMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPSTAMAC_DEF},
+	{"+CIPAPMAC", MODE_QUERY_SET, CMD_AT_CIPAPMAC},
+	{"+CIPAPMAC_CUR", MODE_QUERY_SET, CMD_AT_CIPAPMAC_CUR},
+	{"+CIPAPMAC_DEF", MODE_QUERY_SET, CMD_AT_CIPAPMAC_DEF},
+	{"+CIPSTA", MODE_QUERY_SET, CMD_AT_CIPSTA},
+	{"+CIPSTA_CUR", MODE_QUERY_SET, CMD_AT_CIPSTA_CUR},
+	{"+CIPSTA_DEF", MODE_QUERY_SET, CMD_AT_CIPSTA_DEF},
+	{"+CIPAP", MODE_QUERY_SET, CMD_AT_CIPAP},
+	{"+CIPAP_CUR", MODE_QUERY_SET, CMD_AT_CIPAP_CUR},
+	{"+CIPAP_DEF", MODE_QUERY_SET, CMD_AT_CIPAP_DEF},
+	{"+CWHOSTNAME", MODE_QUERY_SET, CMD_AT_CWHOSTNAME},
+	{"+CEHOSTNAME", MODE_QUERY_SET, CMD_AT_CEHOSTNAME},
+
+	{"+CIPSTATUS", MODE_EXACT_MATCH, CMD_AT_CIPSTATUS},
+	{"+CIPDOMAIN", MODE_NO_CHECKING, CMD_AT_CIPDOMAIN},
+	{"+CIPSTART", MODE_NO_CHECKING, CMD_AT_CIPSTART},
+	{"+CIPSSLSIZE", MODE_QUERY_SET, CMD_AT_CIPSSLSIZE},
+	{"+CIPSEND", MODE_NO_CHECKING, CMD_AT_CIPSEND},
+	{"+CIPCLOSEMODE", MODE_NO_CHECKING, CMD_AT_CIPCLOSEMODE},
+	{"+CIPCLOSE", MODE_NO_CHECKING, CMD_AT_CIPCLOSE},
+	{"+CIFSR", MODE_EXACT_MATCH, CMD_AT_CIFSR},
+	{"+CIPMUX", MODE_QUERY_SET, CMD_AT_CIPMUX},
+	{"+CIPDINFO", MODE_QUERY_SET, CMD_AT_CIPDINFO},
+	{"+CIPSERVER", MODE_NO_CHECKING, CMD_AT_CIPSERVER},
+	{"+CIPSERVERMAXCONN", MODE_QUERY_SET, CMD_AT_CIPSERVERMAXCONN},
+	{"+CIPSTO", MODE_QUERY_SET, CMD_AT_CIPSTO},
+	{"+CIPRECVMODE", MODE_QUERY_SET, CMD_AT_CIPRECVMODE},
+	{"+CIPRECVDATA", MODE_QUERY_SET, CMD_AT_CIPRECVDATA},
+	{"+CIPRECVLEN", MODE_QUERY_SET, CMD_AT_CIPRECVLEN},
+	{"+CIPSNTPCFG", MODE_QUERY_SET, CMD_AT_CIPSNTPCFG},
+	{"+CIPSNTPTIME?", MODE_EXACT_MATCH, CMD_AT_CIPSNTPTIME},
+	{"+CIPDNS", MODE_QUERY_SET, CMD_AT_CIPDNS},
+	{"+CIPDNS_CUR", MODE_QUERY_SET, CMD_AT_CIPDNS_CUR},
+	{"+CIPDNS_DEF", MODE_QUERY_SET, CMD_AT_CIPDNS_DEF},
+
+	{"+SYSCPUFREQ", MODE_QUERY_SET, CMD_AT_SYSCPUFREQ},
+	{"+RFMODE", MODE_QUERY_SET, CMD_AT_RFMODE},
+	{"+CIPSSLAUTH", MODE_QUERY_SET, CMD_AT_CIPSSLAUTH},
+	{"+CIPSSLFP", MODE_QUERY_SET, CMD_AT_CIPSSLFP},
+	{"+CIPSSLCERTMAX", MODE_QUERY_SET, CMD_AT_CIPSSLCERTMAX},
+	{"+CIPSSLCERT", MODE_NO_CHECKING, CMD_AT_CIPSSLCERT},
+	{"+CIPSSLMFLN", MODE_QUERY_SET, CMD_AT_CIPSSLMFLN},
+	{"+CIPSSLSTA", MODE_NO_CHECKING, CMD_AT_CIPSSLSTA},
+	{"+SNTPTIME?", MODE_EXACT_MATCH, CMD_AT_SNTPTIME}};
+
+static commands_t baselineFindCommand(uint8_t *input, uint16_t inpLen)
+{
+	if (inpLen < 4 || input[0] != 'A' || input[1] != 'T' || input[inpLen - 2] != '\r' || input[inpLen - 1] != '\n')
+		return CMD_ERROR;
+
+	if (inpLen == 4)
+		return CMD_AT;
+
+	for (unsigned int i = 0; i < sizeof(BASELINE_LIST) / sizeof(baselineDef_t); ++i)
+	{
+		const char *cmd = BASELINE_LIST[i].text;
+
+		if (!memcmp(cmd, input + 2, strlen(cmd)))
+		{
+			switch (BASELINE_LIST[i].mode)
+			{
+			case MODE_EXACT_MATCH:
+				if (inpLen == strlen(cmd) + 4)
+					return BASELINE_LIST[i].cmd;
+				break;
+
+			case MODE_QUERY_SET:
+			{
+				char c = input[strlen(cmd) + 2];
+				if (c == '=' || c == '?')
+				{
+					if (c == '?' && inpLen != strlen(cmd) + 5)
+						return CMD_ERROR;
+
+					return BASELINE_LIST[i].cmd;
+				}
+			}
+			break;
+
+			case MODE_NO_CHECKING:
+			{
+				char c = input[strlen(cmd) + 2];
+
+				if (!isAlpha(c))
+					return BASELINE_LIST[i].cmd;
+			}
+			break;
+
+			default:
+				return CMD_ERROR;
+			}
+		}
+	}
+
+	return CMD_ERROR;
+}
+
+/*
+ * The if/else chain compared the code with each command in the order of the list
+ */
+static uint16_t baselineDispatch(commands_t cmd)
+{
+	if (cmd == CMD_AT)
+		return 1;
+
+	for (unsigned int i = 0; i < sizeof(BASELINE_LIST) / sizeof(baselineDef_t); ++i)
+	{
+		if (*(volatile commands_t *)&BASELINE_LIST[i].cmd == cmd)
+			return i + 2;
+	}
+
+	return 0;
+}
+
+/*
+ * Command mix of a host streaming data (WiFiEspAT library)
+ */
+
+static const char *const COMMAND_MIX[] = {
+	"AT+CIPSEND=0,1460\r\n",
+	"AT+CIPSEND=1,512\r\n",
+	"AT+CIPRECVDATA=0,1460\r\n",
+	"AT+CIPRECVLEN?\r\n",
+	"AT+CIPSTATUS\r\n",
+	"AT+CIPSTART=2,\"TCP\",\"192.168.1.10\",8080\r\n",
+	"AT+CIPCLOSE=2\r\n",
+	"AT+CWJAP?\r\n",
+	"AT+CIPDNS_CUR?\r\n",
+	"AT\r\n",
+};
+
+static const uint8_t MIX_SIZE = sizeof(COMMAND_MIX) / sizeof(COMMAND_MIX[0]);
+
+/*
+ * Helpers
+ */
+
+typedef std::chrono::steady_clock benchClock;
+
+/*
+ * Returns ns per command of the lookup, the sum of the results keeps the calls from being optimized out
+ */
+template <typename LOOKUP> static double measure(LOOKUP lookup, uint32_t iterations, uint32_t &sum)
+{
+	uint8_t lines[MIX_SIZE][64];
+	uint16_t lengths[MIX_SIZE];
+
+	for (uint8_t i = 0; i < MIX_SIZE; ++i)
+	{
+		lengths[i] = strlen(COMMAND_MIX[i]);
+		memcpy(lines[i], COMMAND_MIX[i], lengths[i]);
+	}
+
+	benchClock::time_point start = benchClock::now();
+
+	for (uint32_t it = 0; it < iterations; ++it)
+	{
+		for (uint8_t i = 0; i < MIX_SIZE; ++i)
+			sum += lookup(lines[i], lengths[i]);
+	}
+
+	return std::chrono::duration<double, std::nano>(benchClock::now() - start).count() / (iterations * MIX_SIZE);
+}
+
+/*
+ * Tests
+ */
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_same_result()
+{
+	for (const char *line : COMMAND_MIX)
+	{
+		uint16_t len = strlen(line);
+
+		TEST_ASSERT_EQUAL_MESSAGE(baselineFindCommand((uint8_t *)line, len), findCommand((uint8_t *)line, len), line);
+	}
+}
+
+void test_dispatch_cost()
+{
+	const uint32_t iterations = 200000;
+	uint32_t sum = 0;
+
+	double before = measure([](uint8_t *line, uint16_t len) { return baselineDispatch(baselineFindCommand(line, len)); },
+							iterations, sum);
+	double after = measure([](uint8_t *line, uint16_t len) { return (uint16_t)findCommand(line, len); }, iterations, sum);
+
+	char message[120];
+
+	snprintf(message, sizeof(message), "dispatch: 0.5.0 linear %.1f ns/command, hashed %.1f ns/command (%.1fx)", before,
+			 after, before / after);
+	TEST_MESSAGE(message);
+
+	TEST_ASSERT_NOT_EQUAL(0, sum);
+	TEST_ASSERT_TRUE(after < before);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_same_result);
+	RUN_TEST(test_dispatch_cost);
+
+	return UNITY_END();
+}
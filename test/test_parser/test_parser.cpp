@@ -0,0 +1,433 @@
+/*
+ * test_parser.cpp
+ *
+ * Part of ESP_ATMod: native tests of the command parser
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <unity.h>
+
+#include "host.h"
+#include "ESP_ATMod.h"
+#include "command.h"
+#include "asnDecode.h"
+#include "serialTx.h"
+
+/*
+ * Parser functions of command.cpp
+ */
+
+commands_t findCommand(uint8_t *input, uint16_t inpLen);
+String readStringFromBuffer(unsigned char *inpBuf, uint16_t &offset, bool escape, bool allowEmpty = false);
+bool readNumber(unsigned char *inpBuf, uint16_t &offset, uint32_t &output);
+bool readIpAddress(unsigned char *inpBuf, uint16_t &offset, uint32_t &output);
+bool readLinkId(unsigned char *inpBuf, uint16_t &offset, uint8_t &linkId);
+
+/*
+ * Self-signed certificate with CN=test.example.com
+ */
+
+static const uint8_t TEST_CERT[] = {
+	0x30, 0x82, 0x01, 0x64, 0x30, 0x82, 0x01, 0x0a, 0xa0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x14, 0x70,
+	0x3c, 0xd3, 0xab, 0xc6, 0x2d, 0xee, 0x21, 0x5f, 0xea, 0xe1, 0x8a, 0xca, 0xe1, 0x6c, 0xa8, 0x65,
+	0x3c, 0x61, 0x69, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x30,
+	0x1b, 0x31, 0x19, 0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13, 0x10, 0x74, 0x65, 0x73, 0x74,
+	0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x30, 0x1e, 0x17, 0x0d,
+	0x32, 0x36, 0x31, 0x30, 0x31, 0x34, 0x30, 0x38, 0x35, 0x30, 0x30, 0x30, 0x5a, 0x17, 0x0d, 0x33,
+	0x36, 0x31, 0x30, 0x31, 0x31, 0x30, 0x38, 0x35, 0x30, 0x30, 0x30, 0x5a, 0x30, 0x1b, 0x31, 0x19,
+	0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x03, 0x13, 0x10, 0x74, 0x65, 0x73, 0x74, 0x2e, 0x65, 0x78,
+	0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2a,
+	0x86, 0x48, 0xce, 0x3d, 0x02, 0x01, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07,
+	0x03, 0x42, 0x00, 0x04, 0xc8, 0xdf, 0xd9, 0x82, 0x84, 0xb8, 0x52, 0x74, 0xff, 0xe5, 0x20, 0xf5,
+	0xa2, 0x5d, 0x20, 0xe3, 0xac, 0x80, 0x14, 0x1e, 0x14, 0xe3, 0xa5, 0x3b, 0x7a, 0xfb, 0x2b, 0x3c,
+	0x85, 0x65, 0x73, 0x21, 0xcf, 0xda, 0xc3, 0x34, 0x52, 0xb5, 0xe1, 0x96, 0xa3, 0xda, 0xb2, 0x57,
+	0x4c, 0x36, 0x04, 0xcf, 0x82, 0xd1, 0x2b, 0x65, 0x1a, 0xc3, 0x78, 0xd0, 0xbe, 0x00, 0x72, 0xb8,
+	0x81, 0x76, 0xce, 0xa7, 0xa3, 0x2c, 0x30, 0x2a, 0x30, 0x09, 0x06, 0x03, 0x55, 0x1d, 0x13, 0x04,
+	0x02, 0x30, 0x00, 0x30, 0x1d, 0x06, 0x03, 0x55, 0x1d, 0x0e, 0x04, 0x16, 0x04, 0x14, 0x3c, 0x64,
+	0x7d, 0x4f, 0x7b, 0x6f, 0xed, 0x40, 0x54, 0x31, 0xb9, 0xdf, 0x4f, 0xc0, 0xb2, 0xb6, 0x6c, 0x5e,
+	0x09, 0x8b, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x03, 0x48,
+	0x00, 0x30, 0x45, 0x02, 0x21, 0x00, 0xb4, 0x25, 0x4c, 0x07, 0x64, 0x44, 0x88, 0x86, 0xc5, 0xf2,
+	0xa3, 0x53, 0xf9, 0x15, 0x90, 0xff, 0x2b, 0x78, 0x04, 0x90, 0xae, 0xc5, 0x0e, 0x19, 0x4d, 0x6f,
+	0x61, 0x6a, 0xd0, 0xfa, 0x22, 0xbd, 0x02, 0x20, 0x4e, 0x74, 0x03, 0x1c, 0x8d, 0xfe, 0x7a, 0x6c,
+	0x25, 0x37, 0xbb, 0x72, 0x80, 0xe6, 0x8e, 0x95, 0x5e, 0xb5, 0x14, 0xa8, 0xab, 0x1a, 0x8c, 0x03,
+	0xad, 0x5f, 0x59, 0x89, 0x3c, 0xa4, 0xed, 0xf9,
+};
+
+/*
+ * Helpers
+ */
+
+static commands_t find(const char *line)
+{
+	return findCommand((uint8_t *)line, strlen(line));
+}
+
+static bool contains(const std::string &text, const char *part)
+{
+	return text.find(part) != std::string::npos;
+}
+
+/*
+ * Tests
+ */
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_findCommand()
+{
+	TEST_ASSERT_EQUAL(CMD_AT, find("AT\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_RST, find("AT+RST\r\n"));
+	TEST_ASSERT_EQUAL(CMD_ATE, find("ATE0\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_SYSRAM, find("AT+SYSRAM?\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_CWMODE, find("AT+CWMODE?\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_CWMODE, find("AT+CWMODE=1\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_CIPSEND, find("AT+CIPSEND=0,1460\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_CIPSENDBUF, find("AT+CIPSENDBUF=0,512\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_CIPSTART, find("AT+CIPSTART=0,\"TCP\",\"192.168.1.10\",80\r\n"));
+	TEST_ASSERT_EQUAL(CMD_AT_CWLAP, find("AT+CWLAP\r\n"));
+}
+
+void test_findCommand_rejects()
+{
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("AT+RSTX\r\n"));	   // Exact match
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("AT+RST=1\r\n"));	   // Exact match
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("AT+CWMODE?1\r\n")); // Query with a parameter
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("AT+CWMODE\r\n"));   // Neither '?' nor '='
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("AT+UNKNOWN=1\r\n"));
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("AT+CIPSEND=0,5"));  // No CR LF
+	TEST_ASSERT_EQUAL(CMD_ERROR, find("XT+RST\r\n"));
+}
+
+void test_readNumber()
+{
+	unsigned char buf[] = "1460,x";
+	uint16_t offset = 0;
+	uint32_t value = 7;
+
+	TEST_ASSERT_TRUE(readNumber(buf, offset, value));
+	TEST_ASSERT_EQUAL(1460, value);
+	TEST_ASSERT_EQUAL(4, offset);
+
+	// Not a number: the value and the offset stay
+	offset = 5;
+	TEST_ASSERT_FALSE(readNumber(buf, offset, value));
+	TEST_ASSERT_EQUAL(1460, value);
+	TEST_ASSERT_EQUAL(5, offset);
+}
+
+void test_readIpAddress()
+{
+	unsigned char valid[] = "\"192.168.1.10\",";
+	unsigned char large[] = "\"192.168.256.1\"";
+	unsigned char shortAddr[] = "\"192.168.1\"";
+	uint16_t offset = 0;
+	uint32_t ip = 0;
+
+	TEST_ASSERT_TRUE(readIpAddress(valid, offset, ip));
+	TEST_ASSERT_EQUAL_HEX32((uint32_t)IPAddress(192, 168, 1, 10), ip);
+	TEST_ASSERT_EQUAL(14, offset);
+
+	offset = 0;
+	TEST_ASSERT_FALSE(readIpAddress(large, offset, ip));
+
+	offset = 0;
+	TEST_ASSERT_FALSE(readIpAddress(shortAddr, offset, ip));
+}
+
+void test_readStringFromBuffer()
+{
+	unsigned char escaped[] = "\"home\\,net\",\"\"";
+	uint16_t offset = 0;
+
+	String s = readStringFromBuffer(escaped, offset, true);
+
+	TEST_ASSERT_EQUAL_STRING("home,net", s.c_str());
+	TEST_ASSERT_EQUAL(11, offset);
+
+	// The empty string only when allowed
+	offset = 12;
+	TEST_ASSERT_TRUE(readStringFromBuffer(escaped, offset, true).isEmpty());
+
+	offset = 12;
+	TEST_ASSERT_TRUE(readStringFromBuffer(escaped, offset, true, true).isEmpty());
+	TEST_ASSERT_EQUAL(14, offset);
+
+	// Unterminated
+	unsigned char open[] = "\"abc\r\n";
+	offset = 0;
+	TEST_ASSERT_TRUE(readStringFromBuffer(open, offset, false).isEmpty());
+}
+
+void test_readLinkId()
+{
+	unsigned char buf[] = "3,1460";
+	unsigned char noComma[] = "1460\r\n";
+	unsigned char tooLarge[16];
+	uint16_t offset = 0;
+	uint8_t linkId = 0;
+
+	TEST_ASSERT_TRUE(readLinkId(buf, offset, linkId));
+	TEST_ASSERT_EQUAL(3, linkId);
+	TEST_ASSERT_EQUAL(2, offset);
+
+	offset = 0;
+	TEST_ASSERT_FALSE(readLinkId(noComma, offset, linkId));
+	TEST_ASSERT_EQUAL(0, offset);
+
+	snprintf((char *)tooLarge, sizeof(tooLarge), "%u,10", MAX_LINKS);
+	offset = 0;
+	TEST_ASSERT_FALSE(readLinkId(tooLarge, offset, linkId));
+}
+
+void test_getCnFromDer()
+{
+	uint8_t der[sizeof(TEST_CERT)];
+
+	memcpy(der, TEST_CERT, sizeof(der));
+
+	uint8_t *cn = getCnFromDer(der, sizeof(der));
+
+	TEST_ASSERT_NOT_NULL(cn);
+	TEST_ASSERT_EQUAL(16, cn[0]); // Length of the string
+	TEST_ASSERT_EQUAL_STRING_LEN("test.example.com", (const char *)cn + 1, 16);
+
+	TEST_ASSERT_NULL(getCnFromDer(nullptr, 0));
+
+	der[0] = 0x31; // Not a sequence
+	TEST_ASSERT_NULL(getCnFromDer(der, sizeof(der)));
+}
+
+/*
+ * The byte state machine of loop()
+ */
+
+void test_loop_command()
+{
+	TEST_ASSERT_EQUAL_STRING("\r\nOK\r\n", hostSend("AT\r\n").c_str());
+	TEST_ASSERT_EQUAL_STRING("\r\nERROR\r\n", hostSend("AT+UNKNOWN\r\n").c_str());
+}
+
+void test_loop_split_input()
+{
+	// The line arrives in pieces over several passes
+	TEST_ASSERT_EQUAL_STRING("", hostSend("A").c_str());
+	TEST_ASSERT_EQUAL_STRING("", hostSend("T\r").c_str());
+	TEST_ASSERT_EQUAL_STRING("\r\nOK\r\n", hostSend("\n").c_str());
+
+	// Two lines at once
+	TEST_ASSERT_EQUAL_STRING("\r\nOK\r\n\r\nOK\r\n", hostSend("AT\r\nAT\r\n").c_str());
+}
+
+void test_loop_cipsend_and_ipd()
+{
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPMUX=1\r\n"), "OK"));
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=0,\"TCP\",\"192.168.1.10\",8080\r\n"), "0,CONNECT"));
+
+	std::shared_ptr<FakeConnection> peer = fakeNet::outgoing.back();
+
+	TEST_ASSERT_EQUAL(8080, peer->remotePort);
+
+	// The prompt, then the data go to the peer
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSEND=0,5\r\n"), ">"));
+	TEST_ASSERT_TRUE(contains(hostSend("hello"), "SEND OK"));
+	TEST_ASSERT_EQUAL_STRING("hello", peer->tx.c_str());
+
+	// Received data come as +IPD
+	const char reply[] = "world";
+	peer->rx.insert(peer->rx.end(), reply, reply + 5);
+	TEST_ASSERT_EQUAL_STRING("\r\n+IPD,0,5:world", hostSend("").c_str());
+
+	// The peer closes the connection
+	peer->open = false;
+	TEST_ASSERT_EQUAL_STRING("0,CLOSED\r\n", hostSend("").c_str());
+}
+
+void test_loop_sendbuf_fail()
+{
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=1,\"TCP\",\"192.168.1.10\",8080\r\n"), "1,CONNECT"));
+
+	std::shared_ptr<FakeConnection> peer = fakeNet::outgoing.back();
+
+	// Two segments wait for the TCP window, then the peer closes the connection
+	peer->window = 0;
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSENDBUF=1,5\r\n"), ">"));
+	TEST_ASSERT_TRUE(contains(hostSend("hello"), "Recv 5 bytes"));
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSENDBUF=1,5\r\n"), ">"));
+	TEST_ASSERT_TRUE(contains(hostSend("world"), "Recv 5 bytes"));
+
+	// Each segment gets its result before the link is reported closed
+	peer->open = false;
+	TEST_ASSERT_EQUAL_STRING("1,1,SEND FAIL\r\n1,2,SEND FAIL\r\n1,CLOSED\r\n", hostSend("").c_str());
+}
+
+void test_loop_sendmulti_closed_target()
+{
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=2,\"TCP\",\"192.168.1.10\",8080\r\n"), "2,CONNECT"));
+	std::shared_ptr<FakeConnection> first = fakeNet::outgoing.back();
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=3,\"TCP\",\"192.168.1.10\",8080\r\n"), "3,CONNECT"));
+	std::shared_ptr<FakeConnection> second = fakeNet::outgoing.back();
+
+	// The second target closes while the data are read
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSENDMULTI=5,2,3\r\n"), ">"));
+	TEST_ASSERT_EQUAL_STRING("", hostSend("he").c_str());
+	second->open = false;
+	TEST_ASSERT_EQUAL_STRING("3,CLOSED\r\n", hostSend("").c_str());
+	TEST_ASSERT_EQUAL_STRING("\r\nRecv 5 bytes\r\n2,SEND OK\r\n3,SEND FAIL\r\n", hostSend("llo").c_str());
+	TEST_ASSERT_EQUAL_STRING("hello", first->tx.c_str());
+}
+
+void test_loop_recv_coalesce_per_link()
+{
+	// Only link 4 merges its data
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=0,\"TCP\",\"192.168.1.10\",8080\r\n"), "0,CONNECT"));
+	std::shared_ptr<FakeConnection> plain = fakeNet::outgoing.back();
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=4,\"TCP\",\"192.168.1.10\",8080\r\n"), "4,CONNECT"));
+	std::shared_ptr<FakeConnection> merged = fakeNet::outgoing.back();
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPRECVCOALESCE=4,8,1000\r\n"), "OK"));
+
+	const char data[] = "abcdefgh";
+	merged->rx.insert(merged->rx.end(), data, data + 3);
+	TEST_ASSERT_EQUAL_STRING("", hostSend("").c_str());
+	plain->rx.insert(plain->rx.end(), data, data + 3);
+	TEST_ASSERT_EQUAL_STRING("\r\n+IPD,0,3:abc", hostSend("").c_str());
+	merged->rx.insert(merged->rx.end(), data + 3, data + 8);
+	TEST_ASSERT_EQUAL_STRING("\r\n+IPD,4,8:abcdefgh", hostSend("").c_str());
+
+	// The setting ends with the link
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPCLOSE=4\r\n"), "4,CLOSED"));
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPRECVCOALESCE?\r\n"), "+CIPRECVCOALESCE:4,0,0\r\n"));
+}
+
+/*
+ * Decoded frames of the binary mode: <link ID>,<type>,<payload length>
+ */
+static std::vector<std::string> binFrames(const std::string &output)
+{
+	std::vector<std::string> frames;
+	std::string frame;
+	bool escape = false;
+
+	for (unsigned char c : output)
+	{
+		if (c == 0xC0)
+		{
+			if (frame.size() >= 6)
+			{
+				uint16_t length = (uint8_t)frame[2] | ((uint8_t)frame[3] << 8);
+				char text[32];
+
+				snprintf(text, sizeof(text), "%d,%d,%d%s", frame[0], frame[1], length,
+						 frame.size() == length + 6u ? "" : ",short");
+				frames.push_back(text);
+			}
+			frame.clear();
+		}
+		else if (escape)
+		{
+			frame += (c == 0xDC ? '\xC0' : '\xDB');
+			escape = false;
+		}
+		else if (c == 0xDB)
+			escape = true;
+		else
+			frame += c;
+	}
+
+	return frames;
+}
+
+void test_loop_binmode_frames()
+{
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=1,\"TCP\",\"192.168.1.10\",8080\r\n"), "1,CONNECT"));
+	std::shared_ptr<FakeConnection> peer = fakeNet::outgoing.back();
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPSTART=3,\"UDP\",\"192.168.1.20\",5000,5001,0\r\n"), "3,CONNECT"));
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPBINMODE=1\r\n"), "OK"));
+
+	// The stream in frames of at most 2040 bytes
+	std::string data(3000, 'x');
+	peer->rx.insert(peer->rx.end(), data.begin(), data.end());
+	std::vector<std::string> frames = binFrames(hostSend(""));
+	TEST_ASSERT_EQUAL(2, frames.size());
+	TEST_ASSERT_EQUAL_STRING("1,1,2040", frames[0].c_str());
+	TEST_ASSERT_EQUAL_STRING("1,1,960", frames[1].c_str());
+
+	// A datagram in one frame, a longer one is dropped
+	fakeNet::datagram(5001, IPAddress(192, 168, 1, 20), 5000, std::string(2100, 'y'));
+	fakeNet::datagram(5001, IPAddress(192, 168, 1, 20), 5000, std::string(100, 'z'));
+	frames = binFrames(hostSend(""));
+	TEST_ASSERT_EQUAL(1, frames.size());
+	TEST_ASSERT_EQUAL_STRING("3,1,100", frames[0].c_str());
+
+	// BIN_EXIT with its CRC
+	const char exitFrame[] = {'\xC0', 0, 0x7F, 0, 0, '\xF9', 0x70, '\xC0'};
+	frames = binFrames(hostSend(exitFrame, sizeof(exitFrame)));
+	TEST_ASSERT_EQUAL(1, frames.size());
+	TEST_ASSERT_EQUAL_STRING("0,127,0", frames[0].c_str());
+	TEST_ASSERT_EQUAL_STRING("\r\nOK\r\n", hostSend("AT\r\n").c_str());
+
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPCLOSE=1\r\n"), "1,CLOSED"));
+	TEST_ASSERT_TRUE(contains(hostSend("AT+CIPCLOSE=3\r\n"), "3,CLOSED"));
+}
+
+void test_serialtx_waits_for_space()
+{
+	std::string data(SERIAL_TX_BUFFER_SIZE, 'a');
+
+	// With the UART busy, a write to the full buffer waits only for its own space
+	Serial.fifoFree = 0;
+	SerialTx.write((const uint8_t *)data.data(), data.size());
+	TEST_ASSERT_EQUAL(SERIAL_TX_BUFFER_SIZE, SerialTx.pending());
+	SerialTx.write((const uint8_t *)data.data(), 100);
+	TEST_ASSERT_EQUAL(SERIAL_TX_BUFFER_SIZE, SerialTx.pending());
+	TEST_ASSERT_EQUAL(100, Serial.output().size());
+
+	Serial.fifoFree = 128;
+	SerialTx.flush();
+	TEST_ASSERT_EQUAL(0, SerialTx.pending());
+	Serial.output().clear();
+}
+
+int main()
+{
+	hostBegin();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_findCommand);
+	RUN_TEST(test_findCommand_rejects);
+	RUN_TEST(test_readNumber);
+	RUN_TEST(test_readIpAddress);
+	RUN_TEST(test_readStringFromBuffer);
+	RUN_TEST(test_readLinkId);
+	RUN_TEST(test_getCnFromDer);
+	RUN_TEST(test_loop_command);
+	RUN_TEST(test_loop_split_input);
+	RUN_TEST(test_loop_cipsend_and_ipd);
+	RUN_TEST(test_loop_sendbuf_fail);
+	RUN_TEST(test_loop_sendmulti_closed_target);
+	RUN_TEST(test_loop_recv_coalesce_per_link);
+	RUN_TEST(test_loop_binmode_frames);
+	RUN_TEST(test_serialtx_waits_for_space);
+
+	return UNITY_END();
+}
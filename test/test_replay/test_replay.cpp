@@ -0,0 +1,276 @@
+/*
+ * test_replay.cpp
+ *
+ * Part of ESP_ATMod: native benchmarks replaying recorded AT traffic
+ *
+ * Copyright 2020, Jiri Bilek, https://github.com/JiriBilek
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+
+#include <unity.h>
+
+#include "host.h"
+
+/*
+ * Note: the benchmarks print commands/s, bytes/s and allocations per operation. The time depends on
+ *       the host, the allocations do not, so they are checked against a budget.
+ *       The allocations of the fakes are counted as well, the buffers of the peer are reserved in advance.
+ */
+
+/*
+ * Recorded traffic of an HTTP client (WiFiEspAT library): the host lines, the data of the server
+ * and a part of the expected response
+ */
+
+enum stepType_t
+{
+	STEP_HOST, // From the host to the serial port
+	STEP_PEER  // From the server to the link 0
+};
+
+typedef struct
+{
+	stepType_t type;
+	const char *data;
+	const char *expected;
+} replayStep_t;
+
+static const replayStep_t HTTP_SESSION[] = {
+	{STEP_HOST, "AT+CIPSTATUS\r\n", "STATUS:"},
+	{STEP_HOST, "AT+CIPSTART=0,\"TCP\",\"api.example.com\",80\r\n", "0,CONNECT"},
+	{STEP_HOST, "AT+CIPSEND=0,44\r\n", ">"},
+	{STEP_HOST, "GET /get HTTP/1.1\r\nHost: api.example.com\r\n\r\n", "SEND OK"},
+	{STEP_PEER, "HTTP/1.1 200 OK\r\nContent-Length: 13\r\n\r\n", "+IPD,0,39:"},
+	{STEP_PEER, "{\"ok\": true}\n", "+IPD,0,13:"},
+	{STEP_HOST, "AT+CIPRECVLEN?\r\n", "OK"},
+	{STEP_HOST, "AT+CIPCLOSE=0\r\n", "0,CLOSED"},
+};
+
+// Status queries of a polling host
+static const char *const QUERY_LINES[] = {
+	"AT\r\n",
+	"AT+CIPSTATUS\r\n",
+	"AT+CIPMUX?\r\n",
+	"AT+CWMODE?\r\n",
+	"AT+CIPRECVMODE?\r\n",
+	"AT+CIFSR\r\n",
+};
+
+static const uint16_t CHUNK_SIZE = 1460; // One TCP segment
+
+/*
+ * Helpers
+ */
+
+typedef std::chrono::steady_clock benchClock;
+
+static double secondsSince(benchClock::time_point start)
+{
+	return std::chrono::duration<double>(benchClock::now() - start).count();
+}
+
+static void report(const char *name, uint32_t operations, double seconds, uint64_t bytes, uint32_t allocations)
+{
+	char message[160];
+
+	if (bytes > 0)
+		snprintf(message, sizeof(message), "%s: %u ops, %.0f ops/s, %.0f bytes/s, %.2f allocations/op", name,
+				 operations, operations / seconds, bytes / seconds, (double)allocations / operations);
+	else
+		snprintf(message, sizeof(message), "%s: %u ops, %.0f ops/s, %.2f allocations/op", name, operations,
+				 operations / seconds, (double)allocations / operations);
+
+	TEST_MESSAGE(message);
+}
+
+static std::shared_ptr<FakeConnection> connectLink0()
+{
+	hostSend("AT+CIPSTART=0,\"TCP\",\"192.168.1.10\",8080\r\n");
+
+	std::shared_ptr<FakeConnection> peer = fakeNet::outgoing.back();
+	peer->tx.reserve(CHUNK_SIZE);
+
+	return peer;
+}
+
+/*
+ * Tests
+ */
+
+void setUp()
+{
+	fakeNet::reset();
+	hostSend("AT+CIPMUX=1\r\n");
+}
+
+void tearDown()
+{
+	hostSend("AT+CIPCLOSE=5\r\n");
+}
+
+void test_replay_http_session()
+{
+	const uint32_t iterations = 200;
+	uint32_t lines = 0;
+	uint32_t allocations = 0;
+	benchClock::time_point start = benchClock::now();
+
+	for (uint32_t it = 0; it < iterations; ++it)
+	{
+		for (const replayStep_t &step : HTTP_SESSION)
+		{
+			if (step.type == STEP_HOST)
+			{
+				Serial.inject(step.data);
+			}
+			else
+			{
+				std::shared_ptr<FakeConnection> peer = fakeNet::outgoing.back();
+				peer->rx.insert(peer->rx.end(), step.data, step.data + strlen(step.data));
+			}
+
+			uint32_t before = fakeAllocations;
+
+			hostRun();
+			allocations += fakeAllocations - before;
+
+			std::string output = hostTakeOutput();
+
+			TEST_ASSERT_TRUE_MESSAGE(output.find(step.expected) != std::string::npos, step.expected);
+
+			++lines;
+		}
+
+		fakeNet::outgoing.clear();
+	}
+
+	report("replay", lines, secondsSince(start), 0, allocations);
+
+	// The connect allocates the client and its connection, the data path nothing
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32(6 * iterations, allocations);
+}
+
+void test_command_rate()
+{
+	const uint32_t iterations = 2000;
+	uint32_t lines = 0;
+	uint32_t allocations = 0;
+	benchClock::time_point start = benchClock::now();
+
+	for (uint32_t it = 0; it < iterations; ++it)
+	{
+		for (const char *line : QUERY_LINES)
+		{
+			Serial.inject(line);
+
+			uint32_t before = fakeAllocations;
+
+			hostRun();
+
+			allocations += fakeAllocations - before;
+
+			hostTakeOutput();
+			++lines;
+		}
+	}
+
+	report("commands", lines, secondsSince(start), 0, allocations);
+
+	// Only AT+CIFSR makes a String (the MAC address)
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32(iterations, allocations);
+}
+
+void test_cipsend_throughput()
+{
+	const uint32_t iterations = 500;
+	std::shared_ptr<FakeConnection> peer = connectLink0();
+	std::string header = "AT+CIPSEND=0," + std::to_string(CHUNK_SIZE) + "\r\n";
+	std::string payload(CHUNK_SIZE, 'x');
+	uint32_t allocations = 0;
+	benchClock::time_point start = benchClock::now();
+
+	for (uint32_t it = 0; it < iterations; ++it)
+	{
+		Serial.inject(header.data(), header.length());
+
+		uint32_t before = fakeAllocations;
+
+		hostRun();
+
+		allocations += fakeAllocations - before;
+
+		Serial.inject(payload.data(), payload.length());
+		before = fakeAllocations;
+
+		hostRun();
+
+		allocations += fakeAllocations - before;
+
+		TEST_ASSERT_TRUE(hostTakeOutput().find("SEND OK") != std::string::npos);
+		TEST_ASSERT_EQUAL(CHUNK_SIZE, peer->tx.length());
+		peer->tx.clear();
+	}
+
+	report("cipsend", iterations, secondsSince(start), (uint64_t)iterations * CHUNK_SIZE, allocations);
+
+	// The data are streamed without heap
+	TEST_ASSERT_EQUAL(0, allocations);
+}
+
+void test_ipd_throughput()
+{
+	const uint32_t iterations = 500;
+	std::shared_ptr<FakeConnection> peer = connectLink0();
+	std::string payload(CHUNK_SIZE, 'y');
+	std::string expected = "+IPD,0," + std::to_string(CHUNK_SIZE) + ":";
+	uint32_t allocations = 0;
+	benchClock::time_point start = benchClock::now();
+
+	for (uint32_t it = 0; it < iterations; ++it)
+	{
+		peer->rx.insert(peer->rx.end(), payload.begin(), payload.end());
+
+		uint32_t before = fakeAllocations;
+
+		hostRun();
+
+		allocations += fakeAllocations - before;
+
+		std::string output = hostTakeOutput();
+
+		TEST_ASSERT_TRUE(output.find(expected) != std::string::npos);
+		TEST_ASSERT_EQUAL(CHUNK_SIZE + expected.length() + 2, output.length());
+	}
+
+	report("ipd", iterations, secondsSince(start), (uint64_t)iterations * CHUNK_SIZE, allocations);
+
+	TEST_ASSERT_EQUAL(0, allocations);
+}
+
+int main()
+{
+	hostBegin();
+
+	UNITY_BEGIN();
+
+	RUN_TEST(test_replay_http_session);
+	RUN_TEST(test_command_rate);
+	RUN_TEST(test_cipsend_throughput);
+	RUN_TEST(test_ipd_throughput);
+
+	return UNITY_END();
+}